@@ -1,6 +1,9 @@
 #ifndef AABB_H
 #define AABB_H
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "Vec3.h"
 #include "Vec3SIMD.h"
 #include "Ray.h"
@@ -25,7 +28,9 @@ public:
                 std::swap(t0, t1);
             t_min = t0 > t_min ? t0 : t_min;
             t_max = t1 < t_max ? t1 : t_max;
-            if (t_max <= t_min)
+            // Equal is a hit: a triangle lying in an axis plane has min == max on that axis
+            // and a ray through it sees t_min == t_max
+            if (t_max < t_min)
                 return false;
         }
         return true;
@@ -45,4 +50,45 @@ private:
 
 AABB surrounding_box(const AABB& box0, const AABB& box1);
 
+// Slab test of a ray against float bounds. Like RayPacket::hitBox it accepts every
+// ray AABB::hit accepts: each slab distance is widened by 2^-20 of itself for the
+// float subtraction, inverse and product, and by the ray's origin slack for the
+// rounded origin
+inline bool hit_float_box(const float* min, const float* max, const FloatRay& r, float t_min, float t_max) {
+    constexpr float largest = std::numeric_limits<float>::max();
+    for (int a = 0; a < 3; a++) {
+        float t0 = (min[a] - r.origin[a]) * r.inv_direction[a];
+        float t1 = (max[a] - r.origin[a]) * r.inv_direction[a];
+        if (r.inv_direction[a] < 0.0f)
+            std::swap(t0, t1);
+        // Finite slack, so an infinite distance (axis-parallel ray) still decides the test
+        t0 -= std::min(std::fabs(t0), largest) * 0x1p-20f + r.origin_slack[a];
+        t1 += std::min(std::fabs(t1), largest) * 0x1p-20f + r.origin_slack[a];
+        // NaN distances (axis-parallel ray starting on a slab plane) fail both comparisons and are dropped
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+        if (t_max < t_min)
+            return false;
+    }
+    return true;
+}
+
+// Single precision AABB as BVH nodes store it. AABB bounds already pass through
+// Vec3SIMD, so the conversion loses nothing and the box takes half the space.
+struct FloatAABB {
+    float min[3];
+    float max[3];
+
+    FloatAABB() = default;
+    explicit FloatAABB(const AABB& box)
+        : min{ static_cast<float>(box.min.x), static_cast<float>(box.min.y), static_cast<float>(box.min.z) },
+        max{ static_cast<float>(box.max.x), static_cast<float>(box.max.y), static_cast<float>(box.max.z) } {}
+
+    AABB toAABB() const { return AABB(Vec3SIMD(min[0], min[1], min[2]), Vec3SIMD(max[0], max[1], max[2])); }
+
+    bool hit(const FloatRay& r, float t_min, float t_max) const {
+        return hit_float_box(min, max, r, t_min, t_max);
+    }
+};
+
 #endif // AABB_H
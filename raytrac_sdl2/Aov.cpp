@@ -0,0 +1,154 @@
+#include "Aov.h"
+#include <SDL.h>
+#include <SDL_image.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+const char* Aov::name(AovType type) {
+    switch (type) {
+    case AovType::Albedo: return "albedo";
+    case AovType::Normal: return "normal";
+    case AovType::Depth: return "depth";
+    case AovType::MaterialId: return "material_id";
+    case AovType::ObjectId: return "object_id";
+    case AovType::Direct: return "direct";
+    case AovType::Indirect: return "indirect";
+    case AovType::Emission: return "emission";
+    default: return "unknown";
+    }
+}
+
+int Aov::channels(AovType type) {
+    switch (type) {
+    case AovType::Depth:
+    case AovType::MaterialId:
+    case AovType::ObjectId:
+        return 1;
+    default:
+        return 3;
+    }
+}
+
+AovMask Aov::parseList(const std::string& list) {
+    AovMask mask = 0;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty()) continue;
+        if (item == "all") {
+            mask |= aovBit(AovType::Count) - 1;
+            continue;
+        }
+        bool found = false;
+        for (int t = 0; t < static_cast<int>(AovType::Count); ++t) {
+            if (item == name(static_cast<AovType>(t))) {
+                mask |= aovBit(static_cast<AovType>(t));
+                found = true;
+            }
+        }
+        if (!found) {
+            throw std::runtime_error("unknown AOV '" + item + "'");
+        }
+    }
+    return mask;
+}
+
+void Aov::read(const AovSample& sample, AovType type, float* dst) {
+    auto put = [dst](const Vec3& v) {
+        dst[0] = static_cast<float>(v.x);
+        dst[1] = static_cast<float>(v.y);
+        dst[2] = static_cast<float>(v.z);
+    };
+    switch (type) {
+    case AovType::Albedo: put(sample.albedo); break;
+    case AovType::Normal: put(sample.normal); break;
+    case AovType::Depth: dst[0] = sample.depth; break;
+    case AovType::MaterialId: dst[0] = static_cast<float>(sample.material_id); break;
+    case AovType::ObjectId: dst[0] = static_cast<float>(sample.object_id); break;
+    case AovType::Direct: put(sample.direct); break;
+    case AovType::Indirect: put(sample.indirect); break;
+    case AovType::Emission: put(sample.emission); break;
+    default: break;
+    }
+}
+
+std::string Aov::pathFor(const std::string& output, AovType type, const std::string& extension) {
+    std::filesystem::path path(output);
+    const std::string stem = path.stem().string();
+    return path.replace_filename(stem + "_" + name(type) + extension).string();
+}
+
+namespace {
+    Uint8 toByte(float v) {
+        return static_cast<Uint8>(255.0f * std::clamp(v, 0.0f, 1.0f));
+    }
+}
+
+void Aov::idColor(int id, uint8_t& r, uint8_t& g, uint8_t& b) {
+    if (id < 0) {
+        r = g = b = 0;
+        return;
+    }
+    uint32_t h = static_cast<uint32_t>(id) * 0x9E3779B1u;
+    h ^= h >> 15;
+    h *= 0x85EBCA77u;
+    h ^= h >> 13;
+    r = static_cast<uint8_t>(64 + (h & 0xBF));
+    g = static_cast<uint8_t>(64 + ((h >> 8) & 0xBF));
+    b = static_cast<uint8_t>(64 + ((h >> 16) & 0xBF));
+}
+
+bool Aov::writePreview(const std::vector<float>& values, AovType type, int width, int height, const std::string& filename) {
+    const int ch = channels(type);
+    if (values.size() != static_cast<size_t>(width) * height * ch) {
+        std::cerr << "AOV " << name(type) << ": buffer does not match the image size" << std::endl;
+        return false;
+    }
+
+    float depth_scale = 1.0f;
+    if (type == AovType::Depth) {
+        const float max_depth = values.empty() ? 0.0f : *std::max_element(values.begin(), values.end());
+        depth_scale = max_depth > 0.0f ? 1.0f / max_depth : 1.0f;
+    }
+
+    SDL_Surface* image = SDL_CreateRGBSurfaceWithFormat(0, width, height, 24, SDL_PIXELFORMAT_RGB24);
+    if (image == nullptr) {
+        std::cerr << "AOV " << name(type) << ": could not create surface: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_LockSurface(image);
+    for (int y = 0; y < height; ++y) {
+        Uint8* row = static_cast<Uint8*>(image->pixels) + y * image->pitch;
+        for (int x = 0; x < width; ++x) {
+            const float* v = &values[(static_cast<size_t>(y) * width + x) * ch];
+            Uint8* out = row + x * 3;
+            if (isId(type)) {
+                idColor(static_cast<int>(std::lround(v[0])), out[0], out[1], out[2]);
+            }
+            else if (type == AovType::Depth) {
+                out[0] = out[1] = out[2] = toByte(1.0f - v[0] * depth_scale);
+            }
+            else if (type == AovType::Normal) {
+                for (int c = 0; c < 3; ++c) out[c] = toByte(v[c] * 0.5f + 0.5f);
+            }
+            else {
+                // Lighting AOVs get the same sqrt display curve as the beauty image
+                for (int c = 0; c < 3; ++c) out[c] = toByte(std::sqrt(std::max(v[c], 0.0f)));
+            }
+        }
+    }
+    SDL_UnlockSurface(image);
+
+    const bool saved = IMG_SavePNG(image, filename.c_str()) == 0;
+    SDL_FreeSurface(image);
+    if (!saved) {
+        std::cerr << "AOV " << name(type) << ": failed to save " << filename << ": " << IMG_GetError() << std::endl;
+        return false;
+    }
+    std::cout << "AOV " << name(type) << " written to " << filename << std::endl;
+    return true;
+}
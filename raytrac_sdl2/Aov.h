@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Vec3.h"
+
+// Arbitrary output variables written next to the beauty image in the same pass.
+enum class AovType {
+    Albedo,      // first-hit reflectance (scatter attenuation)
+    Normal,      // first-hit shading normal, after normal mapping
+    Depth,       // first-hit ray distance
+    MaterialId,  // Material::material_id of the first hit, -1 for misses
+    ObjectId,    // index of the top-level scene object hit first, -1 for misses
+    Direct,      // light sampled directly at the first hit
+    Indirect,    // everything that arrived over later bounces
+    Emission,    // emission of the first hit surface
+    Count
+};
+
+// Bit set of requested AOVs, one bit per AovType
+using AovMask = uint32_t;
+
+inline AovMask aovBit(AovType type) { return AovMask(1) << static_cast<int>(type); }
+
+// Per-sample values reported by the integrator. Only filled when the caller passes
+// a non-null pointer, so renders without AOVs pay nothing for them.
+struct AovSample {
+    Vec3 albedo = Vec3(1.0, 1.0, 1.0);
+    Vec3 normal = Vec3(0.0, 0.0, 0.0);
+    float depth = 0.0f;
+    int material_id = -1;
+    int object_id = -1;
+    Vec3 direct = Vec3(0.0, 0.0, 0.0);
+    Vec3 indirect = Vec3(0.0, 0.0, 0.0);
+    Vec3 emission = Vec3(0.0, 0.0, 0.0);
+};
+
+class Aov {
+public:
+    static const char* name(AovType type);
+    static int channels(AovType type);
+    // Ids are not averaged: the buffer keeps the value of the last sample
+    static bool isId(AovType type) { return type == AovType::MaterialId || type == AovType::ObjectId; }
+
+    // "albedo,normal,depth" or "all"; throws std::runtime_error on unknown names
+    static AovMask parseList(const std::string& list);
+
+    // Copies the requested channels of one sample into dst (channels(type) floats)
+    static void read(const AovSample& sample, AovType type, float* dst);
+
+    // "render/output.png" -> "render/output_albedo.png"
+    static std::string pathFor(const std::string& output, AovType type, const std::string& extension = ".png");
+
+    // 8-bit preview of a resolved (averaged) AOV buffer: normals mapped to 0..1,
+    // depth normalized to its maximum, ids shown as distinct colors.
+    static bool writePreview(const std::vector<float>& values, AovType type, int width, int height, const std::string& filename);
+
+    // Integer hash -> bright, well separated color; black for negative (missing) ids
+    static void idColor(int id, uint8_t& r, uint8_t& g, uint8_t& b);
+};
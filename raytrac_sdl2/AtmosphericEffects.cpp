@@ -1,4 +1,5 @@
 #include "AtmosphericEffects.h"
+#include "TextureManager.h"
 #include <algorithm>
 #include <cmath>
 
@@ -12,7 +13,7 @@ AtmosphericEffects::AtmosphericEffects(
 
 void AtmosphericEffects::setFogTexture(const std::string& texture_path) {
     if (!texture_path.empty()) {
-        fog_texture.emplace(texture_path);
+        fog_texture = TextureManager::instance().load(texture_path);
     }
     else {
         fog_texture.reset();
@@ -21,7 +22,7 @@ void AtmosphericEffects::setFogTexture(const std::string& texture_path) {
 
 void AtmosphericEffects::setHazeTexture(const std::string& texture_path) {
     if (!texture_path.empty()) {
-        haze_texture.emplace(texture_path);
+        haze_texture = TextureManager::instance().load(texture_path);
     }
     else {
         haze_texture.reset();
@@ -30,8 +31,8 @@ void AtmosphericEffects::setHazeTexture(const std::string& texture_path) {
 
 void AtmosphericEffects::setBackgroundTexture(const std::string& texture_path) {
     if (!texture_path.empty()) {
-        background_texture = Texture(texture_path); // Dorudan atama
-        use_background_texture = true;
+        background_texture = TextureManager::instance().load(texture_path); // Paylalan texture
+        use_background_texture = background_texture != nullptr;
     }
     else {
         background_texture.reset(); // Bo deer
@@ -48,7 +49,7 @@ void AtmosphericEffects::setBackgroundColor(const Vec3SIMD& color) {
 }
 
 Vec3SIMD AtmosphericEffects::getBackgroundColor(float u, float v) const {
-    if (use_background_texture && background_texture.has_value()) {
+    if (use_background_texture && background_texture != nullptr) {
         return background_texture->get_color(u, v);
     }
     return background_color;
@@ -122,8 +123,8 @@ Vec3SIMD AtmosphericEffects::attenuateSegment(const Vec3SIMD& color, float start
     float avg_fog_factor = (start_fog_factor + end_fog_factor) * 0.5f;
     float avg_haze_factor = (start_haze_factor + end_haze_factor) * 0.5f;
 
-    Vec3 fog_contribution = fog_texture.has_value() ? fog_texture->get_color(0.5f, 0.5f) : Vec3(fog_color);
-    Vec3 haze_contribution = haze_texture.has_value() ? haze_texture->get_color(0.5f, 0.5f) : Vec3(haze_color);
+    Vec3 fog_contribution = fog_texture ? fog_texture->get_color(0.5f, 0.5f) : Vec3(fog_color);
+    Vec3 haze_contribution = haze_texture ? haze_texture->get_color(0.5f, 0.5f) : Vec3(haze_color);
 
     return color * (1.0f - avg_fog_factor) * (1.0f - avg_haze_factor) +
         fog_contribution * avg_fog_factor +
@@ -141,8 +142,8 @@ Vec3SIMD AtmosphericEffects::calculateSegmentContribution(float start_distance,
     float fog_contribution = end_fog_factor - start_fog_factor;
     float haze_contribution = end_haze_factor - start_haze_factor;
 
-    Vec3SIMD fog_color_contribution = fog_texture.has_value() ? fog_texture->get_color(0.5f, 0.5f) : Vec3(fog_color);
-    Vec3SIMD haze_color_contribution = haze_texture.has_value() ? haze_texture->get_color(0.5f, 0.5f) : Vec3(haze_color);
+    Vec3SIMD fog_color_contribution = fog_texture ? fog_texture->get_color(0.5f, 0.5f) : Vec3(fog_color);
+    Vec3SIMD haze_color_contribution = haze_texture ? haze_texture->get_color(0.5f, 0.5f) : Vec3(haze_color);
 
     return fog_color_contribution * fog_contribution + haze_color_contribution * haze_contribution;
 }
@@ -152,8 +153,8 @@ Vec3SIMD AtmosphericEffects::applyAtmosphericEffects(const Vec3SIMD& color, floa
     float fog_factor = calculateFogFactor(distance);
     float haze_factor = calculateHazeFactor(distance);
 
-    Vec3 fog_contribution = fog_texture.has_value() ? fog_texture->get_color(u, v) : fog_color;
-    Vec3 haze_contribution = haze_texture.has_value() ? haze_texture->get_color(u, v) : haze_color;
+    Vec3 fog_contribution = fog_texture ? fog_texture->get_color(u, v) : fog_color;
+    Vec3 haze_contribution = haze_texture ? haze_texture->get_color(u, v) : haze_color;
     Vec3 background_contribution = getBackgroundColor(u, v);
 
     Vec3SIMD result = color * (1.0f - fog_factor) * (1.0f - haze_factor) +
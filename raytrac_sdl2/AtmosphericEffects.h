@@ -2,7 +2,7 @@
 #include "Vec3SIMD.h"
 #include "Texture.h"
 #include <string>
-#include <optional>
+#include <memory>
 
 class AtmosphericEffects {
 private:
@@ -12,9 +12,9 @@ private:
     float haze_density;
     Vec3 fog_color;
     Vec3 haze_color;
-    std::optional<Texture> fog_texture;
-    std::optional<Texture> haze_texture;
-    std::optional<Texture> background_texture;
+    std::shared_ptr<Texture> fog_texture;
+    std::shared_ptr<Texture> haze_texture;
+    std::shared_ptr<Texture> background_texture;
     Vec3 background_color;
     //bool use_background_texture;
 
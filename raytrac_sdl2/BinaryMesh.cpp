@@ -0,0 +1,436 @@
+#include "BinaryMesh.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+    constexpr char MESH_MAGIC[8] = { 'R', 'T', 'M', 'E', 'S', 'H', '\0', '\0' };
+    constexpr uint64_t SECTION_ALIGNMENT = 16;
+    constexpr uint32_t BVH_LEAF_SIZE = 4;
+
+    // Unique per writer, so two jobs or two processes converting the same mesh never share a temp file
+    std::string tempPath(const std::string& filename) {
+        static const unsigned process_tag = std::random_device{}();
+        static std::atomic<uint64_t> counter{ 0 };
+        return filename + "." + std::to_string(process_tag) + "-" + std::to_string(counter.fetch_add(1)) + ".tmp";
+    }
+
+    uint64_t alignUp(uint64_t value) {
+        return (value + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    bool sectionFits(uint64_t offset, uint64_t bytes, uint64_t file_size) {
+        return offset % SECTION_ALIGNMENT == 0 && offset <= file_size && bytes <= file_size - offset;
+    }
+
+    // OBJ keeps separate position/uv/normal indices; the binary format has one index per unique combination
+    struct CornerKey {
+        int vertex, texCoord, normal;
+        bool operator==(const CornerKey& other) const {
+            return vertex == other.vertex && texCoord == other.texCoord && normal == other.normal;
+        }
+    };
+
+    struct CornerKeyHash {
+        size_t operator()(const CornerKey& key) const {
+            uint64_t h = static_cast<uint32_t>(key.vertex);
+            h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.texCoord);
+            h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.normal);
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+    bool indicesInRange(const uint32_t* indices, uint64_t index_count, uint64_t vertex_count) {
+        uint32_t largest = 0;
+        for (uint64_t i = 0; i < index_count; ++i) largest = std::max(largest, indices[i]);
+        return index_count == 0 || largest < vertex_count;
+    }
+
+    // Children must come after their parent, which also rules out cycles, and leaves must stay inside
+    // the triangle arrays. The depth limit keeps MappedMesh's fixed traversal stack from overflowing
+    bool bvhInRange(const MeshBVHNode* nodes, uint64_t node_count, uint64_t triangle_count) {
+        std::vector<std::pair<uint64_t, uint32_t>> stack{ { 0, 0 } };
+        while (!stack.empty()) {
+            const auto [index, depth] = stack.back();
+            stack.pop_back();
+            const MeshBVHNode& node = nodes[index];
+            if (node.is_leaf()) {
+                if (uint64_t(node.left_or_first) + node.count > triangle_count) return false;
+                continue;
+            }
+            const uint64_t left = node.left_or_first;
+            if (left <= index || left + 1 >= node_count || depth + 1 > BinaryMesh::MAX_BVH_DEPTH) return false;
+            stack.push_back({ left, depth + 1 });
+            stack.push_back({ left + 1, depth + 1 });
+        }
+        return true;
+    }
+
+    bool validIndex(int index, size_t count) {
+        return index >= 0 && static_cast<size_t>(index) < count;
+    }
+
+    template <typename T>
+    void writeSection(std::ofstream& out, uint64_t offset, const std::vector<T>& data) {
+        out.seekp(static_cast<std::streamoff>(offset));
+        if (!data.empty()) {
+            out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(T)));
+        }
+    }
+}
+
+std::shared_ptr<BinaryMesh> BinaryMesh::open(const std::string& filename) {
+    std::shared_ptr<BinaryMesh> mesh(new BinaryMesh());
+    mesh->source_filename = filename;
+    if (!mesh->file.open(filename)) {
+        std::cerr << "Could not open mesh file: " << filename << std::endl;
+        return nullptr;
+    }
+
+    const uint64_t size = mesh->file.size();
+    if (size < sizeof(MeshFileHeader)) {
+        std::cerr << "Mesh file is truncated: " << filename << std::endl;
+        return nullptr;
+    }
+
+    const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(mesh->file.data());
+    if (std::memcmp(header->magic, MESH_MAGIC, sizeof(MESH_MAGIC)) != 0 || header->version != VERSION) {
+        std::cerr << "Not a supported mesh file: " << filename << std::endl;
+        return nullptr;
+    }
+
+    const uint64_t vertices = header->vertex_count;
+    const uint64_t triangles = header->triangle_count;
+    const bool valid =
+        vertices <= UINT32_MAX && triangles <= UINT32_MAX &&
+        sectionFits(header->positions_offset, vertices * 3 * sizeof(float), size) &&
+        sectionFits(header->normals_offset, vertices * 3 * sizeof(float), size) &&
+        sectionFits(header->uvs_offset, vertices * 2 * sizeof(float), size) &&
+        sectionFits(header->indices_offset, triangles * 3 * sizeof(uint32_t), size) &&
+        sectionFits(header->material_ids_offset, triangles * sizeof(uint32_t), size) &&
+        sectionFits(header->smooth_groups_offset, triangles * sizeof(int32_t), size) &&
+        sectionFits(header->bvh_offset, header->bvh_node_count * sizeof(MeshBVHNode), size) &&
+        header->material_names_offset <= size && header->material_names_size <= size - header->material_names_offset;
+    if (!valid) {
+        std::cerr << "Mesh file has out of range sections: " << filename << std::endl;
+        return nullptr;
+    }
+    mesh->header = header;
+
+    // Checked once here so the traversal can follow indices and nodes without bounds checks
+    if (!indicesInRange(mesh->indices(), triangles * 3, vertices) ||
+        (mesh->hasBVH() && !bvhInRange(mesh->bvhNodes(), header->bvh_node_count, triangles))) {
+        std::cerr << "Mesh file has out of range indices or BVH nodes: " << filename << std::endl;
+        return nullptr;
+    }
+
+    // The name table is tiny, it is the only part that gets copied
+    const char* names = mesh->file.data() + header->material_names_offset;
+    const char* names_end = names + header->material_names_size;
+    while (names < names_end && mesh->material_names.size() < header->material_count) {
+        const char* terminator = static_cast<const char*>(std::memchr(names, '\0', names_end - names));
+        if (!terminator) break;
+        mesh->material_names.emplace_back(names, terminator);
+        names = terminator + 1;
+    }
+    mesh->material_names.resize(header->material_count);
+
+    return mesh;
+}
+
+void BinaryMesh::buildBVH(const float* positions, const uint32_t* indices, size_t triangle_count,
+    std::vector<MeshBVHNode>& nodes, std::vector<uint32_t>& order) {
+    nodes.clear();
+    order.resize(triangle_count);
+    if (triangle_count == 0) return;
+
+    std::vector<float> centroids(triangle_count * 3);
+    for (size_t i = 0; i < triangle_count; ++i) {
+        order[i] = static_cast<uint32_t>(i);
+        for (int axis = 0; axis < 3; ++axis) {
+            centroids[i * 3 + axis] = (positions[indices[i * 3] * 3 + axis] +
+                positions[indices[i * 3 + 1] * 3 + axis] +
+                positions[indices[i * 3 + 2] * 3 + axis]) / 3.0f;
+        }
+    }
+
+    nodes.reserve(2 * (triangle_count / BVH_LEAF_SIZE + 1));
+    nodes.push_back(MeshBVHNode{ {}, 0, {}, static_cast<uint32_t>(triangle_count) });
+
+    std::vector<uint32_t> stack{ 0 };
+    while (!stack.empty()) {
+        const uint32_t node_index = stack.back();
+        stack.pop_back();
+
+        const uint32_t first = nodes[node_index].left_or_first;
+        const uint32_t count = nodes[node_index].count;
+
+        float bmin[3] = { INFINITY, INFINITY, INFINITY };
+        float bmax[3] = { -INFINITY, -INFINITY, -INFINITY };
+        float cmin[3] = { INFINITY, INFINITY, INFINITY };
+        float cmax[3] = { -INFINITY, -INFINITY, -INFINITY };
+        for (uint32_t i = first; i < first + count; ++i) {
+            const uint32_t tri = order[i];
+            for (int corner = 0; corner < 3; ++corner) {
+                const float* p = positions + indices[tri * 3 + corner] * 3;
+                for (int axis = 0; axis < 3; ++axis) {
+                    bmin[axis] = std::min(bmin[axis], p[axis]);
+                    bmax[axis] = std::max(bmax[axis], p[axis]);
+                }
+            }
+            for (int axis = 0; axis < 3; ++axis) {
+                cmin[axis] = std::min(cmin[axis], centroids[tri * 3 + axis]);
+                cmax[axis] = std::max(cmax[axis], centroids[tri * 3 + axis]);
+            }
+        }
+
+        // Pad the box so flat meshes (planes) still have a non-empty slab in float precision
+        for (int axis = 0; axis < 3; ++axis) {
+            const float pad = 1e-5f * (1.0f + std::max(std::abs(bmin[axis]), std::abs(bmax[axis])));
+            nodes[node_index].bounds_min[axis] = bmin[axis] - pad;
+            nodes[node_index].bounds_max[axis] = bmax[axis] + pad;
+        }
+
+        int axis = 0;
+        for (int a = 1; a < 3; ++a) {
+            if (cmax[a] - cmin[a] > cmax[axis] - cmin[axis]) axis = a;
+        }
+        if (count <= BVH_LEAF_SIZE || cmax[axis] <= cmin[axis]) {
+            continue; // leaf
+        }
+
+        const uint32_t mid = first + count / 2;
+        std::nth_element(order.begin() + first, order.begin() + mid, order.begin() + first + count,
+            [&](uint32_t a, uint32_t b) { return centroids[a * 3 + axis] < centroids[b * 3 + axis]; });
+
+        const uint32_t left = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(MeshBVHNode{ {}, first, {}, mid - first });
+        nodes.push_back(MeshBVHNode{ {}, mid, {}, first + count - mid });
+        nodes[node_index].left_or_first = left;
+        nodes[node_index].count = 0;
+        stack.push_back(left + 1);
+        stack.push_back(left);
+    }
+}
+
+bool BinaryMesh::convert(const ObjLoader::ObjModel& model, const std::string& outFilename, bool build_bvh) {
+    MeshData data;
+    std::vector<float>& positions = data.positions;
+    std::vector<float>& normals = data.normals;
+    std::vector<float>& uvs = data.uvs;
+    std::vector<uint32_t>& indices = data.indices;
+    std::vector<uint32_t>& material_ids = data.material_ids;
+    std::vector<int32_t>& smooth_groups = data.smooth_groups;
+    std::vector<std::string>& names = data.material_names;
+
+    std::unordered_map<CornerKey, uint32_t, CornerKeyHash> corners;
+    std::unordered_map<std::string, uint32_t> material_lookup;
+
+    for (const auto& mesh : model.meshes) {
+        auto it = material_lookup.find(mesh->materialName);
+        if (it == material_lookup.end()) {
+            it = material_lookup.emplace(mesh->materialName, static_cast<uint32_t>(names.size())).first;
+            names.push_back(mesh->materialName);
+        }
+        const uint32_t material_id = it->second;
+
+        for (size_t t = 0; t < mesh->triangleCount(); ++t) {
+            const ObjLoader::ObjIndex* tri = &mesh->indices[t * 3];
+            if (!validIndex(tri[0].vertex, model.vertices.size()) ||
+                !validIndex(tri[1].vertex, model.vertices.size()) ||
+                !validIndex(tri[2].vertex, model.vertices.size())) {
+                continue;
+            }
+            // Same rule as ObjLoaderAdapter: a triangle either uses all three normals or the face normal
+            const bool has_normals = validIndex(tri[0].normal, model.normals.size()) &&
+                validIndex(tri[1].normal, model.normals.size()) &&
+                validIndex(tri[2].normal, model.normals.size());
+
+            for (int c = 0; c < 3; ++c) {
+                CornerKey key{ tri[c].vertex,
+                    validIndex(tri[c].texCoord, model.texCoords.size()) ? tri[c].texCoord : -1,
+                    has_normals ? tri[c].normal : -1 };
+                auto found = corners.find(key);
+                if (found == corners.end()) {
+                    const uint32_t index = static_cast<uint32_t>(positions.size() / 3);
+                    const auto& p = model.vertices[key.vertex];
+                    positions.insert(positions.end(), { p.x, p.y, p.z });
+                    if (key.normal >= 0) {
+                        const auto& n = model.normals[key.normal];
+                        normals.insert(normals.end(), { n.x, n.y, n.z });
+                    }
+                    else {
+                        normals.insert(normals.end(), { 0.0f, 0.0f, 0.0f });
+                    }
+                    if (key.texCoord >= 0) {
+                        const auto& uv = model.texCoords[key.texCoord];
+                        uvs.insert(uvs.end(), { uv.u, uv.v });
+                    }
+                    else {
+                        uvs.insert(uvs.end(), { 0.0f, 0.0f });
+                    }
+                    found = corners.emplace(key, index).first;
+                }
+                indices.push_back(found->second);
+            }
+            material_ids.push_back(material_id);
+            smooth_groups.push_back(mesh->smoothGroups[t]);
+        }
+    }
+    return write(data, outFilename, build_bvh);
+}
+
+bool BinaryMesh::write(MeshData& data, const std::string& outFilename, bool build_bvh, double* bvh_ms) {
+    std::vector<uint32_t>& indices = data.indices;
+    std::vector<uint32_t>& material_ids = data.material_ids;
+    std::vector<int32_t>& smooth_groups = data.smooth_groups;
+    const size_t vertex_count = data.positions.size() / 3;
+    const size_t triangle_count = indices.size() / 3;
+    if ((!data.normals.empty() && data.normals.size() != vertex_count * 3) ||
+        (!data.uvs.empty() && data.uvs.size() != vertex_count * 2) ||
+        (!material_ids.empty() && material_ids.size() != triangle_count) ||
+        (!smooth_groups.empty() && smooth_groups.size() != triangle_count)) {
+        std::cerr << "Inconsistent mesh data for " << outFilename << std::endl;
+        return false;
+    }
+
+    std::vector<MeshBVHNode> nodes;
+    if (build_bvh && triangle_count > 0) {
+        std::vector<uint32_t> order;
+        const auto bvh_start = std::chrono::steady_clock::now();
+        buildBVH(data.positions.data(), indices.data(), triangle_count, nodes, order);
+        if (bvh_ms) *bvh_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bvh_start).count();
+
+        // Store triangles in leaf order so leaves address contiguous ranges without an indirection
+        std::vector<uint32_t> sorted_indices(indices.size());
+        for (size_t i = 0; i < triangle_count; ++i) {
+            std::copy_n(&indices[static_cast<size_t>(order[i]) * 3], 3, &sorted_indices[i * 3]);
+        }
+        indices.swap(sorted_indices);
+        if (!material_ids.empty()) {
+            std::vector<uint32_t> sorted_materials(triangle_count);
+            for (size_t i = 0; i < triangle_count; ++i) sorted_materials[i] = material_ids[order[i]];
+            material_ids.swap(sorted_materials);
+        }
+        if (!smooth_groups.empty()) {
+            std::vector<int32_t> sorted_smooth(triangle_count);
+            for (size_t i = 0; i < triangle_count; ++i) sorted_smooth[i] = smooth_groups[order[i]];
+            smooth_groups.swap(sorted_smooth);
+        }
+    }
+
+    std::vector<std::string> names = data.material_names;
+    if (names.empty()) names.push_back("");
+    std::vector<char> name_table;
+    for (const auto& name : names) {
+        name_table.insert(name_table.end(), name.begin(), name.end());
+        name_table.push_back('\0');
+    }
+
+    MeshFileHeader header{};
+    std::memcpy(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC));
+    header.version = VERSION;
+    header.flags = nodes.empty() ? 0 : FLAG_HAS_BVH;
+    header.vertex_count = vertex_count;
+    header.triangle_count = triangle_count;
+    header.bvh_node_count = nodes.size();
+    header.material_count = names.size();
+
+    uint64_t offset = alignUp(sizeof(MeshFileHeader));
+    auto place = [&offset](uint64_t bytes) {
+        const uint64_t start = offset;
+        offset = alignUp(offset + bytes);
+        return start;
+    };
+    // Optional sections that were left empty are still reserved; the skipped bytes read back as zeros
+    header.positions_offset = place(vertex_count * 3 * sizeof(float));
+    header.normals_offset = place(vertex_count * 3 * sizeof(float));
+    header.uvs_offset = place(vertex_count * 2 * sizeof(float));
+    header.indices_offset = place(triangle_count * 3 * sizeof(uint32_t));
+    header.material_ids_offset = place(triangle_count * sizeof(uint32_t));
+    header.smooth_groups_offset = place(triangle_count * sizeof(int32_t));
+    header.bvh_offset = place(nodes.size() * sizeof(MeshBVHNode));
+    header.material_names_offset = place(name_table.size());
+    header.material_names_size = name_table.size();
+
+    // Write to a temporary name first so a crashed conversion never leaves a half-written cache behind
+    const std::string temp_filename = tempPath(outFilename);
+    {
+        std::ofstream out(temp_filename, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Could not create mesh file: " << outFilename << std::endl;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeSection(out, header.positions_offset, data.positions);
+        writeSection(out, header.normals_offset, data.normals);
+        writeSection(out, header.uvs_offset, data.uvs);
+        writeSection(out, header.indices_offset, indices);
+        writeSection(out, header.material_ids_offset, material_ids);
+        writeSection(out, header.smooth_groups_offset, smooth_groups);
+        writeSection(out, header.bvh_offset, nodes);
+        writeSection(out, header.material_names_offset, name_table);
+        // Pad the file to its aligned end so every section bound check holds
+        out.seekp(static_cast<std::streamoff>(offset - 1));
+        out.put('\0');
+        if (!out.good()) {
+            std::cerr << "Could not write mesh file: " << outFilename << std::endl;
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(temp_filename, error);
+            return false;
+        }
+    }
+
+    // Fails on Windows while another process has the old file mapped; the caller keeps its parsed data then
+    std::error_code error;
+    std::filesystem::rename(temp_filename, outFilename, error);
+    if (error) {
+        std::filesystem::remove(temp_filename, error);
+        std::cerr << "Could not replace mesh file: " << outFilename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool BinaryMesh::convertObj(const std::string& objFilename, const std::string& outFilename, bool build_bvh) {
+    ObjLoader::ObjModel model;
+    if (!ObjLoader::Loader::loadObj(objFilename, model)) {
+        std::cerr << "Failed to load OBJ file: " << objFilename << std::endl;
+        return false;
+    }
+    return convert(model, outFilename, build_bvh);
+}
+
+std::string BinaryMesh::cachePath(const std::string& sourceFilename, const std::string& cacheDirectory) {
+    std::filesystem::path source(sourceFilename);
+    if (cacheDirectory.empty()) {
+        return source.replace_extension(".rtmesh").string();
+    }
+    // Meshes with the same file name in different asset folders must not share a cache entry
+    std::error_code error;
+    std::filesystem::path absolute = std::filesystem::absolute(source, error);
+    if (error) absolute = source;
+    std::ostringstream name;
+    name << source.stem().string() << "-" << std::hex << std::setw(16) << std::setfill('0')
+        << std::hash<std::string>{}(absolute.lexically_normal().generic_string()) << ".rtmesh";
+    return (std::filesystem::path(cacheDirectory) / name.str()).string();
+}
+
+bool BinaryMesh::isCacheFresh(const std::string& sourceFilename, const std::string& cacheFilename) {
+    std::error_code error;
+    const auto cache_time = std::filesystem::last_write_time(cacheFilename, error);
+    if (error) return false;
+    const auto source_time = std::filesystem::last_write_time(sourceFilename, error);
+    if (error) return true; // only the cache was shipped
+    return cache_time >= source_time;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "ObjLoader.h"
+
+// Compact binary mesh format (.rtmesh).
+// Every section is a flat little-endian array aligned to 16 bytes, so the file
+// is used straight out of the memory mapping: loading costs one mmap and the
+// pages are faulted in on first access.
+//
+// Layout: MeshFileHeader, then the sections referenced by the header offsets:
+//   positions      float[3] * vertex_count
+//   normals        float[3] * vertex_count (zero vector = no normal, use the face normal)
+//   uvs            float[2] * vertex_count
+//   indices        uint32[3] * triangle_count
+//   material ids   uint32 * triangle_count
+//   smooth groups  int32 * triangle_count
+//   bvh nodes      MeshBVHNode * bvh_node_count (optional, triangles are stored in leaf order)
+//   material names null-terminated strings, one per material id
+
+struct MeshFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t vertex_count;
+    uint64_t triangle_count;
+    uint64_t bvh_node_count;
+    uint64_t material_count;
+    uint64_t positions_offset;
+    uint64_t normals_offset;
+    uint64_t uvs_offset;
+    uint64_t indices_offset;
+    uint64_t material_ids_offset;
+    uint64_t smooth_groups_offset;
+    uint64_t bvh_offset;
+    uint64_t material_names_offset;
+    uint64_t material_names_size;
+};
+
+// 32-byte flattened BVH node. Interior nodes (count == 0) keep their two
+// children next to each other starting at left_or_first; leaves reference
+// `count` consecutive triangles starting at left_or_first.
+struct MeshBVHNode {
+    float bounds_min[3];
+    uint32_t left_or_first;
+    float bounds_max[3];
+    uint32_t count;
+
+    bool is_leaf() const { return count > 0; }
+};
+
+// Flat mesh arrays accepted by BinaryMesh::write. Optional arrays may be left
+// empty: missing normals fall back to face normals, missing material ids and
+// smooth groups read as 0.
+struct MeshData {
+    std::vector<float> positions;       // xyz per vertex
+    std::vector<float> normals;         // xyz per vertex, optional
+    std::vector<float> uvs;             // uv per vertex, optional
+    std::vector<uint32_t> indices;      // 3 per triangle
+    std::vector<uint32_t> material_ids; // 1 per triangle, optional
+    std::vector<int32_t> smooth_groups; // 1 per triangle, optional
+    std::vector<std::string> material_names;
+};
+
+class BinaryMesh {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t FLAG_HAS_BVH = 1;
+    // Deepest BVH node open() accepts (the root is depth 0); MappedMesh sizes its traversal stack from it
+    static constexpr uint32_t MAX_BVH_DEPTH = 63;
+
+    // Maps the file and validates the header, index buffer and BVH; returns nullptr on failure.
+    static std::shared_ptr<BinaryMesh> open(const std::string& filename);
+
+    // Writes an already parsed OBJ model. Triangles are reordered into BVH leaf order when build_bvh is set.
+    static bool convert(const ObjLoader::ObjModel& model, const std::string& outFilename, bool build_bvh = true);
+    // Writes flat arrays directly, e.g. procedurally generated geometry. Reorders data in place when build_bvh is set;
+    // bvh_ms receives the BVH build time when given.
+    static bool write(MeshData& data, const std::string& outFilename, bool build_bvh = true, double* bvh_ms = nullptr);
+    static bool convertObj(const std::string& objFilename, const std::string& outFilename, bool build_bvh = true);
+
+    // "obj/kure.obj" -> "obj/kure.rtmesh" next to the source, or "<cacheDirectory>/kure-<path hash>.rtmesh"
+    static std::string cachePath(const std::string& sourceFilename, const std::string& cacheDirectory = "");
+    // True when the cache exists and is not older than the source file.
+    static bool isCacheFresh(const std::string& sourceFilename, const std::string& cacheFilename);
+
+    // Median-split BVH over triangle centroids. `order` receives the triangle permutation in leaf order.
+    static void buildBVH(const float* positions, const uint32_t* indices, size_t triangle_count,
+        std::vector<MeshBVHNode>& nodes, std::vector<uint32_t>& order);
+
+    size_t vertexCount() const { return static_cast<size_t>(header->vertex_count); }
+    size_t triangleCount() const { return static_cast<size_t>(header->triangle_count); }
+    size_t bvhNodeCount() const { return static_cast<size_t>(header->bvh_node_count); }
+    bool hasBVH() const { return (header->flags & FLAG_HAS_BVH) != 0 && header->bvh_node_count > 0; }
+
+    const float* positions() const { return section<float>(header->positions_offset); }
+    const float* normals() const { return section<float>(header->normals_offset); }
+    const float* uvs() const { return section<float>(header->uvs_offset); }
+    const uint32_t* indices() const { return section<uint32_t>(header->indices_offset); }
+    const uint32_t* materialIds() const { return section<uint32_t>(header->material_ids_offset); }
+    const int32_t* smoothGroups() const { return section<int32_t>(header->smooth_groups_offset); }
+    const MeshBVHNode* bvhNodes() const { return section<MeshBVHNode>(header->bvh_offset); }
+    const std::vector<std::string>& materialNames() const { return material_names; }
+
+    const std::string& filename() const { return source_filename; }
+
+private:
+    BinaryMesh() = default;
+
+    template <typename T>
+    const T* section(uint64_t offset) const {
+        return reinterpret_cast<const T*>(file.data() + offset);
+    }
+
+    MappedFile file;
+    const MeshFileHeader* header = nullptr;
+    std::vector<std::string> material_names;
+    std::string source_filename;
+};
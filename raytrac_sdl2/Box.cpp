@@ -63,6 +63,7 @@ bool Box::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const {
         else if (std::abs(relative_pos.z) > size / 2 - epsilon)
             outward_normal.z = relative_pos.z > 0 ? 1 : -1;
 
+        rec.face_normal = outward_normal;
         rec.set_face_normal(r, outward_normal);
         rec.material = material;
         return true;
@@ -0,0 +1,81 @@
+#include "CostHeatmap.h"
+#include <SDL.h>
+#include <SDL_image.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    // Polynomial fit of the Turbo colormap: dark blue (cheap) -> green -> dark red (expensive)
+    void turbo(float x, Uint8& r, Uint8& g, Uint8& b) {
+        x = std::clamp(x, 0.0f, 1.0f);
+        const float x2 = x * x, x3 = x2 * x, x4 = x3 * x, x5 = x4 * x;
+        const float fr = 0.13572138f + 4.61539260f * x - 42.66032258f * x2 + 132.13108234f * x3 - 152.94239396f * x4 + 59.28637943f * x5;
+        const float fg = 0.09140261f + 2.19418839f * x + 4.84296658f * x2 - 14.18503333f * x3 + 4.27729857f * x4 + 2.82956604f * x5;
+        const float fb = 0.10667330f + 12.64194608f * x - 60.58204836f * x2 + 110.36276771f * x3 - 89.90310912f * x4 + 27.34824973f * x5;
+        r = static_cast<Uint8>(255.0f * std::clamp(fr, 0.0f, 1.0f));
+        g = static_cast<Uint8>(255.0f * std::clamp(fg, 0.0f, 1.0f));
+        b = static_cast<Uint8>(255.0f * std::clamp(fb, 0.0f, 1.0f));
+    }
+}
+
+CostMetric CostHeatmap::parseMetric(const std::string& name) {
+    if (name == "time") return CostMetric::Time;
+    if (name == "traversal") return CostMetric::Traversal;
+    return CostMetric::None;
+}
+
+const char* CostHeatmap::metricName(CostMetric metric) {
+    switch (metric) {
+    case CostMetric::Time: return "time";
+    case CostMetric::Traversal: return "traversal";
+    default: return "none";
+    }
+}
+
+std::string CostHeatmap::pathFor(const std::string& output) {
+    std::filesystem::path path(output);
+    const std::string stem = path.stem().string();
+    return path.replace_filename(stem + "_cost.png").string();
+}
+
+bool CostHeatmap::write(const std::vector<float>& cost, int width, int height, const std::string& filename) {
+    if (cost.size() != static_cast<size_t>(width) * height || cost.empty()) {
+        std::cerr << "Cost heatmap: buffer does not match the image size" << std::endl;
+        return false;
+    }
+
+    std::vector<float> sorted(cost);
+    const size_t p99_index = std::min(sorted.size() - 1, sorted.size() * 99 / 100);
+    std::nth_element(sorted.begin(), sorted.begin() + p99_index, sorted.end());
+    const float p99 = sorted[p99_index];
+    const float max_cost = *std::max_element(cost.begin(), cost.end());
+    double sum = 0.0;
+    for (float c : cost) sum += c;
+    const float scale = p99 > 0.0f ? 1.0f / p99 : (max_cost > 0.0f ? 1.0f / max_cost : 0.0f);
+
+    SDL_Surface* image = SDL_CreateRGBSurfaceWithFormat(0, width, height, 24, SDL_PIXELFORMAT_RGB24);
+    if (image == nullptr) {
+        std::cerr << "Cost heatmap: could not create surface: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_LockSurface(image);
+    for (int y = 0; y < height; ++y) {
+        Uint8* row = static_cast<Uint8*>(image->pixels) + y * image->pitch;
+        for (int x = 0; x < width; ++x) {
+            turbo(cost[static_cast<size_t>(y) * width + x] * scale, row[x * 3 + 0], row[x * 3 + 1], row[x * 3 + 2]);
+        }
+    }
+    SDL_UnlockSurface(image);
+
+    const bool saved = IMG_SavePNG(image, filename.c_str()) == 0;
+    SDL_FreeSurface(image);
+    if (!saved) {
+        std::cerr << "Cost heatmap: failed to save " << filename << ": " << IMG_GetError() << std::endl;
+        return false;
+    }
+    std::cout << "Cost heatmap written to " << filename << " (mean " << sum / cost.size()
+        << ", p99 " << p99 << ", max " << max_cost << ")" << std::endl;
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Per-pixel render cost AOV.
+// Time measures wall time spent on the pixel, Traversal counts BVH node visits
+// plus primitive tests (needs the RayStats counters, see RayStats.h).
+enum class CostMetric { None, Time, Traversal };
+
+class CostHeatmap {
+public:
+    // "time" | "traversal"; anything else disables the heatmap
+    static CostMetric parseMetric(const std::string& name);
+    static const char* metricName(CostMetric metric);
+
+    // "render/output.png" -> "render/output_cost.png"
+    static std::string pathFor(const std::string& output);
+
+    // Writes cost (row-major, top row first) as a false-color PNG.
+    // Colors are normalized to the 99th percentile so a few outliers do not flatten the image.
+    static bool write(const std::vector<float>& cost, int width, int height, const std::string& filename);
+};
@@ -0,0 +1,136 @@
+#include "Denoiser.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "Profiler.h"
+
+namespace {
+    // Working copy of the film in float, one entry per pixel
+    struct Pixel {
+        float r, g, b;
+        float variance;
+    };
+
+    struct Guide {
+        float nx, ny, nz;
+        float depth;
+        bool hit;
+    };
+
+    // Runs fn(y) for every row, split over the hardware threads
+    template <typename Fn>
+    void parallelRows(int height, Fn fn) {
+        const int num_threads = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), height));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([=, &fn]() {
+                for (int y = t; y < height; y += num_threads) fn(y);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    }
+
+    float luminance(const Pixel& p) {
+        return 0.2126f * p.r + 0.7152f * p.g + 0.0722f * p.b;
+    }
+
+    constexpr float kKernel[5] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+}
+
+void Denoiser::denoise(const Film& film, std::vector<Vec3>& output, const DenoiseSettings& settings) {
+    PROFILE_SCOPE_CAT("denoise", "post");
+    const int width = film.width;
+    const int height = film.height;
+    const size_t count = static_cast<size_t>(width) * height;
+    output.resize(count);
+    if ((film.aov_mask & guideAovs()) != guideAovs() || film.samples == 0) {
+        for (size_t i = 0; i < count; ++i) output[i] = film.meanColor(i);
+        return;
+    }
+
+    // Demodulate albedo so the filter only sees illumination
+    std::vector<Pixel> current(count), next(count);
+    std::vector<Vec3> albedo(count);
+    std::vector<Guide> guides(count);
+    for (size_t i = 0; i < count; ++i) {
+        Vec3 a = film.meanAov3(AovType::Albedo, i);
+        a = Vec3(a.x < 1e-3 ? 1.0 : a.x, a.y < 1e-3 ? 1.0 : a.y, a.z < 1e-3 ? 1.0 : a.z);
+        albedo[i] = a;
+        const Vec3 c = film.meanColor(i);
+        const float albedo_luminance = std::max(Film::luminanceOf(a), 1e-3f);
+        current[i] = { static_cast<float>(c.x / a.x), static_cast<float>(c.y / a.y), static_cast<float>(c.z / a.z),
+            film.meanVariance(i) / (albedo_luminance * albedo_luminance) };
+
+        const Vec3 n = film.meanAov3(AovType::Normal, i);
+        const float length = static_cast<float>(n.length());
+        Guide& g = guides[i];
+        g.hit = length > 1e-3f;
+        g.nx = g.hit ? static_cast<float>(n.x) / length : 0.0f;
+        g.ny = g.hit ? static_cast<float>(n.y) / length : 0.0f;
+        g.nz = g.hit ? static_cast<float>(n.z) / length : 0.0f;
+        g.depth = film.meanAov1(AovType::Depth, i);
+    }
+
+    for (int level = 0; level < settings.iterations; ++level) {
+        const int step = 1 << level;
+        parallelRows(height, [&](int y) {
+            for (int x = 0; x < width; ++x) {
+                const size_t p = static_cast<size_t>(y) * width + x;
+                const Pixel& center = current[p];
+                const Guide& gp = guides[p];
+                const float lum_p = luminance(center);
+
+                // 3x3 blurred variance keeps the luminance edge stop from reacting to its own noise
+                float blurred_variance = 0.0f, variance_weight = 0.0f;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        const int qx = x + dx, qy = y + dy;
+                        if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+                        const float k = kKernel[dx + 2] * kKernel[dy + 2];
+                        blurred_variance += k * current[static_cast<size_t>(qy) * width + qx].variance;
+                        variance_weight += k;
+                    }
+                }
+                const float luminance_scale = settings.sigma_luminance * std::sqrt(std::max(blurred_variance / variance_weight, 0.0f)) + 1e-4f;
+                const float depth_scale = settings.sigma_depth * step * std::max(gp.depth, 1e-3f) + 1e-4f;
+
+                float sum_r = 0.0f, sum_g = 0.0f, sum_b = 0.0f, sum_var = 0.0f, sum_w = 0.0f;
+                for (int ky = -2; ky <= 2; ++ky) {
+                    const int qy = y + ky * step;
+                    if (qy < 0 || qy >= height) continue;
+                    for (int kx = -2; kx <= 2; ++kx) {
+                        const int qx = x + kx * step;
+                        if (qx < 0 || qx >= width) continue;
+                        const size_t q = static_cast<size_t>(qy) * width + qx;
+                        const Pixel& sample = current[q];
+                        const Guide& gq = guides[q];
+
+                        float w = kKernel[kx + 2] * kKernel[ky + 2];
+                        if (q != p) {
+                            if (gp.hit != gq.hit) continue;
+                            if (gp.hit) {
+                                const float n_dot = std::max(0.0f, gp.nx * gq.nx + gp.ny * gq.ny + gp.nz * gq.nz);
+                                w *= std::pow(n_dot, settings.sigma_normal);
+                                w *= std::exp(-std::fabs(gp.depth - gq.depth) / depth_scale);
+                            }
+                            w *= std::exp(-std::fabs(lum_p - luminance(sample)) / luminance_scale);
+                        }
+                        sum_r += w * sample.r;
+                        sum_g += w * sample.g;
+                        sum_b += w * sample.b;
+                        sum_var += w * w * sample.variance;
+                        sum_w += w;
+                    }
+                }
+                // The center tap always contributes, so sum_w > 0
+                next[p] = { sum_r / sum_w, sum_g / sum_w, sum_b / sum_w, sum_var / (sum_w * sum_w) };
+            }
+        });
+        current.swap(next);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const Vec3& a = albedo[i];
+        output[i] = Vec3(current[i].r * a.x, current[i].g * a.y, current[i].b * a.z);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include "Film.h"
+
+struct DenoiseSettings {
+    int iterations = 5;             // à-trous levels, step 1, 2, 4, ... pixels
+    float sigma_luminance = 4.0f;   // luminance edge stop, in standard deviations of the pixel noise
+    float sigma_normal = 16.0f;     // exponent on dot(n_p, n_q)
+    float sigma_depth = 0.02f;      // relative depth difference tolerated per pixel of step
+};
+
+// Edge-aware à-trous wavelet filter (in the spirit of SVGF) for low sample count renders.
+//
+// The film mean is divided by the first-hit albedo so textures are not blurred,
+// filtered with a 5x5 B3-spline kernel whose weights are cut by luminance
+// (relative to the per-pixel variance estimate), normal and depth differences,
+// and multiplied back by the albedo. The variance is filtered alongside the color,
+// so every level smooths less where the image has already converged.
+class Denoiser {
+public:
+    // AOVs the film has to carry for the guided filter
+    static AovMask guideAovs() { return aovBit(AovType::Albedo) | aovBit(AovType::Normal) | aovBit(AovType::Depth); }
+
+    // Writes the denoised linear image (row-major, top row first) to output.
+    // Falls back to the plain film mean when the film has no albedo, normal and depth AOVs.
+    static void denoise(const Film& film, std::vector<Vec3>& output, const DenoiseSettings& settings = DenoiseSettings());
+};
@@ -2,6 +2,7 @@
 #include "Ray.h"
 #include "Hittable.h"
 #include <cmath>
+#include "FastMath.h"
 
 Dielectric::Dielectric(double index_of_refraction, const Vec3& color, double caustic_intensity,
     double thickness, double tint_factor, double scratch_density)
@@ -46,12 +47,37 @@ bool Dielectric::scatter(const Ray& r_in, const HitRecord& rec, Vec3& attenuatio
     return true;
 }
 
+Vec3 Dielectric::shadow_transmittance(const HitRecord& rec, Vec3& direction, bool thin) const {
+    const Vec3 unit_direction = direction.normalize();
+    const Vec3 normal = Vec3::dot(unit_direction, rec.normal) > 0.0 ? -rec.normal : rec.normal;
+    const double cos_theta = fmin(-Vec3::dot(unit_direction, normal), 1.0);
+    // A thin pane never bends the ray, so both faces see it at the angle it had outside the glass:
+    // the outside ratio and Fresnel term apply to a back-face hit too, and it never reflects totally
+    const double refraction_ratio = (thin || rec.front_face) ? (1.0 / ir) : ir;
+    const double sin2_t = fmin(refraction_ratio * refraction_ratio * (1.0 - cos_theta * cos_theta), 1.0);
+    if (!thin && sin2_t >= 1.0) {
+        return Vec3(0.0, 0.0, 0.0);  // Total internal reflection, nothing gets through
+    }
+
+    // The tint is the transmittance of one pane thickness at normal incidence.
+    // A slanted ray travels thickness / cos_t inside the glass.
+    const double path = 1.0 / sqrt(fmax(1.0 - sin2_t, 1e-6));
+    const Vec3 tint = apply_scratches(apply_tint(color), rec.point).clamp(0.0, 1.0);
+    const Vec3 absorbed(pow(tint.x, path), pow(tint.y, path), pow(tint.z, path));
+
+    if (!thin) {
+        direction = Vec3::refract(unit_direction, normal, refraction_ratio);
+    }
+    return absorbed * (1.0 - reflectance(cos_theta, refraction_ratio));
+}
+
 double Dielectric::getIndexOfRefraction() const {
     return ir;
 }
 
 double Dielectric::calculate_caustic_factor(double cos_theta, double refraction_ratio, bool is_reflected) const {
-    double base_factor = pow(1.0 - cos_theta, 3) * caustic_intensity;
+    const double one_minus_cos = 1.0 - cos_theta;
+    double base_factor = one_minus_cos * one_minus_cos * one_minus_cos * caustic_intensity;
     if (is_reflected) {
         return base_factor * 0.5;  // Reflected light produces less intense caustics
     }
@@ -77,5 +103,5 @@ double Dielectric::reflectance(double cosine, double ref_idx) {
     // Use Schlick's approximation for reflectance
     auto r0 = (1 - ref_idx) / (1 + ref_idx);
     r0 = r0 * r0;
-    return r0 + (1 - r0) * pow((1 - cosine), 5);
+    return r0 + (1 - r0) * fastmath::pow5(1 - cosine);
 }
\ No newline at end of file
@@ -16,6 +16,8 @@ public:
     virtual Vec3 emitted(double u, double v, const Vec3& p) const override;
 
     virtual bool scatter(const Ray& r_in, const HitRecord& rec, Vec3& attenuation, Ray& scattered) const override;
+    // Fresnel transmission times the tint, Beer-Lambert scaled for the slant path through the pane
+    virtual Vec3 shadow_transmittance(const HitRecord& rec, Vec3& direction, bool thin) const override;
     double getIndexOfRefraction() const;
 
 private:
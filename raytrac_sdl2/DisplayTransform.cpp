@@ -0,0 +1,127 @@
+#include "DisplayTransform.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "Profiler.h"
+
+namespace {
+    // Curves that end in the sRGB transfer function are encoded through this table
+    constexpr int kLutSize = 16384;
+
+    const uint8_t* srgbTable() {
+        static const std::vector<uint8_t> table = [] {
+            std::vector<uint8_t> t(kLutSize);
+            for (int i = 0; i < kLutSize; ++i) {
+                const double v = static_cast<double>(i) / (kLutSize - 1);
+                const double encoded = v <= 0.0031308 ? 12.92 * v : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055;
+                t[i] = static_cast<uint8_t>(256 * clamp(encoded, 0.0, 0.999));
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    // Narkowicz's rational fit of the ACES RRT+ODT curve, in [0, 1] for x >= 0
+    inline __m128 acesFilmic(__m128 x) {
+        const __m128 num = _mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.51f)), _mm_set1_ps(0.03f)));
+        const __m128 den = _mm_add_ps(_mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.43f)), _mm_set1_ps(0.59f))), _mm_set1_ps(0.14f));
+        return _mm_div_ps(num, den);
+    }
+
+    // values -> byte (Gamma, Linear) or sRGB table index (the rest), n is a multiple of 4
+    void encode(const float* values, int32_t* codes, size_t n, ToneMapper tonemap) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 byte_max = _mm_set1_ps(0.999f);
+        const __m128 byte_scale = _mm_set1_ps(256.0f);
+        const __m128 lut_scale = _mm_set1_ps(static_cast<float>(kLutSize - 1));
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 huge = _mm_set1_ps(1e6f); // keeps inf out of the x / (1 + x) style curves
+        for (size_t i = 0; i < n; i += 4) {
+            // maxps returns its second operand for NaN, so NaN becomes 0
+            __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(values + i), zero), huge);
+            __m128i code;
+            switch (tonemap) {
+            case ToneMapper::Gamma:
+                v = _mm_sqrt_ps(v);
+                code = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(v, byte_max), byte_scale));
+                break;
+            case ToneMapper::Linear:
+                code = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(v, byte_max), byte_scale));
+                break;
+            case ToneMapper::Reinhard:
+                v = _mm_div_ps(v, _mm_add_ps(v, one));
+                code = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, lut_scale), half));
+                break;
+            case ToneMapper::Aces:
+                v = _mm_min_ps(acesFilmic(v), one);
+                code = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, lut_scale), half));
+                break;
+            case ToneMapper::Srgb:
+            default:
+                v = _mm_min_ps(v, one);
+                code = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, lut_scale), half));
+                break;
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(codes + i), code);
+        }
+    }
+}
+
+ToneMapper DisplayTransform::parse(const std::string& name) {
+    if (name == "gamma") return ToneMapper::Gamma;
+    if (name == "linear") return ToneMapper::Linear;
+    if (name == "srgb") return ToneMapper::Srgb;
+    if (name == "reinhard") return ToneMapper::Reinhard;
+    if (name == "aces") return ToneMapper::Aces;
+    throw std::runtime_error("unknown tonemap '" + name + "' (expected gamma, linear, srgb, reinhard or aces)");
+}
+
+const char* DisplayTransform::name(ToneMapper tonemap) {
+    switch (tonemap) {
+    case ToneMapper::Gamma: return "gamma";
+    case ToneMapper::Linear: return "linear";
+    case ToneMapper::Srgb: return "srgb";
+    case ToneMapper::Reinhard: return "reinhard";
+    case ToneMapper::Aces: return "aces";
+    }
+    return "gamma";
+}
+
+void DisplayTransform::resolve(const Vec3* colors, double scale, int width, int height,
+    SDL_Surface* surface, const DisplaySettings& settings) {
+    PROFILE_SCOPE_CAT("display_resolve", "post");
+    static_assert(sizeof(Vec3) == 3 * sizeof(double), "resolve reads Vec3 rows as packed doubles");
+    const bool uses_table = settings.tonemap != ToneMapper::Gamma && settings.tonemap != ToneMapper::Linear;
+    const uint8_t* table = uses_table ? srgbTable() : nullptr;
+    const float multiplier = static_cast<float>(scale * std::exp2(static_cast<double>(settings.exposure)));
+
+    // One row of interleaved RGB, padded to whole SSE registers
+    const size_t row_values = static_cast<size_t>(width) * 3;
+    const size_t padded = (row_values + 3) & ~static_cast<size_t>(3);
+    std::vector<float> values(padded, 0.0f);
+    std::vector<int32_t> codes(padded);
+
+    // Like the rest of the renderer this assumes a 32-bit surface (window surface or ARGB8888)
+    const SDL_PixelFormat* format = surface->format;
+    for (int y = 0; y < height; ++y) {
+        const double* src = &colors[static_cast<size_t>(y) * width].x;
+        for (size_t k = 0; k < row_values; ++k) {
+            values[k] = static_cast<float>(src[k]) * multiplier;
+        }
+        encode(values.data(), codes.data(), padded, settings.tonemap);
+        if (table) {
+            for (size_t k = 0; k < row_values; ++k) codes[k] = table[codes[k]];
+        }
+
+        Uint32* row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+        for (int x = 0; x < width; ++x) {
+            const int32_t* c = &codes[static_cast<size_t>(x) * 3];
+            row[x] = (static_cast<Uint32>(c[0]) << format->Rshift) | (static_cast<Uint32>(c[1]) << format->Gshift) |
+                (static_cast<Uint32>(c[2]) << format->Bshift) | format->Amask;
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <SDL.h>
+#include <string>
+#include "Vec3.h"
+
+// Linear radiance -> 8-bit display values. Runs as a separate resolve stage
+// after a pass (or when an image is saved), never inside the shading threads,
+// so the film itself always stays linear.
+//
+// Gamma is the original sqrt (gamma 2.0) mapping and remains the default.
+// Reinhard and ACES compress highlights before the sRGB transfer curve.
+enum class ToneMapper { Gamma, Linear, Srgb, Reinhard, Aces };
+
+struct DisplaySettings {
+    ToneMapper tonemap = ToneMapper::Gamma;
+    float exposure = 0.0f;  // stops; the linear color is scaled by 2^exposure first
+};
+
+class DisplayTransform {
+public:
+    // "gamma" | "linear" | "srgb" | "reinhard" | "aces"; throws std::runtime_error otherwise
+    static ToneMapper parse(const std::string& name);
+    static const char* name(ToneMapper tonemap);
+
+    // Scalar reference of the whole transform for one channel, result in [0, 1]
+    static float apply(float linear, const DisplaySettings& settings);
+
+    // Writes width*height colors (row-major, top row first, multiplied by scale
+    // first, e.g. 1/samples for film sums) into a 32-bit surface, four channels at a time.
+    static void resolve(const Vec3* colors, double scale, int width, int height,
+        SDL_Surface* surface, const DisplaySettings& settings);
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "Vec3x8.h"
+
+// Fast approximations of the transcendental functions on the shading path.
+//
+// The <cmath> functions are double precision library calls with full special
+// case handling, and shading only needs float accuracy. These are short
+// polynomials: the Cephes single precision kernels for exp, log, sin and cos,
+// and Abramowitz & Stegun 4.4.46 / 4.4.49 for acos and atan. acos, asin,
+// atan2 and sincos have a scalar float form and an eight-lane Floatx8 form
+// that evaluate the same polynomial. exp, log and pow are Floatx8 only: the
+// float overloads of std::exp/log/pow are already as fast as a scalar
+// polynomial with its range handling (powf twice as fast, see the std/ and
+// fastmath/ cases of `raytrace_bench micro`). The error bounds below are
+// checked against double precision <cmath> by `raytrace_bench micro --accuracy`.
+//
+//   exp      relative 3e-7           x in [ln(FLT_MIN), 88]; 0 below, inf above
+//   log      relative 3e-7           x > 0 (denormals included)
+//   pow      relative 2e-6 + 4e-7 * |y * log(x)|   x >= 0; results below FLT_MIN flush to 0
+//   acos     absolute 5e-7           x in [-1, 1]; asin likewise
+//   atan2    absolute 3e-7           any finite y, x
+//   sin/cos  absolute 2e-7           |x| up to 8192
+//
+// Building with RT_DISABLE_FAST_MATH sends the scalar functions to <cmath>,
+// for example to rule them out when chasing an artifact. The Floatx8 forms
+// and pow5 (plain multiplication) stay.
+
+namespace fastmath {
+
+// x^5 by multiplication; used for Schlick's Fresnel term
+template <typename T>
+inline T pow5(T x) {
+    const T x2 = x * x;
+    return x2 * x2 * x;
+}
+
+namespace detail {
+    constexpr float kPi = 3.14159265358979323846f;
+    constexpr float kHalfPi = 1.57079632679489661923f;
+    constexpr float kLogFloatMin = -87.3365448f;   // ln(FLT_MIN); exp stops at 2^-126
+
+    // acos(x) / sqrt(1 - x) for x in [0, 1]
+    inline float acosKernel(float x) {
+        return ((((((-1.2624911e-3f * x + 6.6700901e-3f) * x - 1.70881256e-2f) * x + 3.08918810e-2f) * x - 5.01743046e-2f) * x
+            + 8.89789874e-2f) * x - 2.145988016e-1f) * x + 1.5707963050f;
+    }
+    // atan(x) for x in [0, 1]
+    inline float atanKernel(float x) {
+        const float z = x * x;
+        const float p = (((((((2.8662257e-3f * z - 1.61657367e-2f) * z + 4.29096138e-2f) * z - 7.52896400e-2f) * z + 1.065626393e-1f) * z
+            - 1.420889944e-1f) * z + 1.999355085e-1f) * z - 3.333314528e-1f);
+        return p * z * x + x;
+    }
+}
+
+#ifndef RT_DISABLE_FAST_MATH
+
+inline float acos(float x) {
+    const float ax = std::fabs(x) < 1.0f ? std::fabs(x) : 1.0f;
+    const float r = std::sqrt(1.0f - ax) * detail::acosKernel(ax);
+    return x < 0.0f ? detail::kPi - r : r;
+}
+
+inline float asin(float x) { return detail::kHalfPi - fastmath::acos(x); }
+
+inline float atan2(float y, float x) {
+    const float ax = std::fabs(x), ay = std::fabs(y);
+    const float hi = ax > ay ? ax : ay;
+    const float lo = ax > ay ? ay : ax;
+    float r = hi > 0.0f ? detail::atanKernel(lo / hi) : 0.0f;
+    if (ay > ax) r = detail::kHalfPi - r;
+    if (x < 0.0f) r = detail::kPi - r;
+    return y < 0.0f ? -r : r;
+}
+
+inline void sincos(float x, float& s, float& c) {
+    // Same reduction as ::sincos(Floatx8) in Vec3x8.h: octant j rounded up to even, then
+    // x reduced to [-pi/4, pi/4] with a three-part pi/4
+    const float ax = std::fabs(x);
+    int j = static_cast<int>(ax * 1.27323954473516f);
+    j = (j + 1) & ~1;
+    const float y = static_cast<float>(j);
+    float r = ((ax - y * 0.78515625f) - y * 2.4187564849853515625e-4f) - y * 3.77489497744594108e-8f;
+    const float z = r * r;
+    const float sin_poly = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+    const float cos_poly = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+    const bool swap = (j & 2) != 0;
+    s = swap ? cos_poly : sin_poly;
+    c = swap ? sin_poly : cos_poly;
+    if ((x < 0.0f) != ((j & 4) != 0)) s = -s;
+    if (((j + 2) & 4) != 0) c = -c;
+}
+
+#else
+
+inline float acos(float x) { return std::acos(x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x)); }
+inline float asin(float x) { return std::asin(x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x)); }
+inline float atan2(float y, float x) { return std::atan2(y, x); }
+inline void sincos(float x, float& s, float& c) { s = std::sin(x); c = std::cos(x); }
+
+#endif
+
+inline float sin(float x) { float s, c; fastmath::sincos(x, s, c); return s; }
+inline float cos(float x) { float s, c; fastmath::sincos(x, s, c); return c; }
+
+// ---------------------------------------------------------------------------
+// Eight lanes. NaN inputs give unspecified lanes.
+
+inline Floatx8 exp(const Floatx8& x_in) {
+    // Lanes below the range compute e^0 and are zeroed at the end, so no lane produces a denormal
+    const Floatx8 x = select(x_in < Floatx8(detail::kLogFloatMin), Floatx8(0.0f), min(x_in, Floatx8(88.0f)));
+    const Floatx8 n = floor(fmadd(x, Floatx8(1.44269504088896341f), Floatx8(0.5f)));
+    Floatx8 r = fmadd(n, Floatx8(-0.693359375f), x);
+    r = fmadd(n, Floatx8(2.12194440e-4f), r);
+    const Floatx8 z = r * r;
+    Floatx8 p = fmadd(Floatx8(1.9875691500e-4f), r, Floatx8(1.3981999507e-3f));
+    p = fmadd(p, r, Floatx8(8.3334519073e-3f));
+    p = fmadd(p, r, Floatx8(4.1665795894e-2f));
+    p = fmadd(p, r, Floatx8(1.6666665459e-1f));
+    p = fmadd(p, r, Floatx8(5.0000001201e-1f));
+    const Floatx8 e_r = fmadd(p, z, r + Floatx8(1.0f));
+    const Floatx8 result = e_r * asFloat(shiftLeft(toInt(n) + Intx8(127), 23));
+    return select(x_in < Floatx8(detail::kLogFloatMin), Floatx8(0.0f),
+        select(x_in > Floatx8(88.0f), Floatx8(std::numeric_limits<float>::infinity()), result));
+}
+
+// x > 0; zero gives -inf, negative lanes are unspecified
+inline Floatx8 log(const Floatx8& x_in) {
+    const Maskx8 denormal = x_in < Floatx8(std::numeric_limits<float>::min());
+    const Floatx8 x = select(denormal, x_in * Floatx8(8388608.0f), x_in);
+    const Intx8 b = asInt(x);
+    Floatx8 e = toFloat((shiftRightLogical(b, 23) & Intx8(0xFF)) - Intx8(126)) - select(denormal, Floatx8(23.0f), Floatx8(0.0f));
+    Floatx8 m = asFloat((b & Intx8(0x007FFFFF)) | Intx8(0x3F000000));
+    const Maskx8 small = m < Floatx8(0.707106781186547524f);
+    e = e - select(small, Floatx8(1.0f), Floatx8(0.0f));
+    m = m + select(small, m, Floatx8(0.0f)) - Floatx8(1.0f);
+    const Floatx8 z = m * m;
+    Floatx8 p = fmadd(Floatx8(7.0376836292e-2f), m, Floatx8(-1.1514610310e-1f));
+    p = fmadd(p, m, Floatx8(1.1676998740e-1f));
+    p = fmadd(p, m, Floatx8(-1.2420140846e-1f));
+    p = fmadd(p, m, Floatx8(1.4249322787e-1f));
+    p = fmadd(p, m, Floatx8(-1.6668057665e-1f));
+    p = fmadd(p, m, Floatx8(2.0000714765e-1f));
+    p = fmadd(p, m, Floatx8(-2.4999993993e-1f));
+    p = fmadd(p, m, Floatx8(3.3333331174e-1f));
+    Floatx8 y = p * m * z;
+    y = fmadd(e, Floatx8(-2.12194440e-4f), y);
+    y = fmadd(z, Floatx8(-0.5f), y);
+    const Floatx8 result = fmadd(e, Floatx8(0.693359375f), m + y);
+    return select(x_in == Floatx8(0.0f), Floatx8(-std::numeric_limits<float>::infinity()), result);
+}
+
+// x >= 0
+inline Floatx8 pow(const Floatx8& x, const Floatx8& y) {
+    const Floatx8 positive = fastmath::exp(y * fastmath::log(select(x > Floatx8(0.0f), x, Floatx8(1.0f))));
+    const Floatx8 at_zero = select(y > Floatx8(0.0f), Floatx8(0.0f), Floatx8(std::numeric_limits<float>::infinity()));
+    const Floatx8 result = select(x > Floatx8(0.0f), positive, at_zero);
+    return select((y == Floatx8(0.0f)) | (x == Floatx8(1.0f)), Floatx8(1.0f), result);
+}
+
+inline Floatx8 acos(const Floatx8& x) {
+    const Floatx8 ax = min(abs(x), Floatx8(1.0f));
+    Floatx8 p = fmadd(Floatx8(-1.2624911e-3f), ax, Floatx8(6.6700901e-3f));
+    p = fmadd(p, ax, Floatx8(-1.70881256e-2f));
+    p = fmadd(p, ax, Floatx8(3.08918810e-2f));
+    p = fmadd(p, ax, Floatx8(-5.01743046e-2f));
+    p = fmadd(p, ax, Floatx8(8.89789874e-2f));
+    p = fmadd(p, ax, Floatx8(-2.145988016e-1f));
+    p = fmadd(p, ax, Floatx8(1.5707963050f));
+    const Floatx8 r = sqrt(Floatx8(1.0f) - ax) * p;
+    return select(x < Floatx8(0.0f), Floatx8(detail::kPi) - r, r);
+}
+
+inline Floatx8 asin(const Floatx8& x) { return Floatx8(detail::kHalfPi) - fastmath::acos(x); }
+
+inline Floatx8 atan2(const Floatx8& y, const Floatx8& x) {
+    const Floatx8 ax = abs(x), ay = abs(y);
+    const Floatx8 hi = max(ax, ay), lo = min(ax, ay);
+    const Floatx8 t = select(hi > Floatx8(0.0f), lo / hi, Floatx8(0.0f));
+    const Floatx8 z = t * t;
+    Floatx8 p = fmadd(Floatx8(2.8662257e-3f), z, Floatx8(-1.61657367e-2f));
+    p = fmadd(p, z, Floatx8(4.29096138e-2f));
+    p = fmadd(p, z, Floatx8(-7.52896400e-2f));
+    p = fmadd(p, z, Floatx8(1.065626393e-1f));
+    p = fmadd(p, z, Floatx8(-1.420889944e-1f));
+    p = fmadd(p, z, Floatx8(1.999355085e-1f));
+    p = fmadd(p, z, Floatx8(-3.333314528e-1f));
+    Floatx8 r = fmadd(p * z, t, t);
+    r = select(ay > ax, Floatx8(detail::kHalfPi) - r, r);
+    r = select(x < Floatx8(0.0f), Floatx8(detail::kPi) - r, r);
+    return select(y < Floatx8(0.0f), -r, r);
+}
+
+inline void sincos(const Floatx8& x, Floatx8& s, Floatx8& c) { ::sincos(x, s, c); }
+
+}
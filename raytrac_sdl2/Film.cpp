@@ -0,0 +1,61 @@
+#include "Film.h"
+
+void Film::reset(int w, int h, AovMask aovs) {
+    width = w;
+    height = h;
+    samples = 0;
+    const size_t count = static_cast<size_t>(w) * h;
+    color.assign(count, Vec3(0.0, 0.0, 0.0));
+    luminance.assign(count, 0.0f);
+    luminance_sq.assign(count, 0.0f);
+    aov_mask = aovs;
+    for (int t = 0; t < static_cast<int>(AovType::Count); ++t) {
+        const AovType type = static_cast<AovType>(t);
+        if (hasAov(type)) aov[t].assign(count * Aov::channels(type), Aov::isId(type) ? -1.0f : 0.0f);
+        else aov[t].clear();
+    }
+}
+
+void Film::addAov(size_t i, const AovSample& sample) {
+    for (int t = 0; t < static_cast<int>(AovType::Count); ++t) {
+        const AovType type = static_cast<AovType>(t);
+        if (!hasAov(type)) continue;
+        const int channels = Aov::channels(type);
+        float values[3];
+        Aov::read(sample, type, values);
+        float* dst = &aov[t][i * channels];
+        for (int c = 0; c < channels; ++c) {
+            dst[c] = Aov::isId(type) ? values[c] : dst[c] + values[c];
+        }
+    }
+}
+
+std::vector<float> Film::resolveAov(AovType type) const {
+    std::vector<float> values = aov[static_cast<int>(type)];
+    if (!Aov::isId(type) && samples > 0) {
+        const float inv = 1.0f / samples;
+        for (float& v : values) v *= inv;
+    }
+    return values;
+}
+
+Vec3 Film::meanAov3(AovType type, size_t i) const {
+    const float* v = &aov[static_cast<int>(type)][i * 3];
+    const double inv = samples > 0 ? 1.0 / samples : 0.0;
+    return Vec3(v[0] * inv, v[1] * inv, v[2] * inv);
+}
+
+float Film::meanAov1(AovType type, size_t i) const {
+    return samples > 0 ? aov[static_cast<int>(type)][i] / samples : 0.0f;
+}
+
+Vec3 Film::meanColor(size_t i) const {
+    return samples > 0 ? color[i] / samples : Vec3(0.0, 0.0, 0.0);
+}
+
+float Film::meanVariance(size_t i) const {
+    if (samples < 2) return 0.0f;
+    const float mean = luminance[i] / samples;
+    const float sample_variance = std::max(0.0f, luminance_sq[i] / samples - mean * mean);
+    return sample_variance / samples;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include "Vec3.h"
+#include "Aov.h"
+
+// Linear accumulation film. Every buffer stores per-pixel sums over all samples
+// taken so far (row-major, top row first); divide by `samples` for the mean.
+// The 8-bit display surface is only an output of the film, never read back.
+class Film {
+public:
+    // AOV buffers are only allocated for the bits set in aovs
+    void reset(int width, int height, AovMask aovs);
+
+    int width = 0;
+    int height = 0;
+    int samples = 0;
+
+    std::vector<Vec3> color;
+    std::vector<float> luminance;      // sum of per-sample luminance
+    std::vector<float> luminance_sq;   // sum of squared per-sample luminance
+
+    // Aov::channels(type) floats per pixel; sums like the color, except ids which keep the last sample
+    std::vector<float> aov[static_cast<int>(AovType::Count)];
+    AovMask aov_mask = 0;
+
+    bool hasAov(AovType type) const { return (aov_mask & aovBit(type)) != 0; }
+    size_t index(int x, int y) const { return static_cast<size_t>(y) * width + x; }
+
+    // Adds one sample to every allocated AOV of pixel i
+    void addAov(size_t i, const AovSample& sample);
+    // Per-pixel mean of one AOV (ids copied as is)
+    std::vector<float> resolveAov(AovType type) const;
+    Vec3 meanAov3(AovType type, size_t i) const;
+    float meanAov1(AovType type, size_t i) const;
+
+    Vec3 meanColor(size_t i) const;
+    // Variance of the pixel mean, estimated from the luminance moments
+    float meanVariance(size_t i) const;
+
+    static float luminanceOf(const Vec3& c) {
+        return static_cast<float>(0.2126 * c.x + 0.7152 * c.y + 0.0722 * c.z);
+    }
+};
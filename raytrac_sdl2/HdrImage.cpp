@@ -0,0 +1,378 @@
+#include "HdrImage.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+namespace {
+    enum ExrPixelType : int32_t { EXR_UINT = 0, EXR_HALF = 1, EXR_FLOAT = 2 };
+
+    // IEEE 754 binary32 -> binary16, round to nearest even
+    uint16_t floatToHalf(float value) {
+        uint32_t f;
+        std::memcpy(&f, &value, sizeof(f));
+        const uint32_t sign = (f >> 16) & 0x8000u;
+        const int32_t exponent = static_cast<int32_t>((f >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = f & 0x7FFFFFu;
+
+        if (((f >> 23) & 0xFF) == 0xFF) {
+            return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u)); // inf / nan
+        }
+        if (exponent >= 31) {
+            return static_cast<uint16_t>(sign | 0x7C00u); // overflow -> inf
+        }
+        if (exponent <= 0) {
+            if (exponent < -10) return static_cast<uint16_t>(sign); // underflow -> 0
+            mantissa |= 0x800000u;
+            const int shift = 14 - exponent;
+            uint32_t half_mantissa = mantissa >> shift;
+            const uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half_mantissa & 1u))) ++half_mantissa;
+            return static_cast<uint16_t>(sign | half_mantissa);
+        }
+        uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        const uint32_t remainder = mantissa & 0x1FFFu;
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) ++half; // may carry into the exponent, which is correct
+        return static_cast<uint16_t>(half);
+    }
+
+    float halfToFloat(uint16_t h) {
+        const uint32_t sign = (h & 0x8000u) << 16;
+        uint32_t exponent = (h >> 10) & 0x1Fu;
+        uint32_t mantissa = h & 0x3FFu;
+        uint32_t f;
+        if (exponent == 0) {
+            if (mantissa == 0) {
+                f = sign;
+            }
+            else {
+                // Subnormal: normalize
+                exponent = 127 - 15 + 1;
+                while (!(mantissa & 0x400u)) {
+                    mantissa <<= 1;
+                    --exponent;
+                }
+                f = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+            }
+        }
+        else if (exponent == 31) {
+            f = sign | 0x7F800000u | (mantissa << 13);
+        }
+        else {
+            f = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+        }
+        float value;
+        std::memcpy(&value, &f, sizeof(value));
+        return value;
+    }
+
+    // EXR is little-endian; so are all platforms this project builds for
+    template <typename T>
+    void put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void putAttribute(std::string& out, const char* name, const char* type, const std::string& value) {
+        out += name;
+        out += '\0';
+        out += type;
+        out += '\0';
+        put<int32_t>(out, static_cast<int32_t>(value.size()));
+        out += value;
+    }
+
+    template <typename T>
+    std::string bytes(T value) {
+        std::string s;
+        put(s, value);
+        return s;
+    }
+
+    struct ChannelRef {
+        std::string name;
+        size_t layer;
+        int component;
+    };
+
+    const char* componentName(const HdrImage::Layer& layer, int component) {
+        if (layer.channels == 1) return layer.name == "depth" ? "Z" : "Y";
+        static const char* rgb[3] = { "R", "G", "B" };
+        return rgb[component];
+    }
+
+    template <typename T>
+    T get(const std::string& data, size_t& pos) {
+        if (pos + sizeof(T) > data.size()) throw std::runtime_error("truncated EXR file");
+        T value;
+        std::memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string getString(const std::string& data, size_t& pos) {
+        const size_t end = data.find('\0', pos);
+        if (end == std::string::npos) throw std::runtime_error("truncated EXR header");
+        std::string s = data.substr(pos, end - pos);
+        pos = end + 1;
+        return s;
+    }
+
+    std::string lowercaseExtension(const std::string& filename) {
+        std::string ext = std::filesystem::path(filename).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext;
+    }
+}
+
+bool HdrImage::isHdrPath(const std::string& filename) {
+    const std::string ext = lowercaseExtension(filename);
+    return ext == ".exr" || ext == ".pfm";
+}
+
+bool HdrImage::write(const std::string& filename, const Image& image, bool half) {
+    const std::string ext = lowercaseExtension(filename);
+    if (ext == ".exr") return writeExr(filename, image, half);
+    if (ext == ".pfm") {
+        if (image.layers.empty() || image.layers[0].channels != 3) {
+            std::cerr << "PFM output needs an RGB image" << std::endl;
+            return false;
+        }
+        return writePfm(filename, image.width, image.height, image.layers[0].values);
+    }
+    std::cerr << "Unknown HDR image format: " << filename << " (expected .exr or .pfm)" << std::endl;
+    return false;
+}
+
+bool HdrImage::writePfm(const std::string& filename, int width, int height, const std::vector<float>& rgb) {
+    if (rgb.size() != static_cast<size_t>(width) * height * 3) {
+        std::cerr << "PFM: buffer does not match the image size" << std::endl;
+        return false;
+    }
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Could not write " << filename << std::endl;
+        return false;
+    }
+    // Negative scale = little-endian; PFM stores the bottom row first
+    out << "PF\n" << width << " " << height << "\n-1.0\n";
+    for (int y = height - 1; y >= 0; --y) {
+        out.write(reinterpret_cast<const char*>(&rgb[static_cast<size_t>(y) * width * 3]), static_cast<std::streamsize>(width) * 3 * sizeof(float));
+    }
+    return static_cast<bool>(out);
+}
+
+bool HdrImage::writeExr(const std::string& filename, const Image& image, bool half) {
+    const int width = image.width, height = image.height;
+    const size_t pixels = static_cast<size_t>(width) * height;
+    std::vector<ChannelRef> channels;
+    for (size_t l = 0; l < image.layers.size(); ++l) {
+        const Layer& layer = image.layers[l];
+        if (layer.values.size() != pixels * layer.channels) {
+            std::cerr << "EXR: layer '" << layer.name << "' does not match the image size" << std::endl;
+            return false;
+        }
+        for (int c = 0; c < layer.channels; ++c) {
+            const std::string component = componentName(layer, c);
+            channels.push_back({ layer.name.empty() ? component : layer.name + "." + component, l, c });
+        }
+    }
+    // OpenEXR keeps channel lists sorted by name
+    std::sort(channels.begin(), channels.end(), [](const ChannelRef& a, const ChannelRef& b) { return a.name < b.name; });
+
+    // Ids above 2048 do not survive half precision, keep them in float
+    auto pixelType = [&](const ChannelRef& ch) {
+        return half && !image.layers[ch.layer].is_id ? EXR_HALF : EXR_FLOAT;
+    };
+
+    std::string header;
+    put<int32_t>(header, 20000630);
+    put<int32_t>(header, 2);
+
+    std::string chlist;
+    for (const ChannelRef& ch : channels) {
+        chlist += ch.name;
+        chlist += '\0';
+        put<int32_t>(chlist, pixelType(ch));
+        put<uint8_t>(chlist, 0);       // pLinear
+        chlist.append(3, '\0');        // reserved
+        put<int32_t>(chlist, 1);       // xSampling
+        put<int32_t>(chlist, 1);       // ySampling
+    }
+    chlist += '\0';
+    std::string box;
+    put<int32_t>(box, 0);
+    put<int32_t>(box, 0);
+    put<int32_t>(box, width - 1);
+    put<int32_t>(box, height - 1);
+    std::string center;
+    put<float>(center, 0.0f);
+    put<float>(center, 0.0f);
+
+    putAttribute(header, "channels", "chlist", chlist);
+    putAttribute(header, "compression", "compression", std::string(1, '\0'));
+    putAttribute(header, "dataWindow", "box2i", box);
+    putAttribute(header, "displayWindow", "box2i", box);
+    putAttribute(header, "lineOrder", "lineOrder", std::string(1, '\0'));
+    putAttribute(header, "pixelAspectRatio", "float", bytes(1.0f));
+    putAttribute(header, "samples", "int", bytes(static_cast<int32_t>(image.samples)));
+    putAttribute(header, "screenWindowCenter", "v2f", center);
+    putAttribute(header, "screenWindowWidth", "float", bytes(1.0f));
+    header += '\0';
+
+    size_t line_bytes = 0;
+    for (const ChannelRef& ch : channels) line_bytes += static_cast<size_t>(width) * (pixelType(ch) == EXR_HALF ? 2 : 4);
+
+    // One scanline per chunk without compression
+    std::string offsets;
+    uint64_t offset = header.size() + static_cast<uint64_t>(height) * sizeof(uint64_t);
+    for (int y = 0; y < height; ++y) {
+        put<uint64_t>(offsets, offset);
+        offset += 8 + line_bytes;
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Could not write " << filename << std::endl;
+        return false;
+    }
+    out.write(header.data(), header.size());
+    out.write(offsets.data(), offsets.size());
+
+    std::string line;
+    line.reserve(8 + line_bytes);
+    for (int y = 0; y < height; ++y) {
+        line.clear();
+        put<int32_t>(line, y);
+        put<int32_t>(line, static_cast<int32_t>(line_bytes));
+        for (const ChannelRef& ch : channels) {
+            const Layer& layer = image.layers[ch.layer];
+            const float* src = &layer.values[static_cast<size_t>(y) * width * layer.channels + ch.component];
+            const bool as_half = pixelType(ch) == EXR_HALF;
+            for (int x = 0; x < width; ++x) {
+                const float v = src[static_cast<size_t>(x) * layer.channels];
+                if (as_half) put<uint16_t>(line, floatToHalf(v));
+                else put<float>(line, v);
+            }
+        }
+        out.write(line.data(), line.size());
+    }
+    return static_cast<bool>(out);
+}
+
+HdrImage::Image HdrImage::readExr(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) throw std::runtime_error("could not open " + filename);
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    if (get<int32_t>(data, pos) != 20000630) throw std::runtime_error(filename + ": not an OpenEXR file");
+    if ((get<int32_t>(data, pos) & ~0xFF) != 0) throw std::runtime_error(filename + ": only single-part scanline EXR files are supported");
+
+    struct ChannelInfo { std::string name; int32_t type; };
+    std::vector<ChannelInfo> channels;
+    int32_t box[4] = { 0, 0, -1, -1 };
+    Image image;
+    for (;;) {
+        const std::string name = getString(data, pos);
+        if (name.empty()) break;
+        const std::string type = getString(data, pos);
+        const int32_t size = get<int32_t>(data, pos);
+        const size_t value_end = pos + size;
+        if (size < 0 || value_end > data.size()) throw std::runtime_error(filename + ": truncated EXR header");
+        if (name == "channels") {
+            while (pos < value_end) {
+                const std::string channel = getString(data, pos);
+                if (channel.empty()) break;
+                const int32_t pixel_type = get<int32_t>(data, pos);
+                pos += 4; // pLinear + reserved
+                const int32_t xs = get<int32_t>(data, pos), ys = get<int32_t>(data, pos);
+                if (xs != 1 || ys != 1 || pixel_type == EXR_UINT) throw std::runtime_error(filename + ": unsupported channel '" + channel + "'");
+                channels.push_back({ channel, pixel_type });
+            }
+        }
+        else if (name == "compression") {
+            if (data[pos] != 0) throw std::runtime_error(filename + ": compressed EXR files are not supported");
+        }
+        else if (name == "dataWindow") {
+            for (int i = 0; i < 4; ++i) box[i] = get<int32_t>(data, pos);
+        }
+        else if (name == "samples" && type == "int") {
+            image.samples = get<int32_t>(data, pos);
+        }
+        pos = value_end;
+    }
+    image.width = box[2] - box[0] + 1;
+    image.height = box[3] - box[1] + 1;
+    if (image.width <= 0 || image.height <= 0 || channels.empty()) throw std::runtime_error(filename + ": empty EXR image");
+
+    // Group "layer.C" channels back into layers; the beauty image (empty prefix) sorts first
+    std::map<std::string, std::vector<size_t>> by_layer;
+    for (size_t i = 0; i < channels.size(); ++i) {
+        const size_t dot = channels[i].name.rfind('.');
+        by_layer[dot == std::string::npos ? "" : channels[i].name.substr(0, dot)].push_back(i);
+    }
+    std::vector<std::pair<size_t, int>> destination(channels.size()); // layer, component
+    for (const auto& [layer_name, indices] : by_layer) {
+        Layer layer;
+        layer.name = layer_name;
+        layer.channels = indices.size() >= 3 ? 3 : 1;
+        layer.is_id = layer_name.size() > 3 && layer_name.compare(layer_name.size() - 3, 3, "_id") == 0;
+        layer.values.assign(static_cast<size_t>(image.width) * image.height * layer.channels, 0.0f);
+        for (size_t index : indices) {
+            const std::string component = channels[index].name.substr(layer_name.empty() ? 0 : layer_name.size() + 1);
+            int c = 0;
+            if (layer.channels == 3) c = component == "G" ? 1 : component == "B" ? 2 : 0;
+            destination[index] = { image.layers.size(), c };
+        }
+        image.layers.push_back(std::move(layer));
+    }
+
+    pos += static_cast<size_t>(image.height) * sizeof(uint64_t); // offset table, chunks follow in order
+    for (int line = 0; line < image.height; ++line) {
+        const int32_t y = get<int32_t>(data, pos) - box[1];
+        get<int32_t>(data, pos);
+        if (y < 0 || y >= image.height) throw std::runtime_error(filename + ": scanline out of range");
+        for (size_t i = 0; i < channels.size(); ++i) {
+            Layer& layer = image.layers[destination[i].first];
+            float* dst = &layer.values[static_cast<size_t>(y) * image.width * layer.channels + destination[i].second];
+            for (int x = 0; x < image.width; ++x) {
+                dst[static_cast<size_t>(x) * layer.channels] = channels[i].type == EXR_HALF
+                    ? halfToFloat(get<uint16_t>(data, pos)) : get<float>(data, pos);
+            }
+        }
+    }
+    return image;
+}
+
+HdrImage::Image HdrImage::merge(const std::vector<Image>& parts) {
+    if (parts.empty()) throw std::runtime_error("nothing to merge");
+    Image merged = parts[0];
+    int total_samples = 0;
+    for (const Image& part : parts) {
+        if (part.width != merged.width || part.height != merged.height || part.layers.size() != merged.layers.size()) {
+            throw std::runtime_error("partial renders differ in size or layers");
+        }
+        // Files without a sample count are weighted equally
+        total_samples += std::max(part.samples, 1);
+    }
+    for (size_t l = 0; l < merged.layers.size(); ++l) {
+        Layer& layer = merged.layers[l];
+        if (layer.is_id) continue;
+        std::fill(layer.values.begin(), layer.values.end(), 0.0f);
+        for (const Image& part : parts) {
+            const Layer& src = part.layers[l];
+            if (src.name != layer.name || src.values.size() != layer.values.size()) {
+                throw std::runtime_error("partial renders differ in layer '" + layer.name + "'");
+            }
+            const float weight = static_cast<float>(std::max(part.samples, 1)) / total_samples;
+            for (size_t i = 0; i < layer.values.size(); ++i) layer.values[i] += weight * src.values[i];
+        }
+    }
+    merged.samples = total_samples;
+    return merged;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Float image output straight from the linear film, without clipping.
+//
+// PFM is the dependency-free fallback (RGB only). EXR files are written as
+// uncompressed scanline OpenEXR with FLOAT or HALF channels: the beauty image
+// as R, G, B plus one "<layer>.<channel>" group per extra layer (AOVs), and the
+// accumulated sample count in a custom "samples" int attribute so partial
+// renders of the same frame can be merged by sample-weighted averaging.
+class HdrImage {
+public:
+    struct Layer {
+        std::string name;           // empty for the beauty image
+        int channels = 3;           // 1 or 3
+        bool is_id = false;         // ids are copied, never averaged when merging
+        std::vector<float> values;  // row-major, top row first, channels floats per pixel
+    };
+
+    struct Image {
+        int width = 0;
+        int height = 0;
+        int samples = 0;
+        std::vector<Layer> layers;
+    };
+
+    // Chooses the format from the extension (.exr or .pfm). PFM only stores the first layer.
+    static bool write(const std::string& filename, const Image& image, bool half = false);
+
+    static bool writePfm(const std::string& filename, int width, int height, const std::vector<float>& rgb);
+    static bool writeExr(const std::string& filename, const Image& image, bool half = false);
+
+    // Reads the uncompressed EXR files writeExr produces. Throws std::runtime_error otherwise.
+    static Image readExr(const std::string& filename);
+
+    // Sample-weighted average of partial renders with identical size and layers
+    static Image merge(const std::vector<Image>& parts);
+
+    static bool isHdrPath(const std::string& filename);
+};
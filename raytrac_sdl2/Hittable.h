@@ -26,6 +26,7 @@ struct HitRecord {
     // Yeni alanlar
  
     Vec2 uv; // UV koordinatlar eklendi
+    int object_id = -1; // vuruu reten st seviye sahne nesnesi (ParallelBVHNode doldurur)
   
     inline void set_face_normal(const Ray& r, const Vec3& outward_normal) {
         front_face = Vec3::dot(r.direction, outward_normal) < 0;
@@ -38,11 +39,12 @@ public:
     virtual bool hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const = 0;
     virtual bool bounding_box(double time0, double time1, AABB& output_box) const = 0;
     virtual ~Hittable() = default;
+    // st seviye sahne nesnelerine Renderer tarafndan verilir, dierleri -1 kalr
+    int object_id = -1;
     virtual void collect_neighbor_normals(const AABB& query_box, Vec3& neighbor_normal,
         int& neighbor_count, const std::shared_ptr<Material>& current_material) const {
         // Varsaylan implementasyon: hibir ey yapma
     }
-    std::vector<std::shared_ptr<Hittable>> objects; // objects yesi eklendi
 };
 
 #endif // HITTABLE_H
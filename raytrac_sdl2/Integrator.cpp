@@ -0,0 +1,35 @@
+#include "Integrator.h"
+#include <stdexcept>
+
+IntegratorType Integrator::parse(const std::string& name) {
+    if (name == "path") return IntegratorType::Path;
+    if (name == "wavefront") return IntegratorType::Wavefront;
+    if (name == "ao") return IntegratorType::AmbientOcclusion;
+    if (name == "direct") return IntegratorType::Direct;
+    if (name == "one_bounce") return IntegratorType::OneBounce;
+    if (name == "normal") return IntegratorType::Normal;
+    if (name == "uv") return IntegratorType::Uv;
+    if (name == "material") return IntegratorType::Material;
+    throw std::runtime_error("unknown integrator '" + name + "' (expected path, wavefront, ao, direct, one_bounce, normal, uv or material)");
+}
+
+const char* Integrator::name(IntegratorType type) {
+    switch (type) {
+    case IntegratorType::Path: return "path";
+    case IntegratorType::Wavefront: return "wavefront";
+    case IntegratorType::AmbientOcclusion: return "ao";
+    case IntegratorType::Direct: return "direct";
+    case IntegratorType::OneBounce: return "one_bounce";
+    case IntegratorType::Normal: return "normal";
+    case IntegratorType::Uv: return "uv";
+    case IntegratorType::Material: return "material";
+    }
+    return "path";
+}
+
+ShadowGlass Integrator::parseShadowGlass(const std::string& name) {
+    if (name == "thin") return ShadowGlass::Thin;
+    if (name == "refract") return ShadowGlass::Refract;
+    if (name == "opaque") return ShadowGlass::Opaque;
+    throw std::runtime_error("unknown shadow_glass mode '" + name + "' (expected thin, refract or opaque)");
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+// Selectable integrators. Path is the full path tracer and wavefront runs
+// the same estimator breadth-first over batches of paths (see Wavefront.h);
+// the rest are fast layout previews that reuse the same BVH, camera and lights:
+//   ao         - BVH-traced ambient occlusion at the first hit
+//   direct     - emission + direct lighting at the first hit, no bounces
+//   one_bounce - the path tracer limited to the camera hit plus one bounce
+//   normal / uv / material - false-color debug views of the first hit
+enum class IntegratorType { Path, Wavefront, AmbientOcclusion, Direct, OneBounce, Normal, Uv, Material };
+
+// How shadow rays treat dielectric surfaces during direct lighting:
+//   thin    - glass is a non-refracting sheet: the ray goes straight on and picks up its transmittance
+//   refract - the ray bends at every glass surface and the light counts only if it leaves
+//             heading the original way (exact for panes modelled with both faces;
+//             single-sheet and curved glass stay dark)
+//   opaque  - any hit blocks the light
+enum class ShadowGlass { Thin, Refract, Opaque };
+
+struct IntegratorSettings {
+    IntegratorType type = IntegratorType::Path;
+    double ao_distance = 1.0;   // occluders farther than this (scene units) are ignored
+    int ao_samples = 4;         // occlusion rays per camera sample
+    ShadowGlass shadow_glass = ShadowGlass::Thin;
+};
+
+class Integrator {
+public:
+    // "path" | "wavefront" | "ao" | "direct" | "one_bounce" | "normal" | "uv" | "material"; throws std::runtime_error otherwise
+    static IntegratorType parse(const std::string& name);
+    static const char* name(IntegratorType type);
+    // "thin" | "refract" | "opaque"; throws std::runtime_error otherwise
+    static ShadowGlass parseShadowGlass(const std::string& name);
+};
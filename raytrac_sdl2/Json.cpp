@@ -0,0 +1,228 @@
+#include "Json.h"
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    const JsonValue null_value;
+}
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text(text) {}
+
+    JsonValue parseDocument() {
+        JsonValue value = parseValue(0);
+        skipWhitespace();
+        if (pos != text.size()) fail("unexpected trailing characters");
+        return value;
+    }
+
+private:
+    static constexpr int MAX_NESTING = 256;
+
+    const std::string& text;
+    size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        size_t line = 1, column = 1;
+        for (size_t i = 0; i < pos && i < text.size(); ++i) {
+            if (text[i] == '\n') { ++line; column = 1; }
+            else ++column;
+        }
+        throw std::runtime_error("JSON error at line " + std::to_string(line) + ", column " + std::to_string(column) + ": " + message);
+    }
+
+    void skipWhitespace() {
+        while (pos < text.size()) {
+            const char c = text[pos];
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                ++pos;
+            }
+            else if (c == '/' && pos + 1 < text.size() && text[pos + 1] == '/') {
+                // Line comments are accepted so scene files can be annotated
+                while (pos < text.size() && text[pos] != '\n') ++pos;
+            }
+            else {
+                break;
+            }
+        }
+    }
+
+    void expect(char c) {
+        skipWhitespace();
+        if (pos >= text.size() || text[pos] != c) fail(std::string("expected '") + c + "'");
+        ++pos;
+    }
+
+    bool consumeLiteral(const char* literal) {
+        const size_t length = std::char_traits<char>::length(literal);
+        if (text.compare(pos, length, literal) == 0) {
+            pos += length;
+            return true;
+        }
+        return false;
+    }
+
+    JsonValue parseValue(int depth) {
+        if (depth > MAX_NESTING) fail("nesting too deep");
+        skipWhitespace();
+        if (pos >= text.size()) fail("unexpected end of input");
+
+        JsonValue value;
+        const char c = text[pos];
+        if (c == '{') {
+            value.m_type = JsonValue::Type::Object;
+            ++pos;
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == '}') { ++pos; return value; }
+            while (true) {
+                skipWhitespace();
+                if (pos >= text.size() || text[pos] != '"') fail("expected object key");
+                value.m_keys.push_back(parseString());
+                expect(':');
+                value.m_items.push_back(parseValue(depth + 1));
+                skipWhitespace();
+                if (pos < text.size() && text[pos] == ',') { ++pos; continue; }
+                expect('}');
+                return value;
+            }
+        }
+        if (c == '[') {
+            value.m_type = JsonValue::Type::Array;
+            ++pos;
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == ']') { ++pos; return value; }
+            while (true) {
+                value.m_items.push_back(parseValue(depth + 1));
+                skipWhitespace();
+                if (pos < text.size() && text[pos] == ',') { ++pos; continue; }
+                expect(']');
+                return value;
+            }
+        }
+        if (c == '"') {
+            value.m_type = JsonValue::Type::String;
+            value.m_string = parseString();
+            return value;
+        }
+        if (consumeLiteral("true")) { value.m_type = JsonValue::Type::Bool; value.m_bool = true; return value; }
+        if (consumeLiteral("false")) { value.m_type = JsonValue::Type::Bool; value.m_bool = false; return value; }
+        if (consumeLiteral("null")) return value;
+
+        value.m_type = JsonValue::Type::Number;
+        const char* begin = text.data() + pos;
+        auto result = std::from_chars(begin, text.data() + text.size(), value.m_number);
+        if (result.ec != std::errc() || result.ptr == begin) fail("invalid value");
+        pos += result.ptr - begin;
+        return value;
+    }
+
+    static void appendUtf8(std::string& out, unsigned codepoint) {
+        if (codepoint < 0x80) {
+            out += static_cast<char>(codepoint);
+        }
+        else if (codepoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codepoint >> 6));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+        else if (codepoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codepoint >> 12));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+        else {
+            out += static_cast<char>(0xF0 | (codepoint >> 18));
+            out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    unsigned parseHex4() {
+        if (pos + 4 > text.size()) fail("truncated \\u escape");
+        unsigned value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = text[pos++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else fail("invalid \\u escape");
+        }
+        return value;
+    }
+
+    std::string parseString() {
+        ++pos; // opening quote
+        std::string out;
+        while (true) {
+            if (pos >= text.size()) fail("unterminated string");
+            const char c = text[pos++];
+            if (c == '"') return out;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= text.size()) fail("unterminated string");
+            const char escape = text[pos++];
+            switch (escape) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned codepoint = parseHex4();
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF && consumeLiteral("\\u")) {
+                    const unsigned low = parseHex4();
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, codepoint);
+                break;
+            }
+            default: fail("invalid escape sequence");
+            }
+        }
+    }
+};
+
+JsonValue JsonValue::parse(const std::string& text) {
+    return JsonParser(text).parseDocument();
+}
+
+JsonValue JsonValue::parseFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open JSON file: " + filename);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    try {
+        return parse(buffer.str());
+    }
+    catch (const std::runtime_error& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    if (m_type != Type::Array || index >= m_items.size()) return null_value;
+    return m_items[index];
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const {
+    if (m_type != Type::Object) return null_value;
+    for (size_t i = 0; i < m_keys.size(); ++i) {
+        if (m_keys[i] == key) return m_items[i];
+    }
+    return null_value;
+}
+
+bool JsonValue::has(const std::string& key) const {
+    return !(*this)[key].isNull();
+}
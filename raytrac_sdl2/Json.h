@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Minimal JSON document model used by the scene files.
+// Lookups never throw: a missing key or out of range index yields a null
+// value, so optional fields read as `value["key"].asNumber(default)`.
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    JsonValue() = default;
+
+    // Throws std::runtime_error with the line/column of the first syntax error.
+    static JsonValue parse(const std::string& text);
+    static JsonValue parseFile(const std::string& filename);
+
+    Type type() const { return m_type; }
+    bool isNull() const { return m_type == Type::Null; }
+    bool isBool() const { return m_type == Type::Bool; }
+    bool isNumber() const { return m_type == Type::Number; }
+    bool isString() const { return m_type == Type::String; }
+    bool isArray() const { return m_type == Type::Array; }
+    bool isObject() const { return m_type == Type::Object; }
+
+    bool asBool(bool fallback = false) const { return isBool() ? m_bool : fallback; }
+    double asNumber(double fallback = 0.0) const { return isNumber() ? m_number : fallback; }
+    int asInt(int fallback = 0) const { return isNumber() ? static_cast<int>(m_number) : fallback; }
+    std::string asString(const std::string& fallback = "") const { return isString() ? m_string : fallback; }
+
+    // Arrays and objects
+    size_t size() const { return m_items.size(); }
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](const std::string& key) const;
+    bool has(const std::string& key) const;
+    const std::vector<JsonValue>& items() const { return m_items; }
+    const std::vector<std::string>& keys() const { return m_keys; }   // objects only, parallel to items()
+
+private:
+    friend class JsonParser;
+
+    Type m_type = Type::Null;
+    bool m_bool = false;
+    double m_number = 0.0;
+    std::string m_string;
+    std::vector<JsonValue> m_items;
+    std::vector<std::string> m_keys;
+};
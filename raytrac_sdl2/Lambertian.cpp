@@ -1,6 +1,7 @@
 #include "Lambertian.h"
 #include <cmath>
 #include "Matrix4x4.h"
+#include "FastMath.h"
 
 Lambertian::Lambertian(const Vec3& albedo, float roughness, float metallic)
     : albedoProperty(albedo), roughnessProperty(Vec3(roughness)), metallicProperty(Vec3(metallic)) {}
@@ -131,8 +132,8 @@ Vec2 Lambertian::applyTextureTransform(double u, double v) const {
     v *= textureTransform.scale.v;
     // Dndrme (dereceyi radyana evir)
     double rotation_radians = textureTransform.rotation_degrees * M_PI / 180.0;
-    double cosTheta = std::cos(rotation_radians);
-    double sinTheta = std::sin(rotation_radians);
+    float sinTheta, cosTheta;
+    fastmath::sincos(static_cast<float>(rotation_radians), sinTheta, cosTheta);
     double newU = u * cosTheta - v * sinTheta;
     double newV = u * sinTheta + v * cosTheta;
     u = newU;
@@ -164,8 +165,8 @@ UVData Lambertian::transformUV(double u, double v) const {
     v *= textureTransform.scale.v;
 
     double rotation_radians = textureTransform.rotation_degrees * M_PI / 180.0;
-    double cosTheta = std::cos(rotation_radians);
-    double sinTheta = std::sin(rotation_radians);
+    float sinTheta, cosTheta;
+    fastmath::sincos(static_cast<float>(rotation_radians), sinTheta, cosTheta);
     double newU = u * cosTheta - v * sinTheta;
     double newV = u * sinTheta + v * cosTheta;
     u = newU;
@@ -261,6 +262,14 @@ Vec2 Lambertian::applyCubicWrapping(const Vec2& uv) const {
     return uv;
 }
 
+// Sadece dz kosins lobu: metal/anizotropik lob yok, normal haritas lobu geometrik normalden saptrmyor,
+// clearcoat ve subsurface terimleri de attenuation'a eklenmiyor. Emission engel deil: ynden bamsz bir sabit
+// olarak attenuation'a eklenir, lobu ve pdf orann deitirmez (varsaylan siyah)
+bool Lambertian::is_pure_diffuse() const {
+    const bool metallic = metallicProperty.texture || metallicProperty.color.x > 0.0;
+    return !metallic && anisotropic <= 0.0f && !has_normal_map() && clearcoat <= 0.0f && subsurfaceRadius <= 0.0f;
+}
+
 bool Lambertian::scatter(const Ray& r_in, const HitRecord& rec, Vec3& attenuation, Ray& scattered) const {
     Vec2 transformedUV = applyTextureTransform(rec.u, rec.v);
     Vec3 albedoValue = getPropertyValue(albedoProperty, transformedUV);
@@ -294,7 +303,8 @@ bool Lambertian::scatter(const Ray& r_in, const HitRecord& rec, Vec3& attenuatio
     else {
         // Metalik ve difz ynleri hesapla
         Vec3 metal_dir = R + roughness * random_in_unit_sphere();
-        Vec3 diffuse_dir = N + random_in_unit_sphere();
+        // Birim kre yzeyinden nokta: N + nokta tam kosins dalm verir
+        Vec3 diffuse_dir = N + Vec3::random_unit_vector();
 
         // Metalik deerine gre interpolasyon yap
         scatter_direction = lerp(diffuse_dir, metal_dir, metallic);
@@ -351,8 +361,10 @@ Vec3 Lambertian::computeAnisotropicDirection(const Vec3& N, const Vec3& T, const
     float cosTheta = std::sqrt((1 - r2) / (1 + (anisotropy * anisotropy - 1) * r2));
     float sinTheta = std::sqrt(1 - cosTheta * cosTheta);
 
-    float x = sinTheta * std::cos(phi);
-    float y = sinTheta * std::sin(phi);
+    float sinPhi, cosPhi;
+    fastmath::sincos(phi, sinPhi, cosPhi);
+    float x = sinTheta * cosPhi;
+    float y = sinTheta * sinPhi;
     float z = cosTheta;
 
     return (x * T + y * B + z * N).normalize();
@@ -365,7 +377,7 @@ Vec3 Lambertian::computeSubsurfaceScattering(const Vec3& N, const Vec3& V, float
     float transmittance = std::exp(-thickness / subsurfaceRadius);
 
     // Malzemenin kenarlarnda ve ince ksmlarnda daha fazla k geii
-    float fresnel = std::pow(1.0f - cosTheta, 5.0f);
+    float fresnel = fastmath::pow5(1.0f - cosTheta);
     float thinness = 0.5f - thickness;
 
     // SSS younluunu hesapla
@@ -382,8 +394,10 @@ Vec3 Lambertian::computeScatterDirection(const Vec3& N, const Vec3& T, const Vec
     float r2 = random_double();
     float r2s = std::sqrt(r2);
 
-    float tx = r2s * std::cos(r1);
-    float ty = r2s * std::sin(r1);
+    float sinR1, cosR1;
+    fastmath::sincos(r1, sinR1, cosR1);
+    float tx = r2s * cosR1;
+    float ty = r2s * sinR1;
     float tz = std::sqrt(1 - r2);
 
     // Apply roughness
@@ -416,7 +430,7 @@ Vec3 Lambertian::random_in_unit_sphere() const {
     }
 }
 Vec3 Lambertian::computeFresnel(const Vec3& F0, float cosTheta) const {
-    float p = std::pow(1.0f - cosTheta, 5.0f);
+    float p = fastmath::pow5(1.0f - cosTheta);
     return F0 + (Vec3(1.0f, 1.0f, 1.0f) - F0) * p;
 }
 
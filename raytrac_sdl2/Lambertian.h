@@ -53,6 +53,7 @@ public:
     virtual MaterialType type() const override { return MaterialType::Lambertian; }
     virtual bool scatter(const Ray& r_in, const HitRecord& rec, Vec3& attenuation, Ray& scattered) const override;
     bool has_normal_map() const override { return normalProperty.texture != nullptr; }
+    bool is_pure_diffuse() const override;
     Vec3 get_normal_from_map(double u, double v) const override;
     float get_normal_strength() const override { return normalProperty.intensity; }
 
@@ -87,13 +88,13 @@ private:
 
     // New properties for PBR
     MaterialProperty specularProperty;
-    MaterialProperty emissionProperty;
-    float clearcoat;
-    float clearcoatRoughness;
-    float anisotropic;
+    MaterialProperty emissionProperty{ Vec3(0, 0, 0), 0.0f };   // black, only setEmission makes the surface emissive
+    float clearcoat = 0.0f;
+    float clearcoatRoughness = 0.0f;
+    float anisotropic = 0.0f;
     Vec3 anisotropicDirection;
     Vec3 subsurfaceColor;
-    float subsurfaceRadius;
+    float subsurfaceRadius = 0.0f;
      
     // Helper methods
     UVData transformUV(double u, double v) const;
@@ -3,6 +3,7 @@
 #include <locale>
 #include <SDL_image.h>
 #include "Renderer.h"
+#include "BinaryMesh.h"
 
 
 std::shared_ptr<ParallelBVHNode> build_bvh(const std::vector<std::shared_ptr<Hittable>>& objects, double time0, double time1) {
@@ -54,6 +55,187 @@ int main(int argc, char* argv[]) {
 
     setlocale(LC_ALL, "Turkish");
 
+    // raytrac_sdl2 --convert-mesh model.obj [model.rtmesh]: OBJ -> memory-mappable binary mesh
+    if (argc >= 3 && std::string(argv[1]) == "--convert-mesh") {
+        std::string output = argc >= 4 ? argv[3] : BinaryMesh::cachePath(argv[2]);
+        if (!BinaryMesh::convertObj(argv[2], output)) {
+            return 1;
+        }
+        std::cout << "Mesh written to " << output << std::endl;
+        return 0;
+    }
+
+    // raytrac_sdl2 --merge-exr out.exr part1.exr part2.exr ...: ayn karenin ksmi render'larn rnek saysna gre birletirir
+    if (argc >= 4 && std::string(argv[1]) == "--merge-exr") {
+        try {
+            std::vector<HdrImage::Image> parts;
+            for (int i = 3; i < argc; ++i) {
+                parts.push_back(HdrImage::readExr(argv[i]));
+            }
+            const HdrImage::Image merged = HdrImage::merge(parts);
+            if (!HdrImage::writeExr(argv[2], merged)) {
+                return 1;
+            }
+            std::cout << "Merged " << parts.size() << " renders (" << merged.samples << " samples) into " << argv[2] << std::endl;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Failed to merge EXR files: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // raytrac_sdl2 [--scene sahne.json] [--batch] [--profile trace.json] [--heatmap time|traversal] [--denoise] [--denoise-progressive] [--aov albedo,normal,...|all] [--hdr out.exr|out.pfm] [--hdr-half]
+    //              [--tonemap gamma|linear|srgb|reinhard|aces] [--exposure stops]
+    //              [--integrator path|wavefront|ao|direct|one_bounce|normal|uv|material] [--ao-distance d] [--shadow-glass thin|refract|opaque] [--no-packets] [--interleave] [--guiding] [--radiance-cache]
+    std::string scene_file = "default_scene.json";
+    std::string profile_file; // bo deilse Chrome trace_event kts buraya yazlr
+    std::string heatmap_metric;
+    bool batch = false; // true ise render bitince pencere beklemeden klr
+    bool denoise = false;
+    bool denoise_progressive = false;
+    std::string aov_list;
+    std::string hdr_file;
+    bool hdr_half = false;
+    std::string tonemap;
+    std::string exposure;
+    std::string integrator;
+    std::string ao_distance;
+    std::string shadow_glass;
+    bool no_packets = false;
+    bool interleave = false;
+    bool path_guiding = false;
+    bool radiance_cache = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--scene" && i + 1 < argc) {
+            scene_file = argv[++i];
+        }
+        else if (arg == "--batch") {
+            batch = true;
+        }
+        else if (arg == "--denoise") {
+            denoise = true;
+        }
+        else if (arg == "--denoise-progressive") {
+            denoise_progressive = true;
+        }
+        else if (arg == "--aov" && i + 1 < argc) {
+            aov_list = argv[++i];
+            try {
+                Aov::parseList(aov_list);
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--hdr" && i + 1 < argc) {
+            hdr_file = argv[++i];
+            if (!HdrImage::isHdrPath(hdr_file)) {
+                std::cerr << "Unknown HDR format: " << hdr_file << " (expected .exr or .pfm)" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--hdr-half") {
+            hdr_half = true;
+        }
+        else if (arg == "--tonemap" && i + 1 < argc) {
+            tonemap = argv[++i];
+            try {
+                DisplayTransform::parse(tonemap);
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--exposure" && i + 1 < argc) {
+            exposure = argv[++i];
+        }
+        else if (arg == "--integrator" && i + 1 < argc) {
+            integrator = argv[++i];
+            try {
+                Integrator::parse(integrator);
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--ao-distance" && i + 1 < argc) {
+            ao_distance = argv[++i];
+        }
+        else if (arg == "--shadow-glass" && i + 1 < argc) {
+            shadow_glass = argv[++i];
+            try {
+                Integrator::parseShadowGlass(shadow_glass);
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--no-packets") {
+            no_packets = true;
+        }
+        else if (arg == "--interleave") {
+            interleave = true;
+        }
+        else if (arg == "--guiding") {
+            path_guiding = true;
+        }
+        else if (arg == "--radiance-cache") {
+            radiance_cache = true;
+        }
+        else if (arg == "--profile" && i + 1 < argc) {
+            profile_file = argv[++i];
+        }
+        else if (arg == "--heatmap" && i + 1 < argc) {
+            heatmap_metric = argv[++i];
+            if (CostHeatmap::parseMetric(heatmap_metric) == CostMetric::None) {
+                std::cerr << "Unknown heatmap metric: " << heatmap_metric << " (expected time or traversal)" << std::endl;
+                return 1;
+            }
+        }
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (!profile_file.empty()) {
+        Profiler::instance().setEnabled(true);
+        Profiler::instance().setThreadName("main");
+    }
+
+    SceneDescription scene;
+    try {
+        scene = SceneLoader::load(scene_file);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to load scene: " << e.what() << std::endl;
+        return 1;
+    }
+    if (!heatmap_metric.empty()) {
+        scene.render.cost_heatmap = heatmap_metric;
+    }
+    if (denoise) scene.render.denoise = true;
+    if (denoise_progressive) scene.render.denoise_progressive = true;
+    if (!aov_list.empty()) scene.render.aovs = aov_list;
+    if (!hdr_file.empty()) scene.render.hdr_output = hdr_file;
+    if (hdr_half) scene.render.hdr_half = true;
+    if (!tonemap.empty()) scene.render.tonemap = tonemap;
+    if (!exposure.empty()) scene.render.exposure = std::atof(exposure.c_str());
+    if (!integrator.empty()) scene.render.integrator = integrator;
+    if (!ao_distance.empty()) scene.render.ao_distance = std::atof(ao_distance.c_str());
+    if (!shadow_glass.empty()) scene.render.shadow_glass = shadow_glass;
+    if (no_packets) scene.render.ray_packets = false;
+    if (interleave) scene.render.interleaved_traversal = true;
+    if (path_guiding) scene.render.path_guiding = true;
+    if (radiance_cache) scene.render.radiance_cache = true;
+    const RenderSettings& settings = scene.render;
+
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         std::cerr << "SDL_Init Error: " << SDL_GetError() << std::endl;
         return 1;
@@ -65,7 +247,7 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    SDL_Window* window = SDL_CreateWindow("Ray Tracing", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, image_width, image_height, SDL_WINDOW_SHOWN);
+    SDL_Window* window = SDL_CreateWindow("Ray Tracing", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, settings.width, settings.height, SDL_WINDOW_SHOWN);
     if (window == nullptr) {
         std::cerr << "SDL_CreateWindow Error: " << SDL_GetError() << std::endl;
         SDL_Quit();
@@ -84,8 +266,17 @@ int main(int argc, char* argv[]) {
     //int max_samples = 50;
     //int step = 5;
 
-    Renderer renderer(image_width, image_height, 30, 30);
-    renderer.render_image(surface, window, 100,5);
+    Renderer renderer(settings.width, settings.height, settings.max_depth);
+    renderer.set_scene(scene);
+    try {
+        renderer.render_image(surface, window, settings.samples_per_pixel, settings.samples_per_pass);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to build scene: " << e.what() << std::endl;
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
     /*for (int samples = 5; samples <= max_samples; samples += step) {
        
       
@@ -99,14 +290,29 @@ int main(int argc, char* argv[]) {
    
     //Renderer::render_image(surface, window);
     //SDL_UpdateWindowSurface(window);
-    if (SaveSurface(surface, "output.png")) {
+    if (!profile_file.empty()) {
+        Profiler::instance().printSummary();
+        if (Profiler::instance().writeChromeTrace(profile_file)) {
+            std::cout << "Profile trace written to " << profile_file << std::endl;
+        }
+    }
+    if (SaveSurface(surface, settings.output.c_str())) {
         std::cout << "Image saved successfully!" << std::endl;
     }
     else {
         std::cerr << "Failed to save image." << std::endl;
     }
+    if (renderer.has_cost_heatmap()) {
+        renderer.save_cost_heatmap(CostHeatmap::pathFor(settings.output));
+    }
+    if (renderer.aovs()) {
+        renderer.save_aovs(settings.output);
+    }
+    if (!settings.hdr_output.empty()) {
+        renderer.save_hdr(settings.hdr_output, settings.hdr_half);
+    }
     // Render ilemi bittikten sonra pencereyi ak tutan dng
-    bool quit = false;
+    bool quit = batch;
     SDL_Event e;
     while (!quit) {
         while (SDL_PollEvent(&e)) {
@@ -120,7 +326,7 @@ int main(int argc, char* argv[]) {
 
     SDL_FreeSurface(surface);
     SDL_DestroyWindow(window);
-    IMG_Quit();
+    TextureManager::instance().shutdown(); // texture nbelleini boaltr ve IMG_Quit arr
     SDL_Quit();
 
     return 0;
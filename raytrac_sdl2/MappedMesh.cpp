@@ -0,0 +1,126 @@
+#include "MappedMesh.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "RayStats.h"
+#include "Triangle.h"
+
+namespace {
+    // One pending sibling per level plus the two children of the deepest interior node
+    constexpr int MAX_TRAVERSAL_STACK = BinaryMesh::MAX_BVH_DEPTH + 1;
+
+    inline Vec3 loadVec3(const float* data, uint32_t index) {
+        return Vec3(data[index * 3], data[index * 3 + 1], data[index * 3 + 2]);
+    }
+}
+
+MappedMesh::MappedMesh(std::shared_ptr<BinaryMesh> mesh, std::vector<std::shared_ptr<Material>> materials)
+    : mesh(std::move(mesh)), materials(std::move(materials)) {
+    if (this->mesh->hasBVH()) {
+        nodes = this->mesh->bvhNodes();
+        node_count = this->mesh->bvhNodeCount();
+    }
+    else if (this->mesh->triangleCount() > 0) {
+        BinaryMesh::buildBVH(this->mesh->positions(), this->mesh->indices(), this->mesh->triangleCount(), built_nodes, triangle_order);
+        nodes = built_nodes.data();
+        node_count = built_nodes.size();
+    }
+}
+
+bool MappedMesh::intersectTriangle(uint32_t triangle, const Ray& r, double t_min, double t_max, double& t, double& u, double& v) const {
+    const uint32_t* index = mesh->indices() + triangle * 3;
+    const float* positions = mesh->positions();
+    return Triangle::intersect(positions + index[0] * 3, positions + index[1] * 3, positions + index[2] * 3, r, t_min, t_max, t, u, v);
+}
+
+void MappedMesh::fillHitRecord(uint32_t triangle, const Ray& r, double t, double u, double v, HitRecord& rec) const {
+    const uint32_t* index = mesh->indices() + triangle * 3;
+    const float* positions = mesh->positions();
+    const float* normals = mesh->normals();
+    const float* uvs = mesh->uvs();
+    const double w = 1.0 - u - v;
+
+    const Vec3 v0 = loadVec3(positions, index[0]);
+    rec.t = t;
+    rec.point = r.at(t);
+    rec.u = u;
+    rec.v = v;
+    rec.face_normal = Vec3::cross(loadVec3(positions, index[1]) - v0, loadVec3(positions, index[2]) - v0).normalize();
+
+    const Vec3 interpolated = w * loadVec3(normals, index[0]) + u * loadVec3(normals, index[1]) + v * loadVec3(normals, index[2]);
+    // Zero normals mark triangles that had no normals in the source file
+    rec.interpolated_normal = interpolated.length_squared() > 1e-12 ? interpolated.normalize() : rec.face_normal;
+
+    const int smooth_group = mesh->smoothGroups()[triangle];
+    rec.smoothGroup = smooth_group;
+    if (smooth_group > 0) {
+        // Angle <= 60 degrees compared as cosine >= cos(60) = 0.5, without the acos
+        rec.normal = (Vec3::dot(rec.interpolated_normal, rec.face_normal) >= 0.5) ? rec.interpolated_normal : rec.face_normal;
+    }
+    else if (smooth_group == 0) {
+        rec.normal = rec.interpolated_normal;
+    }
+    else {
+        rec.normal = rec.face_normal;
+    }
+    rec.set_face_normal(r, rec.normal);
+
+    // Vec2 has no copy assignment of its own, so the components are written directly
+    rec.uv.u = static_cast<float>(w * uvs[index[0] * 2] + u * uvs[index[1] * 2] + v * uvs[index[2] * 2]);
+    rec.uv.v = static_cast<float>(w * uvs[index[0] * 2 + 1] + u * uvs[index[1] * 2 + 1] + v * uvs[index[2] * 2 + 1]);
+
+    const uint32_t material_id = mesh->materialIds()[triangle];
+    if (material_id < materials.size()) rec.material = materials[material_id];
+    else rec.material = materials.empty() ? nullptr : materials.front();
+}
+
+bool MappedMesh::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const {
+    if (node_count == 0) return false;
+
+    const FloatRay float_ray(r);
+
+    uint32_t stack[MAX_TRAVERSAL_STACK];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    double closest = t_max;
+    double hit_u = 0.0, hit_v = 0.0;
+    uint32_t hit_triangle = UINT32_MAX;
+
+    while (stack_size > 0) {
+        const MeshBVHNode& node = nodes[stack[--stack_size]];
+        RAY_STAT_INC(node_visits);
+        if (!hit_float_box(node.bounds_min, node.bounds_max, float_ray, float(t_min), float(closest))) continue;
+
+        if (node.is_leaf()) {
+            for (uint32_t i = node.left_or_first; i < node.left_or_first + node.count; ++i) {
+                const uint32_t triangle = triangle_order.empty() ? i : triangle_order[i];
+                double t, u, v;
+                RAY_STAT_INC(triangle_tests);
+                if (intersectTriangle(triangle, r, t_min, closest, t, u, v)) {
+                    closest = t;
+                    hit_u = u;
+                    hit_v = v;
+                    hit_triangle = triangle;
+                }
+            }
+        }
+        else {
+            assert(stack_size + 2 <= MAX_TRAVERSAL_STACK); // open() rejects deeper files, median splits stay near log2(n)
+            stack[stack_size++] = node.left_or_first + 1;
+            stack[stack_size++] = node.left_or_first;
+        }
+    }
+
+    if (hit_triangle == UINT32_MAX) return false;
+    fillHitRecord(hit_triangle, r, closest, hit_u, hit_v, rec);
+    return true;
+}
+
+bool MappedMesh::bounding_box(double /*time0*/, double /*time1*/, AABB& output_box) const {
+    if (node_count == 0) return false;
+    const MeshBVHNode& root = nodes[0];
+    output_box = AABB(Vec3(root.bounds_min[0], root.bounds_min[1], root.bounds_min[2]),
+        Vec3(root.bounds_max[0], root.bounds_max[1], root.bounds_max[2]));
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "BinaryMesh.h"
+#include "Hittable.h"
+#include "Material.h"
+
+// Hittable that intersects a BinaryMesh in place.
+// Vertex data, index buffer and BVH are read straight from the mapped file;
+// nothing is converted into per-triangle objects. When the file carries no
+// BVH one is built in memory over the mapped triangles.
+class MappedMesh : public Hittable {
+public:
+    // materials are indexed by the file's material ids; ids past the end use the first entry
+    MappedMesh(std::shared_ptr<BinaryMesh> mesh, std::vector<std::shared_ptr<Material>> materials);
+
+    bool hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const override;
+    bool bounding_box(double time0, double time1, AABB& output_box) const override;
+
+    size_t triangleCount() const { return mesh->triangleCount(); }
+    const BinaryMesh& data() const { return *mesh; }
+
+private:
+    bool intersectTriangle(uint32_t triangle, const Ray& r, double t_min, double t_max, double& t, double& u, double& v) const;
+    void fillHitRecord(uint32_t triangle, const Ray& r, double t, double u, double v, HitRecord& rec) const;
+
+    std::shared_ptr<BinaryMesh> mesh;
+    std::vector<std::shared_ptr<Material>> materials;
+
+    const MeshBVHNode* nodes = nullptr;
+    size_t node_count = 0;
+    // Only used when the BVH is built at load time; mapped files are already in leaf order
+    std::vector<MeshBVHNode> built_nodes;
+    std::vector<uint32_t> triangle_order;
+};
@@ -61,6 +61,8 @@ public:
 
 
     virtual ~Material() = default;
+    // Material id AOV; sahne dosyas malzemeleri tanm srasna gre numaralar
+    int material_id = -1;
     MaterialProperty shininess;
     MaterialProperty metallic;
     virtual MaterialType type() const = 0;
@@ -83,6 +85,10 @@ public:
     virtual float getIOR() const { return ior; } // Yeni: Krlma indeksi
     virtual Vec3 getF0() const { return f0; } // Yeni: Fresnel yansma katsays
     virtual bool has_normal_map() const { return false; }
+    // BSDF normal etrafnda dz kosins lobu ve attenuation = f * cos / pdf ise true (yol rehberi ve ma nbellei bu keleri kullanr)
+    virtual bool is_pure_diffuse() const { return false; }
+    // Glge n bu yzeyden geerken kalan k oran; 0 opak demektir. thin false ise direction krlan yne evrilir
+    virtual Vec3 shadow_transmittance(const HitRecord& /*rec*/, Vec3& /*direction*/, bool /*thin*/) const { return Vec3(0, 0, 0); }
     virtual Vec3 get_normal_from_map(double u, double v) const { return Vec3(0, 0, 1); }
     virtual float get_normal_strength() const { return 1.0f; }
     virtual float get_shininess() const {
@@ -4,35 +4,41 @@
 #include "Lambertian.h"
 #include <algorithm>
 #include "globals.h"
-
-EnhancedMesh::EnhancedMesh(const ObjLoader::ObjMesh & objMesh, const std::unordered_map<std::string, std::unique_ptr<ObjLoader::ObjMaterial>>&materials) {
-    // Convert vertices
-    for (const auto& v : objMesh.vertices) {
-        vertices.emplace_back(v.x, v.y, v.z);
-    }
-
-    // Convert normals
-    for (const auto& n : objMesh.normals) {
-        normals.emplace_back(n.x, n.y, n.z);
-    }
-
-    // Convert texture coordinates
-    for (const auto& t : objMesh.texCoords) {
-        texCoords.emplace_back(t.u, t.v);
-    }
+#include "RayStats.h"
+
+EnhancedMesh::EnhancedMesh(const ObjLoader::ObjModel& model, const ObjLoader::ObjMesh& objMesh) {
+    // Vertex'ler model genelinde paylalr; bu mesh'in kullandklar yerel dizilere kopyalanr
+    std::unordered_map<int, int> vertexMap, normalMap, texCoordMap;
+    auto remap = [](int index, auto& map, auto& target, const auto& source, auto convert) {
+        if (index < 0 || static_cast<size_t>(index) >= source.size()) {
+            index = -1; // eksik znitelik varsaylan bir deere balanr
+        }
+        auto it = map.find(index);
+        if (it != map.end()) return it->second;
+        int local = static_cast<int>(target.size());
+        target.push_back(index < 0 ? decltype(convert(source[0]))() : convert(source[index]));
+        map.emplace(index, local);
+        return local;
+    };
+    auto toVec3 = [](const ObjLoader::ObjVec3& v) { return Vec3(v.x, v.y, v.z); };
+    auto toVec2 = [](const ObjLoader::ObjVec2& t) { return Vec2(t.u, t.v); };
 
     // Convert faces
-    for (const auto& f : objMesh.faces) {
+    faces.reserve(objMesh.triangleCount());
+    for (size_t i = 0; i + 2 < objMesh.indices.size(); i += 3) {
         Face face;
-        face.vertexIndices = f.vertexIndices;
-        face.normalIndices = f.normalIndices;
-        face.texCoordIndices = f.textureIndices;
-        faces.push_back(face);
+        for (size_t k = 0; k < 3; ++k) {
+            const ObjLoader::ObjIndex& index = objMesh.indices[i + k];
+            face.vertexIndices.push_back(remap(index.vertex, vertexMap, vertices, model.vertices, toVec3));
+            face.normalIndices.push_back(remap(index.normal, normalMap, normals, model.normals, toVec3));
+            face.texCoordIndices.push_back(remap(index.texCoord, texCoordMap, texCoords, model.texCoords, toVec2));
+        }
+        faces.push_back(std::move(face));
     }
 
     // Create material
-    auto materialIt = materials.find(objMesh.materialName);
-    if (materialIt != materials.end()) {
+    auto materialIt = model.materials.find(objMesh.materialName);
+    if (materialIt != model.materials.end()) {
         material = createMaterialFromObjMaterial(materialIt->second.get());
     }
     else {
@@ -48,6 +54,7 @@ bool EnhancedMesh::hit(const Ray& r, double t_min, double t_max, HitRecord& rec)
     auto closest_so_far = t_max;
 
     for (const auto& face : faces) {
+        RAY_STAT_INC(triangle_tests);
         if (rayTriangleIntersect(r, vertices[face.vertexIndices[0]], vertices[face.vertexIndices[1]], vertices[face.vertexIndices[2]],
             normals[face.normalIndices[0]], normals[face.normalIndices[1]], normals[face.normalIndices[2]],
             texCoords[face.texCoordIndices[0]], texCoords[face.texCoordIndices[1]], texCoords[face.texCoordIndices[2]],
@@ -82,7 +89,7 @@ bool EnhancedMesh::bounding_box(double time0, double time1, AABB& output_box) co
 std::vector<std::shared_ptr<EnhancedMesh>> EnhancedMesh::createFromObjModel(const ObjLoader::ObjModel& model) {
     std::vector<std::shared_ptr<EnhancedMesh>> meshes;
     for (const auto& objMesh : model.meshes) {
-        meshes.push_back(std::make_shared<EnhancedMesh>(*objMesh, model.materials));
+        meshes.push_back(std::make_shared<EnhancedMesh>(model, *objMesh));
     }
     return meshes;
 }
@@ -139,6 +146,7 @@ bool EnhancedMesh::rayTriangleIntersect(const Ray& r, const Vec3& v0, const Vec3
 
     // Interpolate normal and texture coordinates
     double w = 1.0 - u - v;
+    rec.face_normal = unit_vector(cross(edge1, edge2));
     rec.normal = unit_vector(w * n0 + u * n1 + v * n2);
     rec.set_face_normal(r, rec.normal);
     rec.u = w * t0.u + u * t1.u + v * t2.u;
@@ -13,7 +13,7 @@
 class EnhancedMesh : public Hittable {
 public:
     EnhancedMesh() = default;
-    explicit EnhancedMesh(const ObjLoader::ObjMesh& objMesh, const std::unordered_map<std::string, std::unique_ptr<ObjLoader::ObjMaterial>>& materials);
+    EnhancedMesh(const ObjLoader::ObjModel& model, const ObjLoader::ObjMesh& objMesh);
 
     bool hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const override;
     bool bounding_box(double time0, double time1, AABB& output_box) const override;
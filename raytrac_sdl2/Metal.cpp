@@ -3,6 +3,7 @@
 #include "Texture.h"
 #include <algorithm>
 #include "HittableList.h"
+#include "FastMath.h"
 // Constructor with Vec3 albedo
 Metal::Metal(const Vec3& albedo, float roughness, float metallic, float fuzz, float clearcoat)
     : albedoProperty(albedo), roughnessProperty(roughness), metallicProperty(metallic), fuzz(fuzz), clearcoat(clearcoat), clearcoatRoughness(0.1f), specularColor(Vec3(1.0f)), specularIntensity(1.0f), anisotropic(0.0f), anisotropicDirection(Vec3(1, 0, 0)) {}
@@ -75,33 +76,6 @@ Vec2 Metal::applyWrapMode(double u, double v) const {
     return Vec2(u, v);
 }
 
-float Metal::computeAmbientOcclusion(const Vec3& point, const Vec3& normal) const {
-    int numSamples = 16; // Number of samples for AO calculation
-    float aoRadius = 0.5f; // Radius of the AO sampling sphere
-    float occlusion = 0.0f;
-    HittableList world;
-    for (int i = 0; i < numSamples; ++i) {
-        // Generate a random direction in the hemisphere around the normal
-        Vec3 randomDir = random_in_hemisphere(normal);
-
-        // Create a small offset to avoid self-intersection
-        Vec3 samplePoint = point + normal * 0.001f;
-
-        // Cast a ray from the sample point in the random direction
-        Ray aoRay(samplePoint, randomDir);
-
-        // Check if the ray intersects any geometry
-        HitRecord tempRec;
-        if (world.hit(aoRay, 0.001f, aoRadius, tempRec)) {
-            occlusion += 1.0f;
-        }
-    }
-
-    // Compute the final ambient occlusion factor
-    float ao = 1.0f - (occlusion / float(numSamples));
-    return ao;
-}
-
 // Random direction in hemisphere around a normal
 Vec3 Metal::random_in_hemisphere(const Vec3& normal) const {
     Vec3 inUnitSphere = random_in_unit_sphere();
@@ -152,9 +126,6 @@ bool Metal::scatter(const Ray& r_in, const HitRecord& rec, Vec3& attenuation, Ra
     Vec3 emissionValue = getPropertyValue(emissionProperty, transformedUV);
     attenuation += emissionValue;
 
-    float ao = computeAmbientOcclusion(rec.point, N);
-    attenuation *= ao;
-
     if (clearcoat > 0.0f) {
         Vec3 clearcoatReflection = computeClearcoat(R, N);
         float clearcoatFactor = clearcoat * (1.0f - metallicValue);
@@ -199,7 +170,7 @@ float Metal::GeometrySmith(const Vec3& N, const Vec3& V, const Vec3& L, float ro
 }
 
 Vec3 Metal::fresnelSchlick(float cosTheta, const Vec3& F0) const {
-    return F0 + (Vec3(1.0) - F0) * std::pow(1.0 - cosTheta, 1.0);
+    return F0 + (Vec3(1.0) - F0) * (1.0 - cosTheta);
 }
 
 Vec3 Metal::computeClearcoat(const Vec3& R, const Vec3& N) const {
@@ -270,7 +241,9 @@ Vec3 Metal::computeAnisotropicDirection(const Vec3& N, const Vec3& T, const Vec3
     float cosTheta = pow(1 - random_double(), 1 / (roughness * anisotropy + 1));
     float sinTheta = sqrt(1 - cosTheta * cosTheta);
 
-    Vec3 anisotropicDirection = sinTheta * cos(phi) * T + sinTheta * sin(phi) * B + cosTheta * N;
+    float sinPhi, cosPhi;
+    fastmath::sincos(phi, sinPhi, cosPhi);
+    Vec3 anisotropicDirection = sinTheta * cosPhi * T + sinTheta * sinPhi * B + cosTheta * N;
     return anisotropicDirection;
 }
 void Metal::createCoordinateSystem(const Vec3& N, Vec3& T, Vec3& B) const {
@@ -76,7 +76,6 @@ private:
     // Helper methods
     float max(float a, float b) const { return a > b ? a : b; }
     Vec2 applyWrapMode(double u, double v) const;
-    float computeAmbientOcclusion(const Vec3& point, const Vec3& normal) const;
     Vec3 computeClearcoat(const Vec3& reflected, const Vec3& normal) const;
     Vec3 computeScatterDirection(const Vec3& N, const Vec3& T, const Vec3& B, float roughness) const;
     void createCoordinateSystem(const Vec3& N, Vec3& T, Vec3& B) const;
@@ -0,0 +1,716 @@
+#include "MicroBench.h"
+#include <SDL.h>
+#include <SDL_image.h>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include "AABB.h"
+#include "Box.h"
+#include "Camera.h"
+#include "Dielectric.h"
+#include "FastMath.h"
+#include "globals.h"
+#include "Lambertian.h"
+#include "Metal.h"
+#include "Sphere.h"
+#include "Texture.h"
+#include "Triangle.h"
+#include "Vec3SIMD.h"
+#include "Vec3x8.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Power of two so kernels can wrap with a mask instead of a modulo
+    constexpr size_t kPoolSize = 4096;
+    constexpr size_t kPoolMask = kPoolSize - 1;
+
+    struct Pool {
+        std::mt19937 rng{ 0x5EED1234u };
+        std::uniform_real_distribution<double> unit{ 0.0, 1.0 };
+
+        double uniform(double lo, double hi) { return lo + (hi - lo) * unit(rng); }
+        Vec3 inBox(double extent) { return Vec3(uniform(-extent, extent), uniform(-extent, extent), uniform(-extent, extent)); }
+        Vec3 onSphere(double radius) {
+            const double z = uniform(-1.0, 1.0);
+            const double phi = uniform(0.0, 2.0 * M_PI);
+            const double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+            return Vec3(r * std::cos(phi), r * std::sin(phi), z) * radius;
+        }
+        // Ray starting outside the scene, aimed at a point jittered around `target`.
+        // The jitter controls the hit/miss mix.
+        Ray rayToward(const Vec3& target, double jitter) {
+            const Vec3 origin = target + onSphere(5.0);
+            const Vec3 aim = target + inBox(jitter);
+            return Ray(origin, (aim - origin).normalize());
+        }
+    };
+
+    std::string hitRateLabel(size_t hits, size_t total) {
+        std::ostringstream label;
+        label << "hit rate " << std::fixed << std::setprecision(0) << 100.0 * hits / std::max<size_t>(total, 1) << "%";
+        return label.str();
+    }
+
+    double sum(const Vec3& v) { return v.x + v.y + v.z; }
+
+    // Structure-of-arrays float copy of a pool of vectors for the eight-wide kernels
+    struct SoA3 {
+        std::vector<float> x, y, z;
+        void push(const Vec3& v) {
+            x.push_back(static_cast<float>(v.x));
+            y.push_back(static_cast<float>(v.y));
+            z.push_back(static_cast<float>(v.z));
+        }
+        Vec3x8 load(size_t k) const { return Vec3x8::load(&x[k], &y[k], &z[k]); }
+    };
+
+    double sum(const Floatx8& v) {
+        double acc = 0.0;
+        for (int i = 0; i < 8; ++i) acc += v[i];
+        return acc;
+    }
+
+    // Double, float and eight-wide slab tests over the same boxes and rays. The x8 kernel advances
+    // eight rays per step, so all of them report the time per ray
+    std::vector<MicroBench::Case> aabbCases() {
+        Pool pool;
+        auto boxes = std::make_shared<std::vector<AABB>>();
+        auto rays = std::make_shared<std::vector<Ray>>();
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            const Vec3 center = pool.inBox(2.0);
+            const Vec3 half(pool.uniform(0.1, 1.0), pool.uniform(0.1, 1.0), pool.uniform(0.1, 1.0));
+            boxes->push_back(AABB(center - half, center + half));
+            rays->push_back(pool.rayToward(center, 1.5));
+        }
+        size_t hits = 0;
+        for (size_t i = 0; i < kPoolSize; ++i) hits += (*boxes)[i].hit((*rays)[i], 0.001, 1e30);
+
+        auto soa = std::make_shared<std::vector<SoA3>>(4);   // lo, hi, origin, inverse direction
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            const Vec3& d = (*rays)[i].direction;
+            (*soa)[0].push((*boxes)[i].min);
+            (*soa)[1].push((*boxes)[i].max);
+            (*soa)[2].push((*rays)[i].origin);
+            (*soa)[3].push(Vec3(1.0 / d.x, 1.0 / d.y, 1.0 / d.z));
+        }
+
+        std::vector<MicroBench::Case> cases;
+        cases.push_back({ "aabb/hit", hitRateLabel(hits, kPoolSize), [boxes, rays](uint64_t iterations) {
+            uint64_t count = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const size_t k = i & kPoolMask;
+                count += (*boxes)[k].hit((*rays)[k], 0.001, 1e30);
+            }
+            return static_cast<double>(count);
+        } });
+        auto float_boxes = std::make_shared<std::vector<FloatAABB>>();
+        auto float_rays = std::make_shared<std::vector<FloatRay>>();
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            float_boxes->emplace_back((*boxes)[i]);
+            float_rays->emplace_back((*rays)[i]);
+        }
+        cases.push_back({ "aabb/hit_float", "BVH node test, " + hitRateLabel(hits, kPoolSize), [float_boxes, float_rays](uint64_t iterations) {
+            uint64_t count = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const size_t k = i & kPoolMask;
+                count += (*float_boxes)[k].hit((*float_rays)[k], 0.001f, 1e30f);
+            }
+            return static_cast<double>(count);
+        } });
+        cases.push_back({ "aabb/hit_x8", "float x8, " + hitRateLabel(hits, kPoolSize), [soa](uint64_t iterations) {
+            const SoA3 &lo = (*soa)[0], &hi = (*soa)[1], &origin = (*soa)[2], &inv = (*soa)[3];
+            uint64_t count = 0;
+            for (uint64_t i = 0; i < iterations; i += 8) {
+                const size_t k = i & kPoolMask;
+                Floatx8 t_near(0.001f), t_far(1e30f);
+                clipToBox(origin.load(k), inv.load(k), lo.load(k), hi.load(k), t_near, t_far);
+                count += std::popcount(static_cast<unsigned>((t_near <= t_far).bits()));
+            }
+            return static_cast<double>(count);
+        } });
+        return cases;
+    }
+
+    // Shared driver for Hittable primitives: one primitive per ray, results folded into t.
+    template <typename T>
+    MicroBench::Case hittableCase(const std::string& name, std::shared_ptr<std::vector<T>> prims, std::shared_ptr<std::vector<Ray>> rays) {
+        size_t hits = 0;
+        HitRecord rec;
+        for (size_t i = 0; i < kPoolSize; ++i) hits += (*prims)[i].hit((*rays)[i], 0.001, 1e30, rec);
+
+        return { name, hitRateLabel(hits, kPoolSize), [prims, rays](uint64_t iterations) {
+            HitRecord rec;
+            double acc = 0.0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const size_t k = i & kPoolMask;
+                if ((*prims)[k].hit((*rays)[k], 0.001, 1e30, rec)) acc += rec.t;
+            }
+            return acc;
+        } };
+    }
+
+    std::vector<MicroBench::Case> triangleCases(const std::shared_ptr<Material>& material) {
+        Pool pool;
+        auto triangles = std::make_shared<std::vector<Triangle>>();
+        auto rays = std::make_shared<std::vector<Ray>>();
+        auto soa = std::make_shared<std::vector<SoA3>>(5);   // v0, v1, v2, origin, direction
+        triangles->reserve(kPoolSize);
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            const Vec3 center = pool.inBox(2.0);
+            const double size = pool.uniform(0.05, 0.6);
+            const Vec3 a = center + pool.inBox(size), b = center + pool.inBox(size), c = center + pool.inBox(size);
+            triangles->emplace_back(a, b, c, material);
+            // Aim at a random point on the triangle; the jitter pushes roughly half of the rays off it
+            double u = pool.unit(pool.rng), v = pool.unit(pool.rng);
+            if (u + v > 1.0) { u = 1.0 - u; v = 1.0 - v; }
+            rays->push_back(pool.rayToward(a + (b - a) * u + (c - a) * v, 0.3 * size));
+            (*soa)[0].push(a);
+            (*soa)[1].push(b);
+            (*soa)[2].push(c);
+            (*soa)[3].push(rays->back().origin);
+            (*soa)[4].push(rays->back().direction);
+        }
+
+        std::vector<MicroBench::Case> cases;
+        cases.push_back(hittableCase("triangle/hit", triangles, rays));
+        cases.push_back({ "triangle/hit_x8", "float x8, Moller-Trumbore only", [soa](uint64_t iterations) {
+            const SoA3 &v0 = (*soa)[0], &v1 = (*soa)[1], &v2 = (*soa)[2], &origin = (*soa)[3], &direction = (*soa)[4];
+            Hitx8 hit{ Floatx8(0.0f), Floatx8(0.0f), Floatx8(0.0f) };
+            Floatx8 acc(0.0f);
+            for (uint64_t i = 0; i < iterations; i += 8) {
+                const size_t k = i & kPoolMask;
+                const Rayx8 r(origin.load(k), direction.load(k));
+                const Maskx8 hits = hitTriangle(r, v0.load(k), v1.load(k), v2.load(k), Floatx8(0.001f), Floatx8(1e30f), EPSILON, hit);
+                acc += select(hits, hit.t, Floatx8(0.0f));
+            }
+            return sum(acc);
+        } });
+        return cases;
+    }
+
+    MicroBench::Case sphereCase(const std::shared_ptr<Material>& material) {
+        Pool pool;
+        auto spheres = std::make_shared<std::vector<Sphere>>();
+        auto rays = std::make_shared<std::vector<Ray>>();
+        spheres->reserve(kPoolSize);
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            const Vec3 center = pool.inBox(2.0);
+            const double radius = pool.uniform(0.1, 1.0);
+            spheres->emplace_back(center, radius, material);
+            rays->push_back(pool.rayToward(center, 1.5 * radius));
+        }
+        return hittableCase("sphere/hit", spheres, rays);
+    }
+
+    MicroBench::Case boxCase(const std::shared_ptr<Material>& material) {
+        Pool pool;
+        auto boxes = std::make_shared<std::vector<Box>>();
+        auto rays = std::make_shared<std::vector<Ray>>();
+        boxes->reserve(kPoolSize);
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            const Vec3 center = pool.inBox(2.0);
+            const double size = pool.uniform(0.1, 1.0);
+            boxes->emplace_back(center, size, material);
+            rays->push_back(pool.rayToward(center, size));
+        }
+        return hittableCase("box/hit", boxes, rays);
+    }
+
+    // Same shading-style expression (cross, normalize, reflect, scale-accumulate) on both vector types
+    std::vector<MicroBench::Case> vectorCases() {
+        Pool pool;
+        auto a = std::make_shared<std::vector<Vec3>>();
+        auto b = std::make_shared<std::vector<Vec3>>();
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            a->push_back(pool.inBox(1.0));
+            b->push_back(pool.onSphere(1.0));
+        }
+        auto sa = std::make_shared<std::vector<Vec3SIMD>>(a->begin(), a->end());
+        auto sb = std::make_shared<std::vector<Vec3SIMD>>(b->begin(), b->end());
+
+        std::vector<MicroBench::Case> cases;
+        cases.push_back({ "vec3/cross_normalize_reflect", "double", [a, b](uint64_t iterations) {
+            Vec3 acc(0, 0, 0);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const size_t k = i & kPoolMask;
+                const Vec3& u = (*a)[k];
+                const Vec3 n = Vec3::cross(u, (*b)[k]).normalize();
+                acc += (u - 2.0 * Vec3::dot(u, n) * n) * 0.5;
+            }
+            return sum(acc);
+        } });
+        cases.push_back({ "vec3simd/cross_normalize_reflect", "float x4", [sa, sb](uint64_t iterations) {
+            Vec3SIMD acc(0.0f, 0.0f, 0.0f);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const size_t k = i & kPoolMask;
+                const Vec3SIMD& u = (*sa)[k];
+                const Vec3SIMD n = cross(u, (*sb)[k]).normalize();
+                acc += (u - 2.0f * dot(u, n) * n) * 0.5f;
+            }
+            return static_cast<double>(acc.x() + acc.y() + acc.z());
+        } });
+        auto pa = std::make_shared<SoA3>(), pb = std::make_shared<SoA3>();
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            pa->push((*a)[i]);
+            pb->push((*b)[i]);
+        }
+        cases.push_back({ "vec3x8/cross_normalize_reflect", "float x8", [pa, pb](uint64_t iterations) {
+            Vec3x8 acc(Floatx8(0.0f), Floatx8(0.0f), Floatx8(0.0f));
+            for (uint64_t i = 0; i < iterations; i += 8) {
+                const size_t k = i & kPoolMask;
+                const Vec3x8 u = pa->load(k);
+                const Vec3x8 n = normalize(cross(u, pb->load(k)));
+                acc += (u - Floatx8(2.0f) * dot(u, n) * n) * Floatx8(0.5f);
+            }
+            return sum(acc.x) + sum(acc.y) + sum(acc.z);
+        } });
+        return cases;
+    }
+
+    // 1024x1024 procedural texture written to the temp directory and loaded through Texture
+    std::shared_ptr<Texture> makeTexture() {
+        const int size = 1024;
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 24, SDL_PIXELFORMAT_RGB24);
+        if (!surface) return nullptr;
+        SDL_LockSurface(surface);
+        for (int y = 0; y < size; ++y) {
+            Uint8* row = static_cast<Uint8*>(surface->pixels) + y * surface->pitch;
+            for (int x = 0; x < size; ++x) {
+                row[x * 3 + 0] = static_cast<Uint8>(x ^ y);
+                row[x * 3 + 1] = static_cast<Uint8>((x * 3) & 0xFF);
+                row[x * 3 + 2] = static_cast<Uint8>((y * 5) & 0xFF);
+            }
+        }
+        SDL_UnlockSurface(surface);
+        const std::string path = (std::filesystem::temp_directory_path() / "raytrace_microbench_texture.png").string();
+        const bool saved = IMG_SavePNG(surface, path.c_str()) == 0;
+        SDL_FreeSurface(surface);
+        if (!saved) return nullptr;
+        auto texture = std::make_shared<Texture>(path);
+        return texture->is_loaded() ? texture : nullptr;
+    }
+
+    std::vector<MicroBench::Case> textureCases(const std::shared_ptr<Texture>& texture) {
+        Pool pool;
+        auto uvs = std::make_shared<std::vector<Vec2>>();
+        for (size_t i = 0; i < kPoolSize; ++i) uvs->push_back(Vec2(pool.unit(pool.rng), pool.unit(pool.rng)));
+
+        std::vector<MicroBench::Case> cases;
+        cases.push_back({ "texture/get_color_random", "1024x1024, uniform uv", [texture, uvs](uint64_t iterations) {
+            double acc = 0.0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const Vec2& uv = (*uvs)[i & kPoolMask];
+                acc += sum(texture->get_color(uv.u, uv.v));
+            }
+            return acc;
+        } });
+        cases.push_back({ "texture/get_color_coherent", "1024x1024, scanline uv", [texture](uint64_t iterations) {
+            double acc = 0.0;
+            const double step = 1.0 / 1024.0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const uint64_t k = i & 0xFFFFF;
+                acc += sum(texture->get_color((k & 1023) * step, (k >> 10) * step));
+            }
+            return acc;
+        } });
+        auto us = std::make_shared<std::vector<float>>(), vs = std::make_shared<std::vector<float>>();
+        for (const Vec2& uv : *uvs) {
+            us->push_back(static_cast<float>(uv.u));
+            vs->push_back(static_cast<float>(uv.v));
+        }
+        cases.push_back({ "texture/get_color_x8", "1024x1024, uniform uv, float x8", [texture, us, vs](uint64_t iterations) {
+            Floatx8 acc(0.0f);
+            alignas(32) float r[8], g[8], b[8];
+            for (uint64_t i = 0; i < iterations; i += 8) {
+                const size_t k = i & kPoolMask;
+                texture->get_color8(&(*us)[k], &(*vs)[k], r, g, b);
+                acc += Floatx8::load(r) + Floatx8::load(g) + Floatx8::load(b);
+            }
+            return sum(acc);
+        } });
+        return cases;
+    }
+
+    // Front-facing hits with random normals, incoming directions in the opposite hemisphere
+    MicroBench::Case scatterCase(const std::string& name, const std::shared_ptr<Material>& material) {
+        Pool pool;
+        auto records = std::make_shared<std::vector<HitRecord>>(kPoolSize);
+        auto rays = std::make_shared<std::vector<Ray>>();
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            HitRecord& rec = (*records)[i];
+            rec.point = pool.inBox(2.0);
+            const Vec3 normal = pool.onSphere(1.0);
+            Vec3 direction = pool.onSphere(1.0);
+            if (Vec3::dot(direction, normal) > 0) direction = -direction;
+            const Ray ray(rec.point - direction * pool.uniform(1.0, 5.0), direction);
+            rec.t = 1.0;
+            rec.u = pool.unit(pool.rng);
+            rec.v = pool.unit(pool.rng);
+            rec.uv.u = static_cast<float>(rec.u);
+            rec.uv.v = static_cast<float>(rec.v);
+            rec.material = material;
+            rec.set_face_normal(ray, normal);
+            rec.interpolated_normal = rec.face_normal = rec.normal;
+            rays->push_back(ray);
+        }
+        return { name, "random normal, opposite-hemisphere incoming ray", [material, records, rays](uint64_t iterations) {
+            double acc = 0.0;
+            Vec3 attenuation;
+            Ray scattered;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const size_t k = i & kPoolMask;
+                if (material->scatter((*rays)[k], (*records)[k], attenuation, scattered))
+                    acc += sum(attenuation) + scattered.direction.x;
+            }
+            return acc;
+        } };
+    }
+
+    MicroBench::Case cameraCase() {
+        Pool pool;
+        auto camera = std::make_shared<Camera>(Vec3(0, 1, 5), Vec3(0, 0, 0), Vec3(0, 1, 0), 40.0, 16.0 / 9.0, 0.1, 5.0);
+        auto st = std::make_shared<std::vector<Vec2>>();
+        for (size_t i = 0; i < kPoolSize; ++i) st->push_back(Vec2(pool.unit(pool.rng), pool.unit(pool.rng)));
+        return { "camera/get_ray", "thin lens, aperture 0.1", [camera, st](uint64_t iterations) {
+            double acc = 0.0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const Vec2& s = (*st)[i & kPoolMask];
+                acc += camera->get_ray(s.u, s.v).direction.z;
+            }
+            return acc;
+        } };
+    }
+
+    // <cmath>, FastMath scalar (when it has one) and FastMath x8 versions of one function over the same pool of arguments
+    std::vector<MicroBench::Case> fastMathCases(const std::string& name, const std::string& label, std::function<float(Pool&)> sample_x,
+        std::function<float(Pool&)> sample_y, std::function<float(float, float)> standard, std::function<float(float, float)> scalar,
+        std::function<Floatx8(const Floatx8&, const Floatx8&)> wide) {
+        Pool pool;
+        auto xs = std::make_shared<std::vector<float>>(), ys = std::make_shared<std::vector<float>>();
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            xs->push_back(sample_x(pool));
+            ys->push_back(sample_y(pool));
+        }
+        auto loop = [xs, ys](std::function<float(float, float)> fn) {
+            return [xs, ys, fn](uint64_t iterations) {
+                double acc = 0.0;
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    const size_t k = i & kPoolMask;
+                    acc += fn((*xs)[k], (*ys)[k]);
+                }
+                return acc;
+            };
+        };
+        std::vector<MicroBench::Case> cases;
+        cases.push_back({ "std/" + name, label, loop(standard) });
+        if (scalar) cases.push_back({ "fastmath/" + name, label, loop(scalar) });
+        cases.push_back({ "fastmath/" + name + "_x8", label + ", float x8", [xs, ys, wide](uint64_t iterations) {
+            Floatx8 acc(0.0f);
+            for (uint64_t i = 0; i < iterations; i += 8) {
+                const size_t k = i & kPoolMask;
+                acc += wide(Floatx8::load(&(*xs)[k]), Floatx8::load(&(*ys)[k]));
+            }
+            return sum(acc);
+        } });
+        return cases;
+    }
+
+    // Argument distributions shared by the timing cases and the accuracy checks
+    float expArgument(Pool& pool) { return static_cast<float>(pool.uniform(-20.0, 5.0)); }
+    float logArgument(Pool& pool) { return static_cast<float>(std::exp2(pool.uniform(-30.0, 30.0))); }
+    float powBase(Pool& pool) { return static_cast<float>(pool.unit(pool.rng)); }
+    float powExponent(Pool& pool) { return static_cast<float>(pool.uniform(1.0, 256.0)); }
+    float unitArgument(Pool& pool) { return static_cast<float>(pool.uniform(-1.0, 1.0)); }
+    float atanArgument(Pool& pool) { return static_cast<float>(pool.uniform(-10.0, 10.0)); }
+    float angleArgument(Pool& pool) { return static_cast<float>(pool.uniform(-2.0 * M_PI, 2.0 * M_PI)); }
+    float unused(Pool&) { return 0.0f; }
+
+    std::vector<MicroBench::Case> transcendentalCases() {
+        std::vector<MicroBench::Case> cases;
+        auto add = [&](std::vector<MicroBench::Case> more) { for (auto& c : more) cases.push_back(std::move(c)); };
+        add(fastMathCases("exp", "x in [-20, 5]", expArgument, unused,
+            [](float x, float) { return std::exp(x); }, nullptr,
+            [](const Floatx8& x, const Floatx8&) { return fastmath::exp(x); }));
+        add(fastMathCases("log", "x log-uniform in [2^-30, 2^30]", logArgument, unused,
+            [](float x, float) { return std::log(x); }, nullptr,
+            [](const Floatx8& x, const Floatx8&) { return fastmath::log(x); }));
+        add(fastMathCases("pow", "x in [0, 1], y in [1, 256]", powBase, powExponent,
+            [](float x, float y) { return std::pow(x, y); }, nullptr,
+            [](const Floatx8& x, const Floatx8& y) { return fastmath::pow(x, y); }));
+        add(fastMathCases("acos", "x in [-1, 1]", unitArgument, unused,
+            [](float x, float) { return std::acos(x); }, [](float x, float) { return fastmath::acos(x); },
+            [](const Floatx8& x, const Floatx8&) { return fastmath::acos(x); }));
+        add(fastMathCases("atan2", "y, x in [-10, 10]", atanArgument, atanArgument,
+            [](float y, float x) { return std::atan2(y, x); }, [](float y, float x) { return fastmath::atan2(y, x); },
+            [](const Floatx8& y, const Floatx8& x) { return fastmath::atan2(y, x); }));
+        add(fastMathCases("sincos", "x in [-2pi, 2pi]", angleArgument, unused,
+            [](float x, float) { return std::sin(x) + std::cos(x); },
+            [](float x, float) { float s, c; fastmath::sincos(x, s, c); return s + c; },
+            [](const Floatx8& x, const Floatx8&) { Floatx8 s, c; fastmath::sincos(x, s, c); return s + c; }));
+        return cases;
+    }
+
+    // One FastMath function checked against double precision <cmath>: |error| <= absolute + relative * |exact|,
+    // where pow also allows for the rounding of y * log(x)
+    struct AccuracyCheck {
+        std::string name;
+        std::string domain;
+        std::function<float(Pool&)> sample_x, sample_y;
+        std::vector<std::pair<float, float>> edges;        // arguments tested besides the random ones
+        std::function<void(const float* x, const float* y, float* out)> approximate;   // eight at a time
+        std::function<double(double x, double y)> exact;
+        double absolute = 0.0, relative = 0.0, per_log = 0.0;
+    };
+
+    std::vector<AccuracyCheck> accuracyChecks() {
+        auto scalar = [](float (*fn)(float)) {
+            return [fn](const float* x, const float*, float* out) { for (int i = 0; i < 8; ++i) out[i] = fn(x[i]); };
+        };
+        auto wide = [](Floatx8 (*fn)(const Floatx8&)) {
+            return [fn](const float* x, const float*, float* out) { fn(Floatx8::load(x)).store(out); };
+        };
+        auto uniform = [](double lo, double hi) { return [lo, hi](Pool& pool) { return static_cast<float>(pool.uniform(lo, hi)); }; };
+        auto logUniform = [](double lo, double hi) { return [lo, hi](Pool& pool) { return static_cast<float>(std::exp2(pool.uniform(lo, hi))); }; };
+
+        std::vector<AccuracyCheck> checks;
+        const std::vector<std::pair<float, float>> exp_edges = { { -87.33654f, 0.0f }, { 88.0f, 0.0f }, { 0.0f, 0.0f }, { -1e-8f, 0.0f } };
+        checks.push_back({ "exp_x8", "[ln(FLT_MIN), 88]", uniform(-87.33654, 88.0), unused, exp_edges, wide(fastmath::exp),
+            [](double x, double) { return std::exp(x); }, 0.0, 3e-7 });
+
+        const std::vector<std::pair<float, float>> log_edges = { { 1.0f, 0.0f }, { std::numeric_limits<float>::min(), 0.0f },
+            { std::numeric_limits<float>::denorm_min(), 0.0f }, { std::numeric_limits<float>::max(), 0.0f }, { 0.70710677f, 0.0f } };
+        checks.push_back({ "log_x8", "(0, FLT_MAX]", logUniform(-149.0, 128.0), unused, log_edges, wide(fastmath::log),
+            [](double x, double) { return std::log(x); }, 0.0, 3e-7 });
+        checks.push_back({ "log_x8", "[0.5, 2]", uniform(0.5, 2.0), unused, {}, wide(fastmath::log),
+            [](double x, double) { return std::log(x); }, 1e-7, 3e-7 });
+
+        const std::vector<std::pair<float, float>> pow_edges = { { 0.0f, 5.0f }, { 1.0f, 1000.0f }, { 0.5f, 0.0f }, { 1e-3f, 3.0f } };
+        auto powWide = [](const float* x, const float* y, float* out) { fastmath::pow(Floatx8::load(x), Floatx8::load(y)).store(out); };
+        checks.push_back({ "pow_x8", "x [0, 1], y [0, 1000]", uniform(0.0, 1.0), uniform(0.0, 1000.0), pow_edges, powWide,
+            [](double x, double y) { return std::pow(x, y); }, std::numeric_limits<float>::min(), 2e-6, 4e-7 });
+        checks.push_back({ "pow_x8", "x [0, 16], y [-8, 8]", uniform(0.0, 16.0), uniform(-8.0, 8.0), {}, powWide,
+            [](double x, double y) { return std::pow(x, y); }, std::numeric_limits<float>::min(), 2e-6, 4e-7 });
+
+        const std::vector<std::pair<float, float>> unit_edges = { { -1.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f }, { 0.99999994f, 0.0f }, { -0.99999994f, 0.0f } };
+        checks.push_back({ "acos", "[-1, 1]", uniform(-1.0, 1.0), unused, unit_edges, scalar(fastmath::acos),
+            [](double x, double) { return std::acos(x); }, 5e-7, 0.0 });
+        checks.push_back({ "acos_x8", "[-1, 1]", uniform(-1.0, 1.0), unused, unit_edges, wide(fastmath::acos),
+            [](double x, double) { return std::acos(x); }, 5e-7, 0.0 });
+        checks.push_back({ "asin", "[-1, 1]", uniform(-1.0, 1.0), unused, unit_edges, scalar(fastmath::asin),
+            [](double x, double) { return std::asin(x); }, 5e-7, 0.0 });
+        checks.push_back({ "asin_x8", "[-1, 1]", uniform(-1.0, 1.0), unused, unit_edges, wide(fastmath::asin),
+            [](double x, double) { return std::asin(x); }, 5e-7, 0.0 });
+
+        const std::vector<std::pair<float, float>> atan_edges = { { 0.0f, 1.0f }, { 0.0f, -1.0f }, { 1.0f, 0.0f }, { -1.0f, 0.0f },
+            { 1.0f, 1.0f }, { -1.0f, -1.0f }, { 0.0f, 0.0f }, { 1e-30f, -1.0f }, { -1e-30f, -1.0f } };
+        auto atanScalar = [](const float* y, const float* x, float* out) { for (int i = 0; i < 8; ++i) out[i] = fastmath::atan2(y[i], x[i]); };
+        auto atanWide = [](const float* y, const float* x, float* out) { fastmath::atan2(Floatx8::load(y), Floatx8::load(x)).store(out); };
+        checks.push_back({ "atan2", "y, x [-1e3, 1e3]", uniform(-1e3, 1e3), uniform(-1e3, 1e3), atan_edges, atanScalar,
+            [](double y, double x) { return std::atan2(y, x); }, 3e-7, 0.0 });
+        checks.push_back({ "atan2", "y [-1e-3, 1e-3], x [-1, 1]", uniform(-1e-3, 1e-3), uniform(-1.0, 1.0), {}, atanScalar,
+            [](double y, double x) { return std::atan2(y, x); }, 3e-7, 0.0 });
+        checks.push_back({ "atan2_x8", "y, x [-1e3, 1e3]", uniform(-1e3, 1e3), uniform(-1e3, 1e3), atan_edges, atanWide,
+            [](double y, double x) { return std::atan2(y, x); }, 3e-7, 0.0 });
+
+        const std::vector<std::pair<float, float>> angle_edges = { { 0.0f, 0.0f }, { 3.14159274f, 0.0f }, { -1.57079637f, 0.0f }, { 8192.0f, 0.0f } };
+        auto sinScalar = [](const float* x, const float*, float* out) { for (int i = 0; i < 8; ++i) out[i] = fastmath::sin(x[i]); };
+        auto cosScalar = [](const float* x, const float*, float* out) { for (int i = 0; i < 8; ++i) out[i] = fastmath::cos(x[i]); };
+        auto sinWide = [](const float* x, const float*, float* out) { Floatx8 s, c; fastmath::sincos(Floatx8::load(x), s, c); s.store(out); };
+        auto cosWide = [](const float* x, const float*, float* out) { Floatx8 s, c; fastmath::sincos(Floatx8::load(x), s, c); c.store(out); };
+        checks.push_back({ "sin", "[-8192, 8192]", uniform(-8192.0, 8192.0), unused, angle_edges, sinScalar,
+            [](double x, double) { return std::sin(x); }, 2e-7, 0.0 });
+        checks.push_back({ "cos", "[-8192, 8192]", uniform(-8192.0, 8192.0), unused, angle_edges, cosScalar,
+            [](double x, double) { return std::cos(x); }, 2e-7, 0.0 });
+        checks.push_back({ "sin_x8", "[-8192, 8192]", uniform(-8192.0, 8192.0), unused, angle_edges, sinWide,
+            [](double x, double) { return std::sin(x); }, 2e-7, 0.0 });
+        checks.push_back({ "cos_x8", "[-8192, 8192]", uniform(-8192.0, 8192.0), unused, angle_edges, cosWide,
+            [](double x, double) { return std::cos(x); }, 2e-7, 0.0 });
+        return checks;
+    }
+
+    // Runs every check over 2^20 random arguments plus its edge cases; returns the number of failed checks
+    int runAccuracy(std::ostream& os) {
+        constexpr size_t kSamples = size_t(1) << 20;
+        os << std::left << std::setw(12) << "Function" << std::setw(28) << "Domain" << std::right << std::setw(14) << "Max abs err"
+            << std::setw(14) << "Max rel err" << std::setw(14) << "Worst/bound" << "  Status" << std::endl;
+        os << std::string(92, '-') << std::endl;
+        int failed = 0;
+        for (const AccuracyCheck& check : accuracyChecks()) {
+            Pool pool;
+            std::vector<std::pair<float, float>> args = check.edges;
+            for (size_t i = 0; i < kSamples; ++i) args.push_back({ check.sample_x(pool), check.sample_y(pool) });
+            while (args.size() % 8 != 0) args.push_back(args.front());
+
+            double max_abs = 0.0, max_rel = 0.0, worst = 0.0;
+            for (size_t base = 0; base < args.size(); base += 8) {
+                alignas(32) float x[8], y[8], out[8];
+                for (int i = 0; i < 8; ++i) { x[i] = args[base + i].first; y[i] = args[base + i].second; }
+                check.approximate(x, y, out);
+                for (int i = 0; i < 8; ++i) {
+                    const double exact = check.exact(x[i], y[i]);
+                    double error = std::fabs(static_cast<double>(out[i]) - exact);
+                    if (std::isinf(exact) && out[i] == exact) error = 0.0;
+                    if (exact == 0.0 && out[i] == 0.0f) error = 0.0;
+                    const double magnitude = std::fabs(exact);
+                    // The exact value is itself rounded to float before it could be returned
+                    const double rounding = std::isfinite(magnitude) ? magnitude * 0x1p-24 : 0.0;
+                    const double allowed = check.absolute + (check.relative + check.per_log * std::fabs(y[i] * std::log(std::max<double>(x[i], 1e-300)))) * magnitude + rounding;
+                    const double ratio = std::isnan(error) ? std::numeric_limits<double>::infinity() : (allowed > 0.0 ? error / allowed : (error > 0.0 ? 1e30 : 0.0));
+                    if (std::isfinite(error)) {
+                        max_abs = std::max(max_abs, error);
+                        if (magnitude > 0.0 && std::isfinite(magnitude)) max_rel = std::max(max_rel, error / magnitude);
+                    }
+                    worst = std::max(worst, ratio);
+                }
+            }
+            const bool pass = worst <= 1.0;
+            if (!pass) ++failed;
+            os << std::left << std::setw(12) << check.name << std::setw(28) << check.domain << std::right << std::scientific << std::setprecision(2)
+                << std::setw(14) << max_abs << std::setw(14) << max_rel << std::setw(14) << worst << std::defaultfloat
+                << "  " << (pass ? "ok" : "FAIL") << std::endl;
+        }
+        return failed;
+    }
+
+    void printTable(std::ostream& os, const std::vector<MicroBench::Result>& results) {
+        os << std::left << std::setw(36) << "Benchmark" << std::right << std::setw(12) << "Time(ns)"
+            << std::setw(12) << "Min(ns)" << std::setw(8) << "CV%" << std::setw(14) << "Iterations" << "  Label" << std::endl;
+        os << std::string(100, '-') << std::endl;
+        for (const auto& r : results) {
+            os << std::left << std::setw(36) << r.name << std::right << std::fixed << std::setprecision(2)
+                << std::setw(12) << r.median_ns << std::setw(12) << r.min_ns << std::setw(8) << r.cv * 100.0
+                << std::setw(14) << r.iterations << "  " << r.label << std::endl;
+        }
+        os << std::defaultfloat;
+    }
+
+    void writeJson(std::ostream& os, const std::vector<MicroBench::Result>& results) {
+        os << "{\n  \"benchmarks\": [\n" << std::fixed << std::setprecision(3);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            os << "    { \"name\": \"" << r.name << "\", \"label\": \"" << r.label << "\", \"iterations\": " << r.iterations
+                << ", \"median_ns\": " << r.median_ns << ", \"min_ns\": " << r.min_ns << ", \"cv\": " << r.cv << " }"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        os << "  ]\n}\n" << std::defaultfloat;
+    }
+}
+
+std::vector<MicroBench::Case> MicroBench::makeCases() {
+    auto diffuse = std::make_shared<Lambertian>(Vec3(0.7, 0.6, 0.5), 0.5f, 0.0f);
+    auto metal = std::make_shared<Metal>(Vec3(0.9, 0.9, 0.9), 0.2f, 1.0f, 0.05f, 0.0f);
+    auto glass = std::make_shared<Dielectric>(1.5);
+
+    std::vector<Case> cases;
+    for (auto& c : aabbCases()) cases.push_back(std::move(c));
+    for (auto& c : triangleCases(diffuse)) cases.push_back(std::move(c));
+    cases.push_back(sphereCase(diffuse));
+    cases.push_back(boxCase(diffuse));
+    for (auto& c : vectorCases()) cases.push_back(std::move(c));
+    if (auto texture = makeTexture()) {
+        for (auto& c : textureCases(texture)) cases.push_back(std::move(c));
+    }
+    else {
+        std::cerr << "MicroBench: could not create the benchmark texture, skipping texture cases" << std::endl;
+    }
+    cases.push_back(scatterCase("lambertian/scatter", diffuse));
+    cases.push_back(scatterCase("metal/scatter", metal));
+    cases.push_back(scatterCase("dielectric/scatter", glass));
+    cases.push_back(cameraCase());
+    for (auto& c : transcendentalCases()) cases.push_back(std::move(c));
+    return cases;
+}
+
+MicroBench::Result MicroBench::measure(const Case& c, const Options& options) {
+    volatile double sink = 0.0;
+    auto timeRun = [&](uint64_t iterations) {
+        const auto start = Clock::now();
+        sink = sink + c.kernel(iterations);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    // Grow the iteration count until a single run reaches min_time
+    uint64_t iterations = 1;
+    for (;;) {
+        const double seconds = timeRun(iterations);
+        if (seconds >= options.min_time || iterations >= (uint64_t(1) << 40)) break;
+        const double factor = seconds > 0.0 ? std::clamp(options.min_time * 1.4 / seconds, 1.4, 10.0) : 10.0;
+        iterations = static_cast<uint64_t>(std::ceil(iterations * factor));
+    }
+
+    std::vector<double> per_op;
+    for (int r = 0; r < std::max(1, options.repetitions); ++r)
+        per_op.push_back(timeRun(iterations) * 1e9 / iterations);
+
+    Result result;
+    result.name = c.name;
+    result.label = c.label;
+    result.iterations = iterations;
+    std::sort(per_op.begin(), per_op.end());
+    result.min_ns = per_op.front();
+    result.median_ns = per_op[per_op.size() / 2];
+    double mean = 0.0, variance = 0.0;
+    for (double v : per_op) mean += v;
+    mean /= per_op.size();
+    for (double v : per_op) variance += (v - mean) * (v - mean);
+    result.cv = mean > 0.0 ? std::sqrt(variance / per_op.size()) / mean : 0.0;
+    return result;
+}
+
+int MicroBench::run(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) options.filter = argv[++i];
+        else if (arg == "--min-time" && has_value) options.min_time = std::atof(argv[++i]);
+        else if (arg == "--repetitions" && has_value) options.repetitions = std::atoi(argv[++i]);
+        else if (arg == "--out" && has_value) options.out = argv[++i];
+        else if (arg == "--list") options.list_only = true;
+        else if (arg == "--accuracy") options.accuracy = true;
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.accuracy) {
+        const int failed = runAccuracy(std::cout);
+        if (failed > 0) std::cerr << failed << " FastMath accuracy check(s) failed" << std::endl;
+        return failed > 0 ? 1 : 0;
+    }
+
+    IMG_Init(IMG_INIT_PNG);
+    std::vector<Result> results;
+    for (const Case& c : makeCases()) {
+        if (!options.filter.empty() && c.name.find(options.filter) == std::string::npos) continue;
+        if (options.list_only) {
+            std::cout << c.name << std::endl;
+            continue;
+        }
+        results.push_back(measure(c, options));
+    }
+    if (options.list_only) return 0;
+
+    printTable(std::cout, results);
+    if (!options.out.empty()) {
+        std::ofstream out(options.out);
+        if (!out.is_open()) {
+            std::cerr << "Could not write " << options.out << std::endl;
+            return 1;
+        }
+        writeJson(out, results);
+        std::cout << "Results written to " << options.out << std::endl;
+    }
+    return 0;
+}
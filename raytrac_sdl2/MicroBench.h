@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Microbenchmarks for the innermost kernels (AABB/Triangle/Sphere/Box hit tests,
+// Vec3 vs Vec3SIMD arithmetic, texture lookups, material scatter, camera rays,
+// <cmath> vs FastMath).
+//
+//   raytrace_bench micro [--filter aabb] [--min-time 0.25] [--repetitions 5] [--list] [--out micro.json]
+//   raytrace_bench micro --accuracy
+//
+// --accuracy skips the timings and checks every FastMath function against
+// double precision <cmath> over its documented domain; the exit code is 1
+// when an error bound is exceeded.
+//
+// Each kernel walks a pre-generated pool of randomized inputs so the timing covers
+// the kernel itself rather than the random number generator. The iteration count
+// is grown until one run takes at least --min-time seconds, then the run is
+// repeated and the median is reported, in the spirit of Google Benchmark.
+class MicroBench {
+public:
+    // Runs `iterations` operations and returns a checksum that depends on every result,
+    // so the optimizer cannot drop the work.
+    using Kernel = std::function<double(uint64_t iterations)>;
+
+    struct Case {
+        std::string name;
+        std::string label;   // input distribution notes, e.g. "hit rate 48%"
+        Kernel kernel;
+    };
+
+    struct Result {
+        std::string name;
+        std::string label;
+        uint64_t iterations = 0;
+        double median_ns = 0.0;
+        double min_ns = 0.0;
+        double cv = 0.0;     // coefficient of variation across repetitions
+    };
+
+    struct Options {
+        std::string filter;
+        double min_time = 0.25;
+        int repetitions = 5;
+        bool list_only = false;
+        bool accuracy = false;
+        std::string out;
+    };
+
+    // Command line entry point, argv[0] is "micro".
+    static int run(int argc, char* argv[]);
+
+    static std::vector<Case> makeCases();
+    static Result measure(const Case& c, const Options& options);
+};
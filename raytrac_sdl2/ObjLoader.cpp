@@ -0,0 +1,456 @@
+// ObjLoader.cpp
+
+#include "ObjLoader.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "MappedFile.h"
+#include "Profiler.h"
+
+namespace ObjLoader {
+    namespace {
+        // Below this size splitting the file costs more than it saves
+        constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+        // Extra chunk threads running across every loadObj call in the process. Scene loading parses
+        // several files at once and each asks for a thread per core; the budget keeps the sum at one per core
+        std::atomic<size_t> activeChunkThreads{ 0 };
+
+        // Reserves up to `wanted` threads from the shared budget and returns them on destruction.
+        // Granting fewer (or none) is fine: the calling thread parses whatever chunks are left
+        class ChunkThreadBudget {
+        public:
+            explicit ChunkThreadBudget(size_t wanted) {
+                const size_t limit = std::max(1u, std::thread::hardware_concurrency());
+                size_t active = activeChunkThreads.load(std::memory_order_relaxed);
+                do {
+                    granted = std::min(wanted, active < limit ? limit - active : size_t(0));
+                } while (granted > 0 && !activeChunkThreads.compare_exchange_weak(active, active + granted));
+            }
+            ~ChunkThreadBudget() { activeChunkThreads.fetch_sub(granted); }
+            ChunkThreadBudget(const ChunkThreadBudget&) = delete;
+            ChunkThreadBudget& operator=(const ChunkThreadBudget&) = delete;
+
+            size_t granted = 0;
+        };
+
+        // Faces between two state changes (o/g/usemtl/s) inside one chunk.
+        // The state of the first segment is inherited from the previous chunk during the merge.
+        struct Segment {
+            bool setsName = false;
+            bool setsMaterial = false;
+            bool setsSmooth = false;
+            std::string name;
+            std::string materialName;
+            int smoothGroup = 0;
+            std::vector<ObjIndex> indices;
+            // Negative (relative) OBJ indices are stored chunk-local; these entries
+            // (index * 3 + attribute) get the chunk's base offset added when merging
+            std::vector<size_t> relativeRefs;
+        };
+
+        struct Chunk {
+            std::vector<ObjVec3> vertices;
+            std::vector<ObjVec2> texCoords;
+            std::vector<ObjVec3> normals;
+            std::vector<Segment> segments;
+            std::vector<std::string> materialLibraries;
+        };
+
+        inline bool isSpace(char c) {
+            return c == ' ' || c == '\t';
+        }
+
+        inline const char* skipSpaces(const char* p, const char* end) {
+            while (p < end && isSpace(*p)) ++p;
+            return p;
+        }
+
+        inline const char* skipToken(const char* p, const char* end) {
+            while (p < end && !isSpace(*p)) ++p;
+            return p;
+        }
+
+        inline bool startsWith(const char* p, const char* end, const char* keyword, size_t length) {
+            return static_cast<size_t>(end - p) >= length && std::equal(keyword, keyword + length, p) &&
+                (static_cast<size_t>(end - p) == length || isSpace(p[length]));
+        }
+
+        const char* parseFloat(const char* p, const char* end, float& value) {
+            p = skipSpaces(p, end);
+            if (p < end && *p == '+') ++p; // from_chars rejects a leading '+'
+            auto result = std::from_chars(p, end, value);
+            if (result.ec != std::errc()) {
+                value = 0.0f;
+                return skipToken(p, end);
+            }
+            return result.ptr;
+        }
+
+        const char* parseInt(const char* p, const char* end, int& value) {
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+')) {
+                negative = *p == '-';
+                ++p;
+            }
+            int result = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                result = result * 10 + (*p - '0');
+                ++p;
+            }
+            value = negative ? -result : result;
+            return p;
+        }
+
+        std::string restOfLine(const char* p, const char* end) {
+            p = skipSpaces(p, end);
+            while (end > p && isSpace(end[-1])) --end;
+            return std::string(p, end);
+        }
+
+        // OBJ indices are 1-based, negative values count back from the current end of the list
+        inline int resolveIndex(int value, size_t localCount, bool& relative) {
+            relative = false;
+            if (value > 0) return value - 1;
+            if (value < 0) {
+                relative = true;
+                return static_cast<int>(localCount) + value;
+            }
+            return -1;
+        }
+
+        Segment& beginSegment(Chunk& chunk) {
+            if (chunk.segments.empty() || !chunk.segments.back().indices.empty()) {
+                chunk.segments.emplace_back();
+            }
+            return chunk.segments.back();
+        }
+
+        void parseFace(const char* p, const char* end, Chunk& chunk, std::vector<ObjIndex>& polygon, std::vector<unsigned>& relativeMask) {
+            polygon.clear();
+            relativeMask.clear();
+
+            while ((p = skipSpaces(p, end)) < end) {
+                ObjIndex corner;
+                unsigned mask = 0;
+                bool relative = false;
+                int value = 0;
+
+                p = parseInt(p, end, value);
+                corner.vertex = resolveIndex(value, chunk.vertices.size(), relative);
+                if (relative) mask |= 1u;
+
+                if (p < end && *p == '/') {
+                    ++p;
+                    if (p < end && *p != '/' && !isSpace(*p)) {
+                        p = parseInt(p, end, value);
+                        corner.texCoord = resolveIndex(value, chunk.texCoords.size(), relative);
+                        if (relative) mask |= 2u;
+                    }
+                    if (p < end && *p == '/') {
+                        ++p;
+                        p = parseInt(p, end, value);
+                        corner.normal = resolveIndex(value, chunk.normals.size(), relative);
+                        if (relative) mask |= 4u;
+                    }
+                }
+                p = skipToken(p, end);
+
+                polygon.push_back(corner);
+                relativeMask.push_back(mask);
+            }
+
+            if (polygon.size() < 3) return;
+
+            Segment& segment = chunk.segments.empty() ? beginSegment(chunk) : chunk.segments.back();
+            auto emit = [&](size_t corner) {
+                const size_t position = segment.indices.size();
+                segment.indices.push_back(polygon[corner]);
+                for (unsigned attribute = 0; attribute < 3; ++attribute) {
+                    if (relativeMask[corner] & (1u << attribute)) {
+                        segment.relativeRefs.push_back(position * 3 + attribute);
+                    }
+                }
+            };
+            for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                emit(0);
+                emit(i);
+                emit(i + 1);
+            }
+        }
+
+        void parseLine(const char* p, const char* end, Chunk& chunk, std::vector<ObjIndex>& polygon, std::vector<unsigned>& relativeMask) {
+            p = skipSpaces(p, end);
+            if (p >= end || *p == '#') return;
+
+            if (p[0] == 'v') {
+                if (end - p > 1 && isSpace(p[1])) {
+                    ObjVec3 v;
+                    p = parseFloat(p + 1, end, v.x);
+                    p = parseFloat(p, end, v.y);
+                    parseFloat(p, end, v.z);
+                    chunk.vertices.push_back(v);
+                }
+                else if (startsWith(p, end, "vt", 2)) {
+                    ObjVec2 t;
+                    p = parseFloat(p + 2, end, t.u);
+                    if (skipSpaces(p, end) < end) parseFloat(p, end, t.v);
+                    chunk.texCoords.push_back(t);
+                }
+                else if (startsWith(p, end, "vn", 2)) {
+                    ObjVec3 n;
+                    p = parseFloat(p + 2, end, n.x);
+                    p = parseFloat(p, end, n.y);
+                    parseFloat(p, end, n.z);
+                    chunk.normals.push_back(n);
+                }
+            }
+            else if (startsWith(p, end, "f", 1)) {
+                parseFace(p + 1, end, chunk, polygon, relativeMask);
+            }
+            else if (startsWith(p, end, "o", 1) || startsWith(p, end, "g", 1)) {
+                Segment& segment = beginSegment(chunk);
+                segment.setsName = true;
+                segment.name = restOfLine(p + 1, end);
+            }
+            else if (startsWith(p, end, "usemtl", 6)) {
+                Segment& segment = beginSegment(chunk);
+                segment.setsMaterial = true;
+                segment.materialName = restOfLine(p + 6, end);
+            }
+            else if (startsWith(p, end, "s", 1)) {
+                std::string value = restOfLine(p + 1, end);
+                int group = 0;
+                if (value != "off") {
+                    parseInt(value.data(), value.data() + value.size(), group);
+                }
+                Segment& segment = beginSegment(chunk);
+                segment.setsSmooth = true;
+                segment.smoothGroup = group;
+            }
+            else if (startsWith(p, end, "mtllib", 6)) {
+                chunk.materialLibraries.push_back(restOfLine(p + 6, end));
+            }
+        }
+
+        Chunk parseChunk(const char* begin, const char* end) {
+            Chunk chunk;
+            // Rough pre-sizing; a typical OBJ line is ~30 bytes
+            const size_t estimatedLines = static_cast<size_t>(end - begin) / 30;
+            chunk.vertices.reserve(estimatedLines / 3);
+
+            std::vector<ObjIndex> polygon;
+            std::vector<unsigned> relativeMask;
+            const char* p = begin;
+            while (p < end) {
+                const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+                if (!lineEnd) lineEnd = end;
+                const char* contentEnd = lineEnd;
+                if (contentEnd > p && contentEnd[-1] == '\r') --contentEnd;
+                parseLine(p, contentEnd, chunk, polygon, relativeMask);
+                p = lineEnd + 1;
+            }
+            return chunk;
+        }
+
+        // Splits [begin, end) into up to `count` ranges that start at line starts
+        std::vector<std::pair<const char*, const char*>> splitLines(const char* begin, const char* end, size_t count) {
+            std::vector<std::pair<const char*, const char*>> ranges;
+            const size_t size = static_cast<size_t>(end - begin);
+            const char* start = begin;
+            for (size_t i = 1; i <= count && start < end; ++i) {
+                const char* split = (i == count) ? end : begin + size * i / count;
+                if (split < start) split = start;
+                if (split < end) {
+                    const char* newline = static_cast<const char*>(std::memchr(split, '\n', end - split));
+                    split = newline ? newline + 1 : end;
+                }
+                ranges.emplace_back(start, split);
+                start = split;
+            }
+            return ranges;
+        }
+
+        std::string resolvePath(const std::filesystem::path& directory, const std::string& filename) {
+            if (filename.empty()) return filename;
+            return (directory / filename).lexically_normal().generic_string();
+        }
+
+        ObjVec3 parseColor(std::istringstream& stream) {
+            ObjVec3 color;
+            stream >> color.x;
+            if (!(stream >> color.y >> color.z)) {
+                color.y = color.z = color.x; // "Kd 0.5" is a grey
+            }
+            return color;
+        }
+
+        // Texture statements may carry options ("map_Bump -bm 0.5 normal.png"); the file is the last token
+        std::string lastToken(std::istringstream& stream) {
+            std::string token, last;
+            while (stream >> token) last = token;
+            return last;
+        }
+    } // namespace
+
+    bool Loader::loadObj(const std::string& filename, ObjModel& model, unsigned threadCount) {
+        PROFILE_SCOPE_CAT("obj_parse", "scene");
+        MappedFile file(filename);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        const size_t maxThreads = threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+        const size_t chunkCount = std::clamp(file.size() / MIN_CHUNK_SIZE, size_t(1), maxThreads);
+        auto ranges = splitLines(file.begin(), file.end(), chunkCount);
+
+        // Chunks run on threads of their own, never on the scene loading pool: the caller is usually
+        // a pool job itself and must not wait on work queued behind it. The calling thread takes chunks
+        // too, so the file is parsed even when other loads hold the whole thread budget
+        std::vector<Chunk> chunks(ranges.size());
+        std::atomic<size_t> nextChunk{ 0 };
+        auto parseChunks = [&chunks, &ranges, &nextChunk]() {
+            for (size_t i = nextChunk++; i < ranges.size(); i = nextChunk++) {
+                chunks[i] = parseChunk(ranges[i].first, ranges[i].second);
+            }
+        };
+        ChunkThreadBudget budget(ranges.size() > 1 ? ranges.size() - 1 : 0);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < budget.granted; ++i) threads.emplace_back(parseChunks);
+        parseChunks();
+        for (auto& thread : threads) thread.join();
+
+        // Stitch the chunks together in file order
+        size_t vertexCount = 0, texCoordCount = 0, normalCount = 0;
+        for (const auto& chunk : chunks) {
+            vertexCount += chunk.vertices.size();
+            texCoordCount += chunk.texCoords.size();
+            normalCount += chunk.normals.size();
+        }
+        model.name = std::filesystem::path(filename).stem().string();
+        model.vertices.reserve(model.vertices.size() + vertexCount);
+        model.texCoords.reserve(model.texCoords.size() + texCoordCount);
+        model.normals.reserve(model.normals.size() + normalCount);
+
+        std::string currentName = model.name;
+        std::string currentMaterial;
+        int currentSmooth = 0;
+        ObjMesh* mesh = nullptr;
+        std::vector<std::string> materialLibraries;
+
+        for (auto& chunk : chunks) {
+            const int base[3] = {
+                static_cast<int>(model.vertices.size()),
+                static_cast<int>(model.texCoords.size()),
+                static_cast<int>(model.normals.size())
+            };
+            model.vertices.insert(model.vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+            model.texCoords.insert(model.texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+            model.normals.insert(model.normals.end(), chunk.normals.begin(), chunk.normals.end());
+            materialLibraries.insert(materialLibraries.end(), chunk.materialLibraries.begin(), chunk.materialLibraries.end());
+
+            for (auto& segment : chunk.segments) {
+                bool changed = false;
+                if (segment.setsName && segment.name != currentName) {
+                    currentName = segment.name;
+                    changed = true;
+                }
+                if (segment.setsMaterial && segment.materialName != currentMaterial) {
+                    currentMaterial = segment.materialName;
+                    changed = true;
+                }
+                if (segment.setsSmooth) {
+                    currentSmooth = segment.smoothGroup;
+                }
+                if (segment.indices.empty()) continue;
+
+                for (size_t ref : segment.relativeRefs) {
+                    ObjIndex& index = segment.indices[ref / 3];
+                    int* attribute = (ref % 3 == 0) ? &index.vertex : (ref % 3 == 1) ? &index.texCoord : &index.normal;
+                    *attribute += base[ref % 3];
+                }
+
+                if (!mesh || changed) {
+                    model.meshes.push_back(std::make_unique<ObjMesh>());
+                    mesh = model.meshes.back().get();
+                    mesh->name = currentName;
+                    mesh->materialName = currentMaterial;
+                }
+
+                const size_t triangles = segment.indices.size() / 3;
+                if (mesh->indices.empty()) {
+                    mesh->indices = std::move(segment.indices);
+                }
+                else {
+                    mesh->indices.insert(mesh->indices.end(), segment.indices.begin(), segment.indices.end());
+                }
+                mesh->smoothGroups.insert(mesh->smoothGroups.end(), triangles, currentSmooth);
+            }
+            chunk = Chunk(); // release the chunk's buffers early
+        }
+
+        const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+        std::sort(materialLibraries.begin(), materialLibraries.end());
+        materialLibraries.erase(std::unique(materialLibraries.begin(), materialLibraries.end()), materialLibraries.end());
+        for (const auto& library : materialLibraries) {
+            if (!parseMaterialLibrary(resolvePath(directory, library), model.materials)) {
+                std::cerr << "Could not open material library: " << library << std::endl;
+            }
+        }
+
+        return true;
+    }
+
+    bool Loader::parseMaterialLibrary(const std::string& mtlFilename,
+        std::unordered_map<std::string, std::unique_ptr<ObjMaterial>>& materials) {
+        std::ifstream file(mtlFilename);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        const std::filesystem::path directory = std::filesystem::path(mtlFilename).parent_path();
+        ObjMaterial* material = nullptr;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            std::istringstream stream(line);
+            std::string keyword;
+            if (!(stream >> keyword) || keyword[0] == '#') continue;
+
+            if (keyword == "newmtl") {
+                std::string name;
+                std::getline(stream >> std::ws, name);
+                auto entry = std::make_unique<ObjMaterial>();
+                entry->name = name;
+                material = entry.get();
+                materials[name] = std::move(entry);
+                continue;
+            }
+            if (!material) continue;
+
+            if (keyword == "Ka") material->ambient = parseColor(stream);
+            else if (keyword == "Kd") material->diffuse = parseColor(stream);
+            else if (keyword == "Ks") material->specular = parseColor(stream);
+            else if (keyword == "Ke") material->emission = parseColor(stream);
+            else if (keyword == "Ns") stream >> material->shininess;
+            else if (keyword == "Ni") stream >> material->ior;
+            else if (keyword == "d") stream >> material->dissolve;
+            else if (keyword == "Tr") {
+                float transparency = 0.0f;
+                stream >> transparency;
+                material->dissolve = 1.0f - transparency;
+            }
+            else if (keyword == "map_Kd") material->diffuseTexture = resolvePath(directory, lastToken(stream));
+            else if (keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump" || keyword == "norm") {
+                material->normalTexture = resolvePath(directory, lastToken(stream));
+            }
+        }
+        return true;
+    }
+} // namespace ObjLoader
@@ -7,67 +7,64 @@
 #include <unordered_map>
 #include <memory>
 
-#ifdef OBJLOADER_EXPORTS
-#define OBJLOADER_API __declspec(dllexport)
-#else
-#define OBJLOADER_API __declspec(dllimport)
-#endif
-
+// In-tree Wavefront OBJ/MTL loader.
+// The file is memory mapped and split into line-aligned chunks that are parsed
+// in parallel; the chunks are then stitched into shared, indexed vertex buffers.
 namespace ObjLoader {
     struct ObjVec2 {
-        float u, v;
+        float u = 0.0f, v = 0.0f;
     };
 
     struct ObjVec3 {
-        float x, y, z;
-    };
-
-    struct ObjTriangle {
-        ObjVec3 v1, v2, v3;
-        ObjVec2 t1, t2, t3;  // Added texture coordinates
-        ObjVec3 n1, n2, n3;  // Added normals
-        std::string materialName;  // Added material name
+        float x = 0.0f, y = 0.0f, z = 0.0f;
     };
 
-    struct ObjFace {
-        std::vector<int> vertexIndices;
-        std::vector<int> textureIndices;
-        std::vector<int> normalIndices;
-        int smoothGroup;
+    // 0-based indices into the ObjModel buffers, -1 when the face does not reference that attribute
+    struct ObjIndex {
+        int vertex = -1;
+        int texCoord = -1;
+        int normal = -1;
     };
 
     struct ObjMaterial {
         std::string name;
         ObjVec3 ambient;
-        ObjVec3 diffuse;
+        ObjVec3 diffuse{ 0.8f, 0.8f, 0.8f };
         ObjVec3 specular;
-        float shininess;
-        std::string diffuseTexture;
+        ObjVec3 emission;
+        float shininess = 0.0f;
+        float ior = 1.0f;
+        float dissolve = 1.0f;
+        std::string diffuseTexture;   // resolved relative to the .mtl file
+        std::string normalTexture;
     };
 
+    // One run of faces sharing an object/group name and a material.
+    // Polygons are fan-triangulated while parsing: every 3 indices form a triangle.
     struct ObjMesh {
         std::string name;
-        std::vector<ObjVec3> vertices;
-        std::vector<ObjVec2> texCoords;
-        std::vector<ObjVec3> normals;
-        std::vector<ObjFace> faces;
         std::string materialName;
+        std::vector<ObjIndex> indices;
+        std::vector<int> smoothGroups;   // one entry per triangle
+
+        size_t triangleCount() const { return smoothGroups.size(); }
     };
 
     struct ObjModel {
         std::string name;
+        std::vector<ObjVec3> vertices;
+        std::vector<ObjVec2> texCoords;
+        std::vector<ObjVec3> normals;
         std::vector<std::unique_ptr<ObjMesh>> meshes;
         std::unordered_map<std::string, std::unique_ptr<ObjMaterial>> materials;
     };
 
-    class OBJLOADER_API Loader {
+    class Loader {
     public:
-        static bool loadObj(const std::string& filename, ObjModel& model);
-        
-
-    private:
-        static bool parseFace(const std::string& line, ObjFace& face);
+        // Splits the file into up to threadCount chunks, 0 uses one per hardware thread. Extra parsing
+        // threads come from a budget shared by all concurrent calls, at most one per hardware thread.
+        static bool loadObj(const std::string& filename, ObjModel& model, unsigned threadCount = 0);
         static bool parseMaterialLibrary(const std::string& mtlFilename,
             std::unordered_map<std::string, std::unique_ptr<ObjMaterial>>& materials);
     };
-} // namespace ObjLoader
\ No newline at end of file
+} // namespace ObjLoader
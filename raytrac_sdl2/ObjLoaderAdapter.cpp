@@ -9,88 +9,94 @@ inline Vec2 toVec2(const ObjLoader::ObjVec2& v) {
     return Vec2(v.u, v.v);
 }
 
-std::vector<std::unique_ptr<Triangle>> ObjLoaderAdapter::loadObjToTriangles(const std::string& filename) {
-    ObjLoader::ObjModel model;
-    std::vector<std::unique_ptr<Triangle>> triangles;
+inline bool isValidIndex(int index, size_t count) {
+    return index >= 0 && static_cast<size_t>(index) < count;
+}
 
-    if (!ObjLoader::Loader::loadObj(filename, model)) {
-        throw std::runtime_error("Failed to load OBJ file: " + filename);
-    }
+size_t ObjLoaderAdapter::appendTriangles(ObjLoader::ObjModel& model, std::vector<std::shared_ptr<Hittable>>& objects,
+    const std::shared_ptr<Material>& overrideMaterial) {
+    const size_t appended = appendMeshes(model, objects, overrideMaterial, &model.meshes);
+    model.meshes.clear();
+    return appended;
+}
+
+size_t ObjLoaderAdapter::appendTriangles(const ObjLoader::ObjModel& model, std::vector<std::shared_ptr<Hittable>>& objects,
+    const std::shared_ptr<Material>& overrideMaterial) {
+    return appendMeshes(model, objects, overrideMaterial, nullptr);
+}
 
+size_t ObjLoaderAdapter::appendMeshes(const ObjLoader::ObjModel& model, std::vector<std::shared_ptr<Hittable>>& objects,
+    const std::shared_ptr<Material>& overrideMaterial, std::vector<std::unique_ptr<ObjLoader::ObjMesh>>* consumedMeshes) {
+    size_t triangleCount = 0;
     for (const auto& mesh : model.meshes) {
-        std::shared_ptr<Material> material = nullptr;
-        if (!mesh->materialName.empty()) {
-            auto it = model.materials.find(mesh->materialName);
-            if (it != model.materials.end()) {
-                material = createMaterialFromObjMaterial(it->second.get());
-            }
+        triangleCount += mesh->triangleCount();
+    }
+    const size_t before = objects.size();
+    objects.reserve(before + triangleCount);
+
+    for (size_t m = 0; m < model.meshes.size(); ++m) {
+        const ObjLoader::ObjMesh& mesh = *model.meshes[m];
+        const std::shared_ptr<Material> material = meshMaterial(model, mesh, overrideMaterial);
+        for (size_t i = 0; i < mesh.triangleCount(); ++i) {
+            processTriangle(model, mesh, i, material, objects);
         }
-
-        for (const auto& face : mesh->faces) {
-            if (face.vertexIndices.size() >= 3) {
-                processFace(mesh.get(), face, material, triangles);
-            }
+        if (consumedMeshes) {
+            (*consumedMeshes)[m].reset(); // bu mesh'in index buffer' artk gerekmiyor
         }
     }
 
-    return triangles;
+    return objects.size() - before;
 }
 
-void ObjLoaderAdapter::processFace(const ObjLoader::ObjMesh* mesh, const ObjLoader::ObjFace& face,
-    const std::shared_ptr<Material>& material,
-    std::vector<std::unique_ptr<Triangle>>& triangles) {
+std::shared_ptr<Material> ObjLoaderAdapter::meshMaterial(const ObjLoader::ObjModel& model, const ObjLoader::ObjMesh& mesh,
+    const std::shared_ptr<Material>& overrideMaterial) {
+    if (overrideMaterial || mesh.materialName.empty()) return overrideMaterial;
+    auto it = model.materials.find(mesh.materialName);
+    return it != model.materials.end() ? createMaterialFromObjMaterial(it->second.get()) : nullptr;
+}
 
-    if (!mesh || mesh->vertices.empty() || face.vertexIndices.size() < 3) {
-        // Hata ileme
-        return;
-    }
+void ObjLoaderAdapter::processTriangle(const ObjLoader::ObjModel& model, const ObjLoader::ObjMesh& mesh, size_t triangleIndex,
+    const std::shared_ptr<Material>& material,
+    std::vector<std::shared_ptr<Hittable>>& objects) {
+    const ObjLoader::ObjIndex* corners = &mesh.indices[triangleIndex * 3];
 
-    size_t vertexCount = face.vertexIndices.size();
-    for (size_t i = 0; i < vertexCount - 2; ++i) {
-        // Vertex kontrol
-        if (face.vertexIndices[0] >= mesh->vertices.size() ||
-            face.vertexIndices[i + 1] >= mesh->vertices.size() ||
-            face.vertexIndices[i + 2] >= mesh->vertices.size()) {
+    // Vertex kontrol
+    for (int k = 0; k < 3; ++k) {
+        if (!isValidIndex(corners[k].vertex, model.vertices.size())) {
             // Hata ileme
             return;
         }
+    }
 
-        Vec3 v0 = toVec3(mesh->vertices[face.vertexIndices[0]]);
-        Vec3 v1 = toVec3(mesh->vertices[face.vertexIndices[i + 1]]);
-        Vec3 v2 = toVec3(mesh->vertices[face.vertexIndices[i + 2]]);
-
-        Vec3 n0, n1, n2;
-        if (!face.normalIndices.empty() && face.normalIndices.size() > i + 1) {
-            if (face.normalIndices[0] < mesh->normals.size() && face.normalIndices[i + 1] < mesh->normals.size() && face.normalIndices[i + 2] < mesh->normals.size()) {
-                n0 = toVec3(mesh->normals[face.normalIndices[0]]);
-                n1 = toVec3(mesh->normals[face.normalIndices[i + 1]]);
-                n2 = toVec3(mesh->normals[face.normalIndices[i + 2]]);
-            }
-            else {
-                // Hata ileme
-                return;
-            }
-        }
-        else {
-            Vec3 normal = Vec3::cross(v1 - v0, v2 - v0).normalize();
-            n0 = n1 = n2 = normal;
-        }
+    Vec3 v0 = toVec3(model.vertices[corners[0].vertex]);
+    Vec3 v1 = toVec3(model.vertices[corners[1].vertex]);
+    Vec3 v2 = toVec3(model.vertices[corners[2].vertex]);
+
+    Vec3 n0, n1, n2;
+    if (isValidIndex(corners[0].normal, model.normals.size()) &&
+        isValidIndex(corners[1].normal, model.normals.size()) &&
+        isValidIndex(corners[2].normal, model.normals.size())) {
+        n0 = toVec3(model.normals[corners[0].normal]);
+        n1 = toVec3(model.normals[corners[1].normal]);
+        n2 = toVec3(model.normals[corners[2].normal]);
+    }
+    else {
+        Vec3 normal = Vec3::cross(v1 - v0, v2 - v0).normalize();
+        n0 = n1 = n2 = normal;
+    }
 
-        Vec2 t0 = getTextureCoords(mesh, face, 0);
-        Vec2 t1 = getTextureCoords(mesh, face, i + 1);
-        Vec2 t2 = getTextureCoords(mesh, face, i + 2);
+    Vec2 t0 = getTextureCoords(model, corners[0]);
+    Vec2 t1 = getTextureCoords(model, corners[1]);
+    Vec2 t2 = getTextureCoords(model, corners[2]);
 
-        triangles.push_back(std::make_unique<Triangle>(
-            v0, v1, v2, n0, n1, n2, t0, t1, t2, material, face.smoothGroup
-        ));
-    }
+    // make_shared: object and control block in a single allocation
+    objects.push_back(std::make_shared<Triangle>(v0, v1, v2, n0, n1, n2, t0, t1, t2, material, mesh.smoothGroups[triangleIndex]));
 }
-Vec2 ObjLoaderAdapter::getTextureCoords(const ObjLoader::ObjMesh* mesh, const ObjLoader::ObjFace& face, size_t index) {
-    if (!face.textureIndices.empty() && index < face.textureIndices.size() &&
-        mesh->texCoords.size() > face.textureIndices[index]) {
-        return toVec2(mesh->texCoords[face.textureIndices[index]]);
+
+Vec2 ObjLoaderAdapter::getTextureCoords(const ObjLoader::ObjModel& model, const ObjLoader::ObjIndex& index) {
+    if (isValidIndex(index.texCoord, model.texCoords.size())) {
+        return toVec2(model.texCoords[index.texCoord]);
     }
-   // std::cerr << "UV coordinates not found for face index " << index << ". Returning default (0,0)" << std::endl;
     return Vec2(0, 0); // Varsaylan deer
 }
 
@@ -5,17 +5,28 @@
 #include "Triangle.h"
 #include <vector>
 #include <memory>
-#include <iostream>
-#include <stdexcept>
 
 class ObjLoaderAdapter {
 public:
-    static std::vector<std::unique_ptr<Triangle>> loadObjToTriangles(const std::string& filename);
+    // Streams the model's triangles straight into the scene list. Capacity is reserved up front and
+    // each mesh's index buffers are released as soon as it is consumed. A non-null material overrides
+    // the MTL materials. Returns the number of triangles appended.
+    static size_t appendTriangles(ObjLoader::ObjModel& model, std::vector<std::shared_ptr<Hittable>>& objects,
+        const std::shared_ptr<Material>& overrideMaterial = nullptr);
+    // Same for a model shared by several scene meshes; the model is left untouched.
+    static size_t appendTriangles(const ObjLoader::ObjModel& model, std::vector<std::shared_ptr<Hittable>>& objects,
+        const std::shared_ptr<Material>& overrideMaterial = nullptr);
 
 private:
+    // Shared body of both appendTriangles overloads. consumedMeshes is either null or model.meshes;
+    // when set, each mesh is freed as soon as its triangles are built.
+    static size_t appendMeshes(const ObjLoader::ObjModel& model, std::vector<std::shared_ptr<Hittable>>& objects,
+        const std::shared_ptr<Material>& overrideMaterial, std::vector<std::unique_ptr<ObjLoader::ObjMesh>>* consumedMeshes);
+    static std::shared_ptr<Material> meshMaterial(const ObjLoader::ObjModel& model, const ObjLoader::ObjMesh& mesh,
+        const std::shared_ptr<Material>& overrideMaterial);
     static std::shared_ptr<Material> createMaterialFromObjMaterial(const ObjLoader::ObjMaterial* objMaterial);
-    static void processFace(const ObjLoader::ObjMesh* mesh, const ObjLoader::ObjFace& face,
+    static void processTriangle(const ObjLoader::ObjModel& model, const ObjLoader::ObjMesh& mesh, size_t triangleIndex,
         const std::shared_ptr<Material>& material,
-        std::vector<std::unique_ptr<Triangle>>& triangles);
-    static Vec2 getTextureCoords(const ObjLoader::ObjMesh* mesh, const ObjLoader::ObjFace& face, size_t index);
+        std::vector<std::shared_ptr<Hittable>>& objects);
+    static Vec2 getTextureCoords(const ObjLoader::ObjModel& model, const ObjLoader::ObjIndex& index);
 };
\ No newline at end of file
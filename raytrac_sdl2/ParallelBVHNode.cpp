@@ -1,4 +1,7 @@
 #include "ParallelBVHNode.h"
+#include "RayStats.h"
+#include <bit>
+#include <immintrin.h>
 
 
 std::atomic<int> ParallelBVHNode::active_threads(0);
@@ -6,8 +9,23 @@ std::atomic<int> ParallelBVHNode::active_threads(0);
 ParallelBVHNode::ParallelBVHNode(const std::vector<std::shared_ptr<Hittable>>& src_objects,
     size_t start, size_t end, double time0, double time1) {
 
+    // Caller's list stays untouched: one copy of the range, then the build sorts that copy in place
     std::vector<std::shared_ptr<Hittable>> objects(src_objects.begin() + start, src_objects.begin() + end);
-    size_t object_span = objects.size();
+    build(objects, 0, objects.size(), time0, time1);
+}
+
+ParallelBVHNode::ParallelBVHNode(std::vector<std::shared_ptr<Hittable>>&& objects, double time0, double time1) {
+    std::vector<std::shared_ptr<Hittable>> owned(std::move(objects));
+    build(owned, 0, owned.size(), time0, time1);
+}
+
+ParallelBVHNode::ParallelBVHNode(std::vector<std::shared_ptr<Hittable>>& objects,
+    size_t start, size_t end, double time0, double time1, InPlace) {
+    build(objects, start, end, time0, time1);
+}
+
+void ParallelBVHNode::build(std::vector<std::shared_ptr<Hittable>>& objects, size_t start, size_t end, double time0, double time1) {
+    size_t object_span = end - start;
 
     auto comparator = (rand() % 3 == 0) ? box_x_compare
         : (rand() % 2 == 0) ? box_y_compare
@@ -15,65 +33,191 @@ ParallelBVHNode::ParallelBVHNode(const std::vector<std::shared_ptr<Hittable>>& s
 
     if (object_span <= 2) {
         if (object_span == 1) {
-            left = right = objects[0];
+            left = right = objects[start];
         }
         else {
-            if (comparator(objects[0], objects[1])) {
-                left = objects[0];
-                right = objects[1];
+            if (comparator(objects[start], objects[start + 1])) {
+                left = objects[start];
+                right = objects[start + 1];
             }
             else {
-                left = objects[1];
-                right = objects[0];
+                left = objects[start + 1];
+                right = objects[start];
             }
         }
     }
     else {
-        std::sort(objects.begin(), objects.end(), comparator);
+        std::sort(objects.begin() + start, objects.begin() + end, comparator);
 
-        auto mid = object_span / 2;
+        auto mid = start + object_span / 2;
 
         if (object_span >= MIN_OBJECTS_PER_THREAD && active_threads < std::thread::hardware_concurrency()) {
             std::future<std::shared_ptr<ParallelBVHNode>> future_left = std::async(
                 std::launch::async,
                 [&]() -> std::shared_ptr<ParallelBVHNode> {
                     active_threads++;
-                    auto node = std::make_shared<ParallelBVHNode>(objects, 0, mid, time0, time1);
+                    auto node = std::make_shared<ParallelBVHNode>(objects, start, mid, time0, time1, InPlace{});
                     active_threads--;
                     return node;
                 }
             );
 
-            right = std::make_shared<ParallelBVHNode>(objects, mid, object_span, time0, time1);
+            right = std::make_shared<ParallelBVHNode>(objects, mid, end, time0, time1, InPlace{});
             left = future_left.get();
         }
         else {
-            left = std::make_shared<ParallelBVHNode>(objects, 0, mid, time0, time1);
-            right = std::make_shared<ParallelBVHNode>(objects, mid, object_span, time0, time1);
+            left = std::make_shared<ParallelBVHNode>(objects, start, mid, time0, time1, InPlace{});
+            right = std::make_shared<ParallelBVHNode>(objects, mid, end, time0, time1, InPlace{});
         }
     }
 
+    left_node = dynamic_cast<const ParallelBVHNode*>(left.get());
+    right_node = dynamic_cast<const ParallelBVHNode*>(right.get());
+
     AABB box_left, box_right;
     if (!left->bounding_box(time0, time1, box_left) || !right->bounding_box(time0, time1, box_right))
         std::cerr << "No bounding box in BVHNode constructor.\n";
 
-    box = surrounding_box(box_left, box_right);
+    box = FloatAABB(surrounding_box(box_left, box_right));
 }
 
 bool ParallelBVHNode::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const {
-    if (!box.hit(r, t_min, t_max))
+    return hit_subtree(r, FloatRay(r), t_min, t_max, rec);
+}
+
+bool ParallelBVHNode::hit_subtree(const Ray& r, const FloatRay& float_ray, double t_min, double t_max, HitRecord& rec) const {
+    RAY_STAT_INC(node_visits);
+    if (!box.hit(float_ray, static_cast<float>(t_min), static_cast<float>(t_max)))
         return false;
 
-    bool hit_left = left->hit(r, t_min, t_max, rec);
-    bool hit_right = right->hit(r, t_min, hit_left ? rec.t : t_max, rec);
+    bool hit_left = left_node ? left_node->hit_subtree(r, float_ray, t_min, t_max, rec) : left->hit(r, t_min, t_max, rec);
+    if (hit_left && left->object_id >= 0) rec.object_id = left->object_id;
+    const double right_t_max = hit_left ? rec.t : t_max;
+    bool hit_right = right_node ? right_node->hit_subtree(r, float_ray, t_min, right_t_max, rec) : right->hit(r, t_min, right_t_max, rec);
+    if (hit_right && right->object_id >= 0) rec.object_id = right->object_id;
 
     return hit_left || hit_right;
 }
+uint32_t ParallelBVHNode::hit_packet(RayPacket& packet, uint32_t active, HitRecord* records) const {
+    if (packet.missesBox(box)) {
+        RAY_STAT_INC(node_visits);
+        return 0;
+    }
+    RAY_STAT_ADD(node_visits, std::popcount(active));
+    const uint32_t inside = packet.hitBox(box, active);
+    if (!inside) return 0;
+    // Same order as hit(): the right child sees the closest hits found on the left
+    const uint32_t hit_left = hit_child(left.get(), left_node, packet, inside, records);
+    const uint32_t hit_right = hit_child(right.get(), right_node, packet, inside, records);
+    return hit_left | hit_right;
+}
+
+uint32_t ParallelBVHNode::hit_child(const Hittable* child, const ParallelBVHNode* child_node, RayPacket& packet, uint32_t active, HitRecord* records) const {
+    // Below two rays the packet stops paying off: the rest of the subtree is traversed ray by ray
+    constexpr int kMinPacketRays = 2;
+    uint32_t hits = 0;
+    if (child_node && std::popcount(active) >= kMinPacketRays) {
+        hits = child_node->hit_packet(packet, active, records);
+    }
+    else {
+        for (uint32_t rest = active; rest; rest &= rest - 1) {
+            const int i = std::countr_zero(rest);
+            if (child->hit(packet.rays[i], packet.t_min, packet.t_max[i], records[i])) {
+                packet.setTMax(i, records[i].t);
+                hits |= 1u << i;
+            }
+        }
+    }
+    if (child->object_id >= 0) {
+        for (uint32_t rest = hits; rest; rest &= rest - 1) {
+            records[std::countr_zero(rest)].object_id = child->object_id;
+        }
+    }
+    return hits;
+}
+
+namespace {
+    // Rays in flight per call: while one waits on a node fetch the others test boxes
+    constexpr int kStreamLanes = 8;
+    // Subtrees below this depth are finished with the recursive hit(); median splits stay far above it
+    constexpr int kStreamStack = 64;
+
+    // Nodes and primitives are separate heap objects; their first two cache lines hold the box and child pointers
+    inline void prefetch_object(const void* object) {
+        const char* bytes = static_cast<const char*>(object);
+        _mm_prefetch(bytes, _MM_HINT_T0);
+        _mm_prefetch(bytes + 64, _MM_HINT_T0);
+    }
+}
+
+ParallelBVHNode::StreamEntry ParallelBVHNode::stream_entry(const Hittable* child, const ParallelBVHNode* child_node, int parent_id) {
+    prefetch_object(child);
+    return { child, child_node, parent_id >= 0 ? parent_id : child->object_id };
+}
+
+void ParallelBVHNode::hit_interleaved(size_t count, const Ray* rays, double t_min, const double* t_max, HitRecord* records, uint8_t* hit_flags) const {
+    struct Lane {
+        size_t ray = 0;
+        FloatRay float_ray;
+        double closest = 0.0;
+        bool hit = false;
+        int top = 0;   // stack size, 0 for an idle lane
+        StreamEntry stack[kStreamStack];
+    };
+    Lane lanes[kStreamLanes];
+    size_t next_ray = 0;
+    auto start = [&](Lane& lane) {
+        if (next_ray >= count) return false;
+        lane.ray = next_ray++;
+        lane.float_ray = FloatRay(rays[lane.ray]);
+        lane.closest = t_max[lane.ray];
+        lane.hit = false;
+        lane.stack[0] = { this, this, -1 };
+        lane.top = 1;
+        return true;
+    };
+    int busy = 0;
+    for (Lane& lane : lanes) {
+        if (start(lane)) ++busy;
+    }
+
+    while (busy > 0) {
+        for (Lane& lane : lanes) {
+            if (lane.top == 0) continue;
+            // One step of this ray, then the next lane's turn
+            const StreamEntry entry = lane.stack[--lane.top];
+            const Ray& r = rays[lane.ray];
+            if (entry.node) {
+                RAY_STAT_INC(node_visits);
+                const ParallelBVHNode* node = entry.node;
+                if (node->box.hit(lane.float_ray, static_cast<float>(t_min), static_cast<float>(lane.closest))) {
+                    // Left is popped first and the right child is tested with the closest hit
+                    // found on the left, the same order as hit(). A node only goes on the stack
+                    // where it has room for its own children; otherwise its hit() finishes it
+                    const int right_slot = lane.top, left_slot = lane.top + 1;
+                    lane.stack[right_slot] = stream_entry(node->right.get(), right_slot + 2 <= kStreamStack ? node->right_node : nullptr, entry.object_id);
+                    lane.stack[left_slot] = stream_entry(node->left.get(), left_slot + 2 <= kStreamStack ? node->left_node : nullptr, entry.object_id);
+                    lane.top += 2;
+                }
+            }
+            else if (entry.object->hit(r, t_min, lane.closest, records[lane.ray])) {
+                lane.closest = records[lane.ray].t;
+                lane.hit = true;
+                if (entry.object_id >= 0) records[lane.ray].object_id = entry.object_id;
+            }
+            if (lane.top == 0) {
+                hit_flags[lane.ray] = lane.hit ? 1 : 0;
+                if (!start(lane)) --busy;
+            }
+        }
+    }
+}
+
 bool ParallelBVHNode::bounding_box(double time0, double time1, AABB& output_box) const {
-    output_box = box;
+    output_box = box.toAABB();
     return true;
 }
-bool ParallelBVHNode::box_compare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b, int axis) {
+bool ParallelBVHNode::box_compare(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b, int axis) {
     AABB box_a;
     AABB box_b;
 
@@ -90,14 +234,14 @@ bool ParallelBVHNode::box_compare(const std::shared_ptr<Hittable> a, const std::
     }
 }
 
-bool ParallelBVHNode::box_x_compare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b) {
+bool ParallelBVHNode::box_x_compare(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b) {
     return box_compare(a, b, 0);
 }
 
-bool ParallelBVHNode::box_y_compare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b) {
+bool ParallelBVHNode::box_y_compare(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b) {
     return box_compare(a, b, 1);
 }
 
-bool ParallelBVHNode::box_z_compare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b) {
+bool ParallelBVHNode::box_z_compare(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b) {
     return box_compare(a, b, 2);
 }
\ No newline at end of file
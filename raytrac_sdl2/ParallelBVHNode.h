@@ -6,9 +6,11 @@
 #include <atomic>
 #include "Hittable.h"
 #include "AABB.h"
+#include "RayPacket.h"
 
 class ParallelBVHNode : public Hittable {
 private:
+    struct InPlace {};
     static constexpr size_t MIN_OBJECTS_PER_THREAD = 1000;
     static std::atomic<int> active_threads;
     const int MIN_OBJECTS_PER_LEAF = 2;
@@ -17,6 +19,11 @@ private:
 public:
     ParallelBVHNode(const std::vector<std::shared_ptr<Hittable>>& src_objects,
         size_t start, size_t end, double time0, double time1);
+    // Takes ownership of the list and sorts it in place, no per-level copies are made
+    ParallelBVHNode(std::vector<std::shared_ptr<Hittable>>&& objects, double time0, double time1);
+    // Child nodes share the parent's list; each one sorts only its own [start, end) range
+    ParallelBVHNode(std::vector<std::shared_ptr<Hittable>>& objects,
+        size_t start, size_t end, double time0, double time1, InPlace);
     std::shared_ptr<Hittable> left;
     std::shared_ptr<Hittable> right;
     bool bounding_box(double time0, double time1, AABB& output_box) const;
@@ -24,12 +31,41 @@ public:
 
      bool hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const ;
 
+    // Traces the rays of active together; records[i] and packet.t_max[i] are updated like
+    // hit() would for ray i. Returns the rays whose closest hit was found below this node
+    uint32_t hit_packet(RayPacket& packet, uint32_t active, HitRecord* records) const;
+
+    // Traces count unrelated rays (bounces, occlusion rays) a few at a time: each ray takes one
+    // traversal step, then the next ray gets its turn, and the nodes a ray visits next are
+    // prefetched before switching, so their cache misses overlap with the other rays' work.
+    // records[i] and hit_flags[i] come out as hit(rays[i], t_min, t_max[i], records[i]) leaves them
+    void hit_interleaved(size_t count, const Ray* rays, double t_min, const double* t_max, HitRecord* records, uint8_t* hit_flags) const;
+
 private:
-    static bool box_compare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b, int axis);
-    static bool box_x_compare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b);
-    static bool box_y_compare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b);
-    static bool box_z_compare(const std::shared_ptr<Hittable> a, const std::shared_ptr<Hittable> b);
+    // hit() below the root: the float copy of the ray is made once and passed down to the child nodes
+    bool hit_subtree(const Ray& r, const FloatRay& float_ray, double t_min, double t_max, HitRecord& rec) const;
+
+    void build(std::vector<std::shared_ptr<Hittable>>& objects, size_t start, size_t end, double time0, double time1);
+
+    static bool box_compare(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b, int axis);
+    static bool box_x_compare(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b);
+    static bool box_y_compare(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b);
+    static bool box_z_compare(const std::shared_ptr<Hittable>& a, const std::shared_ptr<Hittable>& b);
+
+    // Children that are BVH nodes themselves, null for primitives (so packets need no dynamic_cast)
+    const ParallelBVHNode* left_node = nullptr;
+    const ParallelBVHNode* right_node = nullptr;
+    uint32_t hit_child(const Hittable* child, const ParallelBVHNode* child_node, RayPacket& packet, uint32_t active, HitRecord* records) const;
+
+    // A subtree still to be visited by an interleaved ray. object_id is the id hit() would leave
+    // on a hit found below it (the topmost id on the way down), -1 if none
+    struct StreamEntry {
+        const Hittable* object;
+        const ParallelBVHNode* node;   // null for primitives
+        int object_id;
+    };
+    static StreamEntry stream_entry(const Hittable* child, const ParallelBVHNode* child_node, int parent_id);
 
-    AABB box;
+    FloatAABB box;
 
 };
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "PathGuide.h"
+#include <algorithm>
+#include <cmath>
+#include "Profiler.h"
+
+namespace {
+    constexpr double kPi = 3.14159265358979323846;
+    // Share of the uniform distribution kept in every leaf so no direction gets a zero pdf
+    constexpr float kUniformMix = 0.1f;
+    // A quadrant holding more than this share of its leaf's energy is split in four
+    constexpr float kSubdivisionShare = 0.01f;
+    constexpr int kMaxDirectionalDepth = 10;
+}
+
+void PathGuide::reset(const AABB& bounds, const Settings& guide_settings) {
+    settings = guide_settings;
+    nodes.clear();
+    Node root;
+    // Slightly enlarged so points on the boundary still fall inside
+    const Vec3 margin = (bounds.max - bounds.min) * 1e-3 + Vec3(1e-3, 1e-3, 1e-3);
+    root.min = bounds.min - margin;
+    root.max = bounds.max + margin;
+    root.leaf = 0;
+    nodes.push_back(root);
+    leaf_count = 1;
+    ready = false;
+
+    trees.assign(1, DirectionTree(1));
+    has_data.assign(1, 0);
+    total_records.assign(1, 0);
+    offsets.assign(1, 0);
+    energy = std::make_unique<std::atomic<float>[]>(4);
+    counts = std::make_unique<std::atomic<uint32_t>[]>(1);
+}
+
+// The square's centre is +y and its corners -y; the world axes are permuted
+// so the zenith, where skylights and windows usually are, sits in the middle.
+void PathGuide::directionToSquare(const Vec3& direction, double& u, double& v) {
+    const double x = std::fabs(direction.x), y = std::fabs(direction.z), z = std::fabs(direction.y);
+    const double r = std::sqrt(std::max(0.0, 1.0 - z));
+    const double a = std::max(x, y);
+    const double b = a > 0.0 ? std::min(x, y) / a : 0.0;
+    double phi = std::atan(b) * 2.0 / kPi;
+    if (x < y) phi = 1.0 - phi;
+    double sv = phi * r;
+    double su = r - sv;
+    if (direction.y < 0.0) {
+        const double old_u = su;
+        su = 1.0 - sv;
+        sv = 1.0 - old_u;
+    }
+    su = std::copysign(su, direction.x);
+    sv = std::copysign(sv, direction.z);
+    u = std::clamp((su + 1.0) * 0.5, 0.0, 1.0);
+    v = std::clamp((sv + 1.0) * 0.5, 0.0, 1.0);
+}
+
+Vec3 PathGuide::squareToDirection(double u, double v) {
+    const double su = 2.0 * u - 1.0, sv = 2.0 * v - 1.0;
+    const double up = std::fabs(su), vp = std::fabs(sv);
+    const double signed_distance = 1.0 - (up + vp);
+    const double r = 1.0 - std::fabs(signed_distance);
+    const double phi = (r == 0.0 ? 1.0 : (vp - up) / r + 1.0) * kPi / 4.0;
+    const double y = std::copysign(1.0 - r * r, signed_distance);
+    const double scale = r * std::sqrt(std::max(0.0, 2.0 - r * r));
+    return Vec3(std::copysign(std::cos(phi), su) * scale, y, std::copysign(std::sin(phi), sv) * scale);
+}
+
+int PathGuide::descend(double& u, double& v) {
+    const int qx = u >= 0.5 ? 1 : 0;
+    const int qy = v >= 0.5 ? 1 : 0;
+    u = std::min(u * 2.0 - qx, 1.0);
+    v = std::min(v * 2.0 - qy, 1.0);
+    return qx | (qy << 1);
+}
+
+int PathGuide::leafOf(const Vec3& p) const {
+    int index = 0;
+    while (nodes[index].children >= 0) {
+        const Node& node = nodes[index];
+        index = node.children + (p[node.axis] >= node.split ? 1 : 0);
+    }
+    return nodes[index].leaf;
+}
+
+int PathGuide::lookup(const Vec3& p) const {
+    const int leaf = leafOf(p);
+    return has_data[leaf] ? leaf : -1;
+}
+
+Vec3 PathGuide::sample(int leaf, double u1, double u2, double u3, float& pdf) const {
+    if (u1 < kUniformMix) {
+        // The map is equal-area, so a uniform point on the square is a uniform direction
+        const Vec3 direction = squareToDirection(u2, u3);
+        pdf = this->pdf(leaf, direction);
+        return direction;
+    }
+    // Walk down choosing quadrants by energy; u1 is rescaled and reused at every level
+    const DirectionTree& tree = trees[leaf];
+    double r = (u1 - kUniformMix) / (1.0 - kUniformMix);
+    double x0 = 0.0, y0 = 0.0, size = 1.0, density = 1.0;
+    int node = 0;
+    while (true) {
+        const DirectionNode& n = tree[node];
+        const float total = n.total();
+        if (!(total > 0.0f)) break;
+        double target = r * total;
+        int q = 0;
+        while (q < 3 && target >= n.energy[q]) {
+            target -= n.energy[q];
+            ++q;
+        }
+        r = n.energy[q] > 0.0f ? std::clamp(target / n.energy[q], 0.0, 1.0) : 0.5;
+        density *= 4.0 * n.energy[q] / total;
+        size *= 0.5;
+        x0 += (q & 1) * size;
+        y0 += (q >> 1) * size;
+        if (n.child[q] < 0) break;
+        node = n.child[q];
+    }
+    pdf = static_cast<float>((kUniformMix + (1.0 - kUniformMix) * density) / (4.0 * kPi));
+    return squareToDirection(x0 + u2 * size, y0 + u3 * size);
+}
+
+float PathGuide::pdf(int leaf, const Vec3& direction) const {
+    const DirectionTree& tree = trees[leaf];
+    double u, v;
+    directionToSquare(direction, u, v);
+    // Density on the square; dividing by 4 pi turns it into a solid angle density
+    double density = 1.0;
+    int node = 0;
+    while (true) {
+        const DirectionNode& n = tree[node];
+        const float total = n.total();
+        if (!(total > 0.0f)) break;
+        const int q = descend(u, v);
+        density *= 4.0 * n.energy[q] / total;
+        if (n.child[q] < 0) break;
+        node = n.child[q];
+    }
+    return static_cast<float>((kUniformMix + (1.0 - kUniformMix) * density) / (4.0 * kPi));
+}
+
+void PathGuide::record(const Vec3& p, const Vec3& direction, float weight) {
+    // Dark records still count: spatial splits follow where paths go, not only where light was found
+    const int leaf = leafOf(p);
+    counts[leaf].fetch_add(1, std::memory_order_relaxed);
+    if (!(weight > 0.0f) || !std::isfinite(weight)) return;
+    const DirectionTree& tree = trees[leaf];
+    double u, v;
+    directionToSquare(direction, u, v);
+    int node = 0;
+    while (true) {
+        const int q = descend(u, v);
+        if (tree[node].child[q] < 0) {
+            energy[offsets[leaf] + static_cast<size_t>(node) * 4 + q].fetch_add(weight, std::memory_order_relaxed);
+            break;
+        }
+        node = tree[node].child[q];
+    }
+}
+
+float PathGuide::propagate(DirectionTree& tree, int node) {
+    for (int q = 0; q < 4; ++q) {
+        const int child = tree[node].child[q];
+        if (child >= 0) tree[node].energy[q] = propagate(tree, child);
+    }
+    return tree[node].total();
+}
+
+void PathGuide::subdivide(DirectionTree& tree) {
+    const float threshold = kSubdivisionShare * tree[0].total();
+    // (node, depth) work list; new nodes are appended, so indices are used instead of references
+    std::vector<std::pair<int, int>> pending = { { 0, 0 } };
+    while (!pending.empty()) {
+        const auto [node, depth] = pending.back();
+        pending.pop_back();
+        for (int q = 0; q < 4; ++q) {
+            if (tree[node].child[q] >= 0) {
+                pending.push_back({ tree[node].child[q], depth + 1 });
+            }
+            else if (tree[node].energy[q] > threshold && depth + 1 < kMaxDirectionalDepth) {
+                // The quadrant's energy is spread evenly over the new children
+                DirectionNode child;
+                std::fill(std::begin(child.energy), std::end(child.energy), tree[node].energy[q] * 0.25f);
+                tree[node].child[q] = static_cast<int>(tree.size());
+                tree.push_back(child);
+                pending.push_back({ tree[node].child[q], depth + 1 });
+            }
+        }
+    }
+}
+
+void PathGuide::refine() {
+    PROFILE_SCOPE_CAT("path_guide_refine", "post");
+    for (size_t leaf = 0; leaf < leaf_count; ++leaf) {
+        DirectionTree& tree = trees[leaf];
+        for (size_t i = 0; i < tree.size(); ++i) {
+            for (int q = 0; q < 4; ++q) {
+                tree[i].energy[q] += energy[offsets[leaf] + i * 4 + q].load(std::memory_order_relaxed);
+            }
+        }
+        propagate(tree, 0);
+        total_records[leaf] += counts[leaf].load(std::memory_order_relaxed);
+    }
+
+    // Split busy leaves at the middle of their longest axis. The children
+    // share the parent's records, so a very busy leaf is split several levels at once.
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].children >= 0 || nodes[i].depth >= settings.max_depth) continue;
+        const int leaf = nodes[i].leaf;
+        if (total_records[leaf] < settings.split_threshold) continue;
+
+        const Vec3 extent = nodes[i].max - nodes[i].min;
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        const double split = 0.5 * (nodes[i].min[axis] + nodes[i].max[axis]);
+        const int new_leaf = static_cast<int>(leaf_count++);
+
+        Node lower = nodes[i], upper = nodes[i];
+        lower.depth = upper.depth = nodes[i].depth + 1;
+        lower.children = upper.children = -1;
+        if (axis == 0) { lower.max.x = split; upper.min.x = split; }
+        else if (axis == 1) { lower.max.y = split; upper.min.y = split; }
+        else { lower.max.z = split; upper.min.z = split; }
+        lower.leaf = leaf;
+        upper.leaf = new_leaf;
+
+        for (DirectionNode& n : trees[leaf]) {
+            for (float& e : n.energy) e *= 0.5f;
+        }
+        trees.push_back(trees[leaf]);
+        total_records[leaf] /= 2;
+        total_records.push_back(total_records[leaf]);
+
+        nodes[i].axis = axis;
+        nodes[i].split = split;
+        nodes[i].leaf = -1;
+        nodes[i].children = static_cast<int>(nodes.size());
+        nodes.push_back(lower);
+        nodes.push_back(upper);
+    }
+
+    has_data.assign(leaf_count, 0);
+    offsets.resize(leaf_count);
+    size_t slots = 0;
+    for (size_t leaf = 0; leaf < leaf_count; ++leaf) {
+        subdivide(trees[leaf]);
+        has_data[leaf] = trees[leaf][0].total() > 0.0f;
+        ready = ready || has_data[leaf];
+        offsets[leaf] = slots;
+        slots += trees[leaf].size() * 4;
+    }
+
+    energy = std::make_unique<std::atomic<float>[]>(slots);
+    counts = std::make_unique<std::atomic<uint32_t>[]>(leaf_count);
+}
+
+size_t PathGuide::directionalNodeCount() const {
+    size_t count = 0;
+    for (const DirectionTree& tree : trees) count += tree.size();
+    return count;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "AABB.h"
+#include "Vec3.h"
+
+// Online-learned path guiding, after Muller et al.'s SD-tree: a spatial
+// binary tree over the scene bounds whose leaves each hold an adaptive
+// directional quadtree of incident light.
+//
+// Directions live on Clarberg's equal-area octahedral map of the sphere to
+// the unit square, so a quadtree cell's solid angle is its area times 4 pi.
+// During the training passes every diffuse path vertex records the light that
+// arrived along its bounce direction. After each of those passes refine()
+// subdivides quadrants that hold more than a small share of their leaf's
+// energy and splits spatial leaves that collected many records. The structure
+// never changes during a pass, so lookups need no locks and records only do
+// atomic adds.
+//
+// Sampling mixes the guide with the BSDF (one-sample MIS), so an untrained or
+// wrong guide only costs variance, never bias.
+class PathGuide {
+public:
+    struct Settings {
+        int training_passes = 4;      // passes that record radiance; the guide is frozen afterwards
+        float bsdf_fraction = 0.5f;   // probability of sampling the BSDF instead of the guide
+        uint32_t split_threshold = 4000;  // records a spatial leaf needs before it is split
+        int max_depth = 24;           // spatial tree depth limit
+    };
+
+    // Starts over with a single leaf covering bounds
+    void reset(const AABB& bounds, const Settings& settings);
+
+    // pass is 0-based; records are only taken while training
+    bool isTraining(int pass) const { return pass < settings.training_passes; }
+    // True once at least one refine() produced a distribution to sample
+    bool isReady() const { return ready; }
+    float bsdfFraction() const { return settings.bsdf_fraction; }
+
+    // Leaf index for a point, -1 if that leaf has no data yet (sample the BSDF only)
+    int lookup(const Vec3& p) const;
+    // Direction from the leaf's distribution and its solid angle pdf
+    Vec3 sample(int leaf, double u1, double u2, double u3, float& pdf) const;
+    float pdf(int leaf, const Vec3& direction) const;
+
+    // Thread-safe; weight is the radiance estimate divided by the sampling pdf
+    void record(const Vec3& p, const Vec3& direction, float weight);
+
+    // Call between passes after a training pass: refine the directional trees and split busy leaves
+    void refine();
+
+    size_t leafCount() const { return leaf_count; }
+    size_t directionalNodeCount() const;
+
+private:
+    struct Node {
+        Vec3 min, max;
+        int children = -1;   // index of the first of two consecutive children, -1 for leaves
+        int axis = 0;
+        double split = 0.0;
+        int leaf = -1;
+        int depth = 0;
+    };
+
+    // One level of a directional quadtree. Quadrant q covers
+    // [qx/2, (qx+1)/2) x [qy/2, (qy+1)/2) of the node, with qx = q & 1 and qy = q >> 1.
+    struct DirectionNode {
+        int child[4] = { -1, -1, -1, -1 };
+        float energy[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float total() const { return energy[0] + energy[1] + energy[2] + energy[3]; }
+    };
+    using DirectionTree = std::vector<DirectionNode>;
+
+    // Equal-area octahedral map between unit directions and [0,1]^2
+    static void directionToSquare(const Vec3& direction, double& u, double& v);
+    static Vec3 squareToDirection(double u, double v);
+    // Quadrant of (u, v) in the current node; rescales (u, v) into that quadrant
+    static int descend(double& u, double& v);
+
+    int leafOf(const Vec3& p) const;
+    // Recomputes the energy of inner quadrants from the nodes below, returns the node total
+    static float propagate(DirectionTree& tree, int node);
+    static void subdivide(DirectionTree& tree);
+
+    Settings settings;
+    std::vector<Node> nodes;
+    size_t leaf_count = 0;
+    bool ready = false;
+
+    // Per spatial leaf: the directional tree (energy kept across passes) and a "has data" flag
+    std::vector<DirectionTree> trees;
+    std::vector<uint8_t> has_data;
+
+    // Training state since the last refine: 4 slots per directional node, leaf l starting at offsets[l]
+    std::unique_ptr<std::atomic<float>[]> energy;
+    std::vector<size_t> offsets;
+    std::unique_ptr<std::atomic<uint32_t>[]> counts;
+    std::vector<uint32_t> total_records;
+};
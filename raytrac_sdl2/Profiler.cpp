@@ -0,0 +1,196 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+// Returns the slot to the profiler when its thread exits
+struct ThreadSlot {
+    Profiler::ThreadData* data = nullptr;
+    ~ThreadSlot() {
+        if (data) Profiler::instance().release(data);
+    }
+};
+
+namespace {
+    thread_local ThreadSlot current_slot;
+
+    void writeJsonString(std::ostream& os, const std::string& text) {
+        os << '"';
+        for (char c : text) {
+            switch (c) {
+            case '"': os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            case '\t': os << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+                }
+                else {
+                    os << c;
+                }
+            }
+        }
+        os << '"';
+    }
+
+    // Hot scope names are string literals; the same literal may have different addresses in different translation units
+    struct HotTotal {
+        uint64_t calls = 0;
+        int64_t total_ns = 0;
+    };
+}
+
+Profiler::HotStat& Profiler::ThreadData::hotStat(const char* name) {
+    for (HotStat& stat : hot) {
+        if (stat.name == name) return stat;
+    }
+    hot.push_back(HotStat{ name });
+    return hot.back();
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::ThreadData& Profiler::threadData() {
+    if (current_slot.data) return *current_slot.data;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& thread : threads) {
+        if (!thread->in_use) {
+            thread->in_use = true;
+            thread->depth = 0;
+            current_slot.data = thread.get();
+            return *thread;
+        }
+    }
+    auto thread = std::make_unique<ThreadData>();
+    thread->id = static_cast<uint32_t>(threads.size() + 1);
+    thread->name = "thread " + std::to_string(thread->id);
+    thread->in_use = true;
+    current_slot.data = thread.get();
+    threads.push_back(std::move(thread));
+    return *current_slot.data;
+}
+
+void Profiler::release(ThreadData* data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    data->in_use = false;
+}
+
+void Profiler::setThreadName(const std::string& name) {
+    ThreadData& data = threadData();
+    std::lock_guard<std::mutex> lock(mutex);
+    data.name = name;
+}
+
+void Profiler::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& thread : threads) {
+        thread->events.clear();
+        thread->hot.clear();
+    }
+    epoch = std::chrono::steady_clock::now();
+}
+
+bool Profiler::writeChromeTrace(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not write profile trace: " << filename << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << std::fixed << std::setprecision(3);
+    bool first = true;
+    std::map<std::string, HotTotal> hot_totals;
+    for (const auto& thread : threads) {
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id << ",\"args\":{\"name\":";
+        writeJsonString(file, thread->name);
+        file << "}}";
+        first = false;
+
+        for (const Event& e : thread->events) {
+            file << ",\n{\"name\":";
+            writeJsonString(file, e.name);
+            file << ",\"cat\":";
+            writeJsonString(file, e.category);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+                << ",\"ts\":" << e.start_ns / 1000.0 << ",\"dur\":" << e.duration_ns / 1000.0 << "}";
+        }
+        for (const HotStat& stat : thread->hot) {
+            HotTotal& total = hot_totals[stat.name];
+            total.calls += stat.calls;
+            total.total_ns += stat.total_ns;
+        }
+    }
+    file << "\n],\"otherData\":{";
+    first = true;
+    for (const auto& [name, total] : hot_totals) {
+        file << (first ? "" : ",");
+        writeJsonString(file, name);
+        file << ":{\"calls\":" << total.calls << ",\"total_ms\":" << total.total_ns / 1e6 << "}";
+        first = false;
+    }
+    file << "}}\n";
+    return file.good();
+}
+
+void Profiler::printSummary(std::ostream& os) const {
+    struct Node {
+        uint32_t depth = 0;
+        uint64_t calls = 0;
+        int64_t total_ns = 0;
+    };
+    std::map<std::string, Node> tree;   // keyed by "parent/child" path so children sort under their parent
+    std::map<std::string, HotTotal> hot_totals;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& thread : threads) {
+        // Rebuild parent links from the event intervals: a scope is the child of the innermost scope containing it
+        std::vector<const Event*> events;
+        events.reserve(thread->events.size());
+        for (const Event& e : thread->events) events.push_back(&e);
+        std::sort(events.begin(), events.end(), [](const Event* a, const Event* b) {
+            return a->start_ns != b->start_ns ? a->start_ns < b->start_ns : a->depth < b->depth;
+        });
+
+        std::vector<std::pair<int64_t, std::string>> stack;   // end time, path
+        for (const Event* e : events) {
+            while (!stack.empty() && stack.back().first <= e->start_ns) stack.pop_back();
+            std::string path = stack.empty() ? e->name : stack.back().second + "/" + e->name;
+            Node& node = tree[path];
+            node.depth = static_cast<uint32_t>(stack.size());
+            node.calls++;
+            node.total_ns += e->duration_ns;
+            stack.emplace_back(e->start_ns + e->duration_ns, std::move(path));
+        }
+
+        for (const HotStat& stat : thread->hot) {
+            HotTotal& total = hot_totals[stat.name];
+            total.calls += stat.calls;
+            total.total_ns += stat.total_ns;
+        }
+    }
+
+    os << std::fixed << std::setprecision(2);
+    os << "Profile (inclusive time, summed over threads):" << std::endl;
+    for (const auto& [path, node] : tree) {
+        const size_t slash = path.find_last_of('/');
+        const std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+        os << "  " << std::string(node.depth * 2, ' ') << std::left << std::setw(std::max(4, 28 - static_cast<int>(node.depth) * 2)) << name << std::right
+            << std::setw(12) << node.total_ns / 1e6 << " ms" << std::setw(10) << node.calls << " calls" << std::endl;
+    }
+    if (!hot_totals.empty()) {
+        os << "Hot scopes:" << std::endl;
+        for (const auto& [name, total] : hot_totals) {
+            os << "  " << std::left << std::setw(28) << name << std::right << std::setw(12) << total.total_ns / 1e6 << " ms"
+                << std::setw(14) << total.calls << " calls, " << (total.calls ? total.total_ns / static_cast<double>(total.calls) : 0.0) << " ns/call" << std::endl;
+        }
+    }
+    os << std::defaultfloat;
+}
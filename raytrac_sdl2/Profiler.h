@@ -0,0 +1,148 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Built-in hierarchical profiler.
+//
+// PROFILE_SCOPE records one timeline event per scope (scene load, passes, tiles, ...).
+// Nesting comes from the per-thread scope depth, the summary and the Chrome trace
+// show it as a tree. PROFILE_HOT_SCOPE is for per-ray work (shading, shadow rays):
+// it only accumulates call count and total time per thread, so it does not flood
+// the timeline with millions of events.
+//
+// Recording is off by default; a disabled scope costs one relaxed atomic load.
+// Define RT_DISABLE_PROFILER to compile the macros away entirely.
+class Profiler {
+public:
+    struct Event {
+        const char* name;
+        const char* category;
+        int64_t start_ns;
+        int64_t duration_ns;
+        uint32_t depth;
+    };
+
+    struct HotStat {
+        const char* name;
+        uint64_t calls = 0;
+        int64_t total_ns = 0;
+    };
+
+    // One slot per live thread. Slots of finished threads are reused by new ones,
+    // so per-pass render workers end up on a stable set of timelines.
+    struct ThreadData {
+        uint32_t id = 0;
+        std::string name;
+        std::vector<Event> events;
+        std::vector<HotStat> hot;
+        uint32_t depth = 0;
+        bool in_use = false;
+
+        HotStat& hotStat(const char* name);
+    };
+
+    static Profiler& instance();
+
+    void setEnabled(bool value) { enabled.store(value, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Names the calling thread's timeline in the trace ("main", "render worker", ...)
+    void setThreadName(const std::string& name);
+
+    ThreadData& threadData();
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    // Chrome trace_event JSON, open with chrome://tracing or https://ui.perfetto.dev
+    bool writeChromeTrace(const std::string& filename) const;
+    void printSummary(std::ostream& os = std::cout) const;
+
+    // Drops all recorded data. Only call while no profiled scope is running.
+    void reset();
+
+private:
+    friend struct ThreadSlot;
+
+    Profiler() : epoch(std::chrono::steady_clock::now()) {}
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    void release(ThreadData* data);
+
+    std::atomic<bool> enabled{ false };
+    std::chrono::steady_clock::time_point epoch;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadData>> threads;
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name, const char* category = "render") {
+        Profiler& profiler = Profiler::instance();
+        if (!profiler.isEnabled()) return;
+        thread = &profiler.threadData();
+        this->name = name;
+        this->category = category;
+        depth = thread->depth++;
+        start = profiler.now();
+    }
+
+    ~ProfileScope() {
+        if (!thread) return;
+        const int64_t end = Profiler::instance().now();
+        thread->depth--;
+        thread->events.push_back({ name, category, start, end - start, depth });
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler::ThreadData* thread = nullptr;
+    const char* name = nullptr;
+    const char* category = nullptr;
+    int64_t start = 0;
+    uint32_t depth = 0;
+};
+
+class ProfileHotScope {
+public:
+    explicit ProfileHotScope(const char* name) {
+        Profiler& profiler = Profiler::instance();
+        if (!profiler.isEnabled()) return;
+        stat = &profiler.threadData().hotStat(name);
+        start = profiler.now();
+    }
+
+    ~ProfileHotScope() {
+        if (!stat) return;
+        stat->total_ns += Profiler::instance().now() - start;
+        stat->calls++;
+    }
+
+    ProfileHotScope(const ProfileHotScope&) = delete;
+    ProfileHotScope& operator=(const ProfileHotScope&) = delete;
+
+private:
+    Profiler::HotStat* stat = nullptr;
+    int64_t start = 0;
+};
+
+#ifdef RT_DISABLE_PROFILER
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_SCOPE_CAT(name, category) ((void)0)
+#define PROFILE_HOT_SCOPE(name) ((void)0)
+#else
+#define RT_PROFILE_JOIN2(a, b) a##b
+#define RT_PROFILE_JOIN(a, b) RT_PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope RT_PROFILE_JOIN(profile_scope_, __LINE__)(name)
+#define PROFILE_SCOPE_CAT(name, category) ProfileScope RT_PROFILE_JOIN(profile_scope_, __LINE__)(name, category)
+#define PROFILE_HOT_SCOPE(name) ProfileHotScope RT_PROFILE_JOIN(profile_hot_scope_, __LINE__)(name)
+#endif
@@ -0,0 +1,94 @@
+#include "RadianceCache.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    uint64_t mix(uint64_t x) {
+        // splitmix64 finaliser
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+}
+
+void RadianceCache::reset(const AABB& bounds, const Vec3& camera, const Settings& cache_settings) {
+    settings = cache_settings;
+    origin = bounds.min;
+    camera_position = camera;
+    const double diagonal = (bounds.max - bounds.min).length();
+    base_cell = settings.cell_size > 0.0 ? settings.cell_size : std::max(diagonal / 1024.0, 1e-6);
+    const size_t size = size_t(1) << std::clamp(settings.table_bits, 10, 28);
+    mask = size - 1;
+    slots = std::make_unique<Slot[]>(size);
+    used.store(0, std::memory_order_relaxed);
+}
+
+void RadianceCache::keyOf(const Vec3& p, const Vec3& normal, uint64_t& hash, uint32_t& checksum) const {
+    // Level 0 reaches 16 base cells from the camera; every doubling of the distance doubles the cell
+    const double distance = (p - camera_position).length();
+    const int level = std::clamp(static_cast<int>(std::floor(std::log2(std::max(distance / (16.0 * base_cell), 1.0)))), 0, 15);
+    const double cell = std::ldexp(base_cell, level);
+    const int64_t ix = static_cast<int64_t>(std::floor((p.x - origin.x) / cell));
+    const int64_t iy = static_cast<int64_t>(std::floor((p.y - origin.y) / cell));
+    const int64_t iz = static_cast<int64_t>(std::floor((p.z - origin.z) / cell));
+
+    const double ax = std::fabs(normal.x), ay = std::fabs(normal.y), az = std::fabs(normal.z);
+    const int axis = ax >= ay && ax >= az ? 0 : (ay >= az ? 1 : 2);
+    const int side = axis * 2 + (normal[axis] < 0.0 ? 1 : 0);
+
+    uint64_t h = mix(static_cast<uint64_t>(ix) * 0x9e3779b97f4a7c15ULL);
+    h = mix(h ^ (static_cast<uint64_t>(iy) * 0xc2b2ae3d27d4eb4fULL));
+    h = mix(h ^ (static_cast<uint64_t>(iz) * 0x165667b19e3779f9ULL));
+    h = mix(h ^ static_cast<uint64_t>(side * 16 + level));
+    hash = h;
+    // The upper half picks nothing in the table index, so it tells apart colliding cells; 0 is reserved
+    checksum = static_cast<uint32_t>(h >> 32) | 1u;
+}
+
+bool RadianceCache::lookup(const Vec3& p, const Vec3& normal, Vec3& radiance) const {
+    if (!slots) return false;
+    uint64_t hash;
+    uint32_t checksum;
+    keyOf(p, normal, hash, checksum);
+    for (int probe = 0; probe < kProbes; ++probe) {
+        const Slot& slot = slots[(hash + probe) & mask];
+        const uint32_t key = slot.checksum.load(std::memory_order_acquire);
+        if (key == 0) return false;
+        if (key != checksum) continue;
+        const uint32_t count = slot.count.load(std::memory_order_relaxed);
+        if (count < settings.min_samples) return false;
+        const double inv = 1.0 / count;
+        radiance = Vec3(slot.sum[0].load(std::memory_order_relaxed) * inv,
+            slot.sum[1].load(std::memory_order_relaxed) * inv,
+            slot.sum[2].load(std::memory_order_relaxed) * inv);
+        return true;
+    }
+    return false;
+}
+
+void RadianceCache::record(const Vec3& p, const Vec3& normal, const Vec3& radiance) {
+    if (!slots) return;
+    if (!std::isfinite(radiance.x) || !std::isfinite(radiance.y) || !std::isfinite(radiance.z)) return;
+    uint64_t hash;
+    uint32_t checksum;
+    keyOf(p, normal, hash, checksum);
+    for (int probe = 0; probe < kProbes; ++probe) {
+        Slot& slot = slots[(hash + probe) & mask];
+        uint32_t key = slot.checksum.load(std::memory_order_acquire);
+        if (key == 0) {
+            // Claim the empty slot; if another thread got it first, key holds its checksum
+            if (slot.checksum.compare_exchange_strong(key, checksum, std::memory_order_acq_rel)) {
+                used.fetch_add(1, std::memory_order_relaxed);
+                key = checksum;
+            }
+        }
+        if (key != checksum) continue;
+        slot.sum[0].fetch_add(static_cast<float>(radiance.x), std::memory_order_relaxed);
+        slot.sum[1].fetch_add(static_cast<float>(radiance.y), std::memory_order_relaxed);
+        slot.sum[2].fetch_add(static_cast<float>(radiance.z), std::memory_order_relaxed);
+        slot.count.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "AABB.h"
+#include "Vec3.h"
+
+// World-space cache of indirect diffuse radiance, in the spirit of Binder et
+// al.'s hashed path space filtering.
+//
+// Diffuse path vertices record the indirect light leaving them (everything
+// the rest of the path gathered, divided by the throughput that reached the
+// vertex). Cells are keyed by position and by the dominant axis of the
+// normal, so the two sides of a wall or a floor and the wall meeting it never
+// share a value. Cells grow in power-of-two steps with distance to the camera,
+// so a large ground plane is coarse far away and fine up close.
+//
+// The table is a fixed-size open-addressing hash with a checksum per slot;
+// slots are claimed with a compare-and-swap and sums are atomic adds, so
+// render threads record and look up concurrently without locks. A full
+// neighbourhood just drops the record. The cache keeps accumulating over the
+// whole render, so its estimates improve pass by pass.
+class RadianceCache {
+public:
+    struct Settings {
+        double cell_size = 0.0;       // cell edge near the camera in world units; 0 picks scene diagonal / 1024
+        uint32_t min_samples = 16;    // records a cell needs before lookups use it
+        int table_bits = 20;          // 2^table_bits slots
+    };
+
+    // Empties the table. camera sets the origin for the distance-dependent cell size
+    void reset(const AABB& bounds, const Vec3& camera, const Settings& settings);
+
+    // Indirect radiance leaving p on the side normal faces; false if the cell is missing or still sparse
+    bool lookup(const Vec3& p, const Vec3& normal, Vec3& radiance) const;
+    // Thread-safe
+    void record(const Vec3& p, const Vec3& normal, const Vec3& radiance);
+
+    size_t cellCount() const { return used.load(std::memory_order_relaxed); }
+    double cellSize() const { return base_cell; }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> checksum{ 0 };   // 0 marks an empty slot
+        std::atomic<uint32_t> count{ 0 };
+        std::atomic<float> sum[3] = { 0.0f, 0.0f, 0.0f };
+    };
+
+    // Hash of the cell containing (p, normal) and a non-zero checksum telling apart cells sharing a slot
+    void keyOf(const Vec3& p, const Vec3& normal, uint64_t& hash, uint32_t& checksum) const;
+
+    static constexpr int kProbes = 8;
+
+    Settings settings;
+    Vec3 origin;
+    Vec3 camera_position;
+    double base_cell = 1.0;
+    size_t mask = 0;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> used{ 0 };
+};
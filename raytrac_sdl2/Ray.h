@@ -1,6 +1,7 @@
 #ifndef RAY_H
 #define RAY_H
 
+#include <cmath>
 #include "Vec3.h"
 
 class Ray {
@@ -14,5 +15,27 @@ public:
     Vec3 at(double t) const { return origin + t * direction; }
 };
 
+// Single precision copy of a ray for BVH traversal, made once per traced ray
+// instead of once per box test. inv_direction is inf for axis-parallel rays.
+// origin_slack[a] bounds, in units of t, how far the slab distances move because
+// the origin was rounded to float.
+struct FloatRay {
+    float origin[3];
+    float inv_direction[3];
+    float origin_slack[3];
+
+    FloatRay() = default;
+    explicit FloatRay(const Ray& r) {
+        for (int a = 0; a < 3; ++a) {
+            origin[a] = static_cast<float>(r.origin[a]);
+            const double inv = 1.0 / r.direction[a];
+            inv_direction[a] = static_cast<float>(inv);
+            // The difference of a double and its float rounding is exact
+            const double error = std::fabs(r.origin[a] - static_cast<double>(origin[a]));
+            origin_slack[a] = error > 0.0 ? static_cast<float>(error * std::fabs(inv)) * (1.0f + 0x1p-20f) : 0.0f;
+        }
+    }
+};
+
 #endif // RAY_H
 
@@ -0,0 +1,59 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include "Hittable.h"
+#include "Ray.h"
+#include "Vec3.h"
+
+// Spawning rays from a surface without hitting that surface again.
+//
+// A computed hit point lies off the true surface by a rounding error that
+// grows with its coordinates, so a fixed t_min (the old EPSILON) is either
+// too small far from the origin or eats contact detail close to it. Instead
+// the origin of every secondary ray is pushed along the geometric normal,
+// to the side the ray leaves on, by a bound on that error, and the ray is
+// traced from kSpawnTMin.
+//
+// The bound is about 2^-20 of each coordinate, a few times the error of a
+// point rounded to float. Shading passes hit points through Vec3SIMD and the
+// wavefront queues store rays in float, and an offset origin stays on the
+// right side of its surface after such a round trip.
+
+// Rays from offset_ray_origin (and camera rays) are traced over (kSpawnTMin, t_max]
+constexpr double kSpawnTMin = 0.0;
+
+// Error bound per coordinate: relative part plus a floor for coordinates near zero
+inline Vec3 spawn_error(const Vec3& p) {
+    constexpr double kRelative = 0x1p-20;
+    constexpr double kAbsolute = 0x1p-32;
+    return Vec3(std::fabs(p.x) * kRelative + kAbsolute, std::fabs(p.y) * kRelative + kAbsolute, std::fabs(p.z) * kRelative + kAbsolute);
+}
+
+// p moved off the surface with unit normal n (either orientation) to the side of direction w
+inline Vec3 offset_ray_origin(const Vec3& p, const Vec3& n, const Vec3& w) {
+    const Vec3 error = spawn_error(p);
+    const double distance = std::fabs(n.x) * error.x + std::fabs(n.y) * error.y + std::fabs(n.z) * error.z;
+    Vec3 offset = n * distance;
+    if (Vec3::dot(w, n) < 0.0) offset = -offset;
+    Vec3 origin = p + offset;
+    // The addition rounds to nearest; step one more ulp outward so it never rounds back toward p
+    const double inf = std::numeric_limits<double>::infinity();
+    if (offset.x > 0.0) origin.x = std::nextafter(origin.x, inf); else if (offset.x < 0.0) origin.x = std::nextafter(origin.x, -inf);
+    if (offset.y > 0.0) origin.y = std::nextafter(origin.y, inf); else if (offset.y < 0.0) origin.y = std::nextafter(origin.y, -inf);
+    if (offset.z > 0.0) origin.z = std::nextafter(origin.z, inf); else if (offset.z < 0.0) origin.z = std::nextafter(origin.z, -inf);
+    return origin;
+}
+
+// Geometric normal of a hit; primitives that only fill the shading normal fall back to it
+inline const Vec3& geometric_normal(const HitRecord& rec) {
+    return rec.face_normal.length_squared() > 0.0 ? rec.face_normal : rec.normal;
+}
+
+inline Vec3 offset_ray_origin(const HitRecord& rec, const Vec3& w) {
+    return offset_ray_origin(rec.point, geometric_normal(rec), w);
+}
+
+// Ray leaving the surface of rec in direction w
+inline Ray spawn_ray(const HitRecord& rec, const Vec3& w) {
+    return Ray(offset_ray_origin(rec, w), w);
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "AABB.h"
+#include "Ray.h"
+#include "Vec3x8.h"
+
+// A group of up to 16 coherent rays (camera rays of neighbouring pixels,
+// shadow rays toward one directional light) traced through the BVH together.
+//
+// Every node's box is fetched once for the whole packet. It is first tested
+// against an interval bound of all rays (origins and inverse directions
+// boxed per axis), which rejects the node for the packet with one test when
+// all rays miss it. Otherwise the slab test runs over the active rays eight
+// at a time in single precision (Vec3x8). The float test is made
+// conservative: the box is pushed out by the rounding error of the float
+// origins and the resulting interval by a few float ulps, so it accepts
+// every ray AABB::hit accepts in double. Primitives are still intersected in
+// double with the exact closest distance, so a packet finds exactly the hits
+// single rays would.
+struct RayPacket {
+    static constexpr int kMaxRays = 16;
+
+    int count = 0;
+    double t_min = 0.0;
+    double t_max[kMaxRays];   // closest hit so far; shrinks during traversal, change it with setTMax
+    Ray rays[kMaxRays];       // primitives are intersected one ray at a time
+
+    // Single precision copies for the box test
+    alignas(32) float ox[kMaxRays], oy[kMaxRays], oz[kMaxRays];
+    alignas(32) float inv_x[kMaxRays], inv_y[kMaxRays], inv_z[kMaxRays];
+    alignas(32) float t_max_f[kMaxRays];   // t_max rounded up
+    float t_min_f = 0.0f;                  // t_min rounded down
+    double origin_error[3];                // largest |origin - float origin| per axis, slightly padded
+
+    // Interval bounds over all rays, valid when no direction component is zero
+    double origin_lo[3], origin_hi[3], inv_lo[3], inv_hi[3];
+    bool has_bounds = false;
+
+    void begin(double ray_t_min) {
+        count = 0;
+        t_min = ray_t_min;
+        t_min_f = roundDown(ray_t_min);
+    }
+    void add(const Ray& r, double ray_t_max) {
+        const int i = count++;
+        rays[i] = r;
+        ox[i] = static_cast<float>(r.origin.x); oy[i] = static_cast<float>(r.origin.y); oz[i] = static_cast<float>(r.origin.z);
+        inv_x[i] = static_cast<float>(1.0 / r.direction.x);
+        inv_y[i] = static_cast<float>(1.0 / r.direction.y);
+        inv_z[i] = static_cast<float>(1.0 / r.direction.z);
+        setTMax(i, ray_t_max);
+    }
+    void setTMax(int i, double t) {
+        t_max[i] = t;
+        t_max_f[i] = roundUp(t);
+    }
+    // Pads the unused lanes and computes the bounds; call after the last add()
+    void finish() {
+        for (int i = count; i < kMaxRays; ++i) {
+            ox[i] = oy[i] = oz[i] = 0.0f;
+            inv_x[i] = inv_y[i] = inv_z[i] = 1.0f;
+            t_max[i] = -std::numeric_limits<double>::infinity();
+            t_max_f[i] = -std::numeric_limits<float>::infinity();
+        }
+        const float* origin_f[3] = { ox, oy, oz };
+        for (int a = 0; a < 3; ++a) {
+            // The difference of a double and its float rounding is exact; the extra term covers
+            // the double rounding of box - origin_error in hitBox
+            double error = 0.0, magnitude = 0.0;
+            for (int i = 0; i < count; ++i) {
+                error = std::max(error, std::fabs(rays[i].origin[a] - static_cast<double>(origin_f[a][i])));
+                magnitude = std::max(magnitude, std::fabs(rays[i].origin[a]));
+            }
+            origin_error[a] = error + magnitude * 0x1p-40;
+        }
+
+        has_bounds = count > 0;
+        for (int a = 0; a < 3 && has_bounds; ++a) {
+            origin_lo[a] = origin_hi[a] = rays[0].origin[a];
+            inv_lo[a] = inv_hi[a] = 1.0 / rays[0].direction[a];
+            for (int i = 1; i < count; ++i) {
+                const double inv = 1.0 / rays[i].direction[a];
+                origin_lo[a] = std::min(origin_lo[a], rays[i].origin[a]);
+                origin_hi[a] = std::max(origin_hi[a], rays[i].origin[a]);
+                inv_lo[a] = std::min(inv_lo[a], inv);
+                inv_hi[a] = std::max(inv_hi[a], inv);
+            }
+            // Mixed signs or axis-parallel rays make the interval useless
+            has_bounds = std::isfinite(inv_lo[a]) && std::isfinite(inv_hi[a]) && (inv_lo[a] > 0.0 || inv_hi[a] < 0.0);
+        }
+    }
+    uint32_t allRays() const { return count >= 32 ? 0xFFFFFFFFu : (1u << count) - 1u; }
+
+    // True if the interval bound proves that no ray can hit the box
+    bool missesBox(const FloatAABB& box) const {
+        if (!has_bounds) return false;
+        double far_t_max = t_min;
+        for (int i = 0; i < count; ++i) far_t_max = std::max(far_t_max, t_max[i]);
+        double near_lo = t_min, far_hi = far_t_max;
+        for (int a = 0; a < 3; ++a) {
+            // (box - origin) * inv over all origins and inverse directions of the packet
+            const double d0_lo = box.min[a] - origin_hi[a], d0_hi = box.min[a] - origin_lo[a];
+            const double d1_lo = box.max[a] - origin_hi[a], d1_hi = box.max[a] - origin_lo[a];
+            const double c0[4] = { d0_lo * inv_lo[a], d0_lo * inv_hi[a], d0_hi * inv_lo[a], d0_hi * inv_hi[a] };
+            const double c1[4] = { d1_lo * inv_lo[a], d1_lo * inv_hi[a], d1_hi * inv_lo[a], d1_hi * inv_hi[a] };
+            const double t0_lo = std::min(std::min(c0[0], c0[1]), std::min(c0[2], c0[3]));
+            const double t0_hi = std::max(std::max(c0[0], c0[1]), std::max(c0[2], c0[3]));
+            const double t1_lo = std::min(std::min(c1[0], c1[1]), std::min(c1[2], c1[3]));
+            const double t1_hi = std::max(std::max(c1[0], c1[1]), std::max(c1[2], c1[3]));
+            // Negative directions swap the slab planes
+            const bool negative = inv_hi[a] < 0.0;
+            near_lo = std::max(near_lo, negative ? t1_lo : t0_lo);
+            far_hi = std::min(far_hi, negative ? t0_hi : t1_hi);
+        }
+        return far_hi < near_lo;
+    }
+
+    // Rays of active that may hit the box within [t_min, t_max[i]]: every ray AABB::hit accepts,
+    // rarely one more whose entry and exit distances are a few float ulps apart
+    uint32_t hitBox(const FloatAABB& box, uint32_t active) const {
+        const Vec3x8 lo(Floatx8(widenDown(box.min[0] - origin_error[0])), Floatx8(widenDown(box.min[1] - origin_error[1])),
+            Floatx8(widenDown(box.min[2] - origin_error[2])));
+        const Vec3x8 hi(Floatx8(widenUp(box.max[0] + origin_error[0])), Floatx8(widenUp(box.max[1] + origin_error[1])),
+            Floatx8(widenUp(box.max[2] + origin_error[2])));
+        uint32_t result = 0;
+        for (int base = 0; base < count; base += 8) {
+            if (((active >> base) & 0xFFu) == 0) continue;
+            Floatx8 t_near(t_min_f), t_far = Floatx8::load(t_max_f + base);
+            clipToBox(Vec3x8::load(ox + base, oy + base, oz + base), Vec3x8::load(inv_x + base, inv_y + base, inv_z + base), lo, hi, t_near, t_far);
+            // The float subtraction, the float inverse and the product are each off by at most
+            // one rounding; 2^-20 of the distance covers all of them with room to spare. The slack
+            // stays finite so an infinite distance (axis-parallel ray) still decides the test
+            const Floatx8 largest(std::numeric_limits<float>::max());
+            const Floatx8 slack_near = fmadd(min(abs(t_near), largest), Floatx8(0x1p-20f), Floatx8(1e-30f));
+            const Floatx8 slack_far = fmadd(min(abs(t_far), largest), Floatx8(0x1p-20f), Floatx8(1e-30f));
+            const int missed = (t_far + slack_far < t_near - slack_near).bits();
+            result |= (static_cast<uint32_t>(~missed) & 0xFFu) << base;
+        }
+        return result & active;
+    }
+
+private:
+    static float roundDown(double x) {
+        float f = static_cast<float>(x);
+        if (static_cast<double>(f) > x) f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+        return f;
+    }
+    static float roundUp(double x) {
+        float f = static_cast<float>(x);
+        if (static_cast<double>(f) < x) f = std::nextafter(f, std::numeric_limits<float>::infinity());
+        return f;
+    }
+    // Rounded outward and pushed one more float ulp out, so the box test never loses a boundary hit
+    static float widenDown(double x) {
+        const float f = roundDown(x);
+        return f - (std::fabs(f) * 0x1p-22f + 1e-30f);
+    }
+    static float widenUp(double x) {
+        const float f = roundUp(x);
+        return f + (std::fabs(f) * 0x1p-22f + 1e-30f);
+    }
+};
@@ -0,0 +1,86 @@
+#include "RayStats.h"
+#include <iomanip>
+
+thread_local RayCounters RayStats::local;
+std::mutex RayStats::mutex;
+RayCounters RayStats::pass_counters;
+RayCounters RayStats::total_counters;
+
+RayCounters& RayCounters::operator+=(const RayCounters& other) {
+    primary_rays += other.primary_rays;
+    bounce_rays += other.bounce_rays;
+    shadow_rays += other.shadow_rays;
+    node_visits += other.node_visits;
+    triangle_tests += other.triangle_tests;
+    sphere_tests += other.sphere_tests;
+    rr_terminations += other.rr_terminations;
+    cache_hits += other.cache_hits;
+    paths += other.paths;
+    path_segments += other.path_segments;
+    return *this;
+}
+
+void RayStats::flushThread() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pass_counters += local;
+    local = RayCounters();
+}
+
+RayCounters RayStats::takePass() {
+    std::lock_guard<std::mutex> lock(mutex);
+    RayCounters pass = pass_counters;
+    total_counters += pass;
+    pass_counters = RayCounters();
+    return pass;
+}
+
+RayCounters RayStats::total() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return total_counters;
+}
+
+void RayStats::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pass_counters = RayCounters();
+    total_counters = RayCounters();
+    local = RayCounters();
+}
+
+namespace {
+    double mrays(uint64_t count, double seconds) {
+        return seconds > 0.0 ? count / seconds / 1e6 : 0.0;
+    }
+
+    double perRay(uint64_t count, uint64_t rays) {
+        return rays ? static_cast<double>(count) / rays : 0.0;
+    }
+}
+
+void RayStats::printPass(std::ostream& os, int pass, const RayCounters& c, double seconds) {
+    const uint64_t traced = c.totalRays();
+    os << std::fixed << std::setprecision(2)
+        << "Pass " << pass << " rays: " << mrays(traced, seconds) << " Mrays/s (primary " << mrays(c.primary_rays, seconds)
+        << ", bounce " << mrays(c.bounce_rays, seconds) << ", shadow " << mrays(c.shadow_rays, seconds)
+        << "), nodes/ray " << perRay(c.node_visits, traced) << ", tris/ray " << perRay(c.triangle_tests, traced)
+        << ", path length " << c.averagePathLength() << std::endl;
+    os << std::defaultfloat;
+}
+
+void RayStats::printSummary(std::ostream& os, const RayCounters& c, double seconds) {
+    const uint64_t traced = c.totalRays();
+    os << std::fixed << std::setprecision(2);
+    os << "Ray statistics (" << seconds << " s render time):" << std::endl;
+    os << "  Primary rays:      " << std::setw(14) << c.primary_rays << "  " << mrays(c.primary_rays, seconds) << " Mrays/s" << std::endl;
+    os << "  Bounce rays:       " << std::setw(14) << c.bounce_rays << "  " << mrays(c.bounce_rays, seconds) << " Mrays/s" << std::endl;
+    os << "  Shadow rays:       " << std::setw(14) << c.shadow_rays << "  " << mrays(c.shadow_rays, seconds) << " Mrays/s" << std::endl;
+    os << "  All rays:          " << std::setw(14) << traced << "  " << mrays(traced, seconds) << " Mrays/s" << std::endl;
+    os << "  BVH node visits:   " << std::setw(14) << c.node_visits << "  " << perRay(c.node_visits, traced) << " per ray" << std::endl;
+    os << "  Triangle tests:    " << std::setw(14) << c.triangle_tests << "  " << perRay(c.triangle_tests, traced) << " per ray" << std::endl;
+    os << "  Sphere tests:      " << std::setw(14) << c.sphere_tests << "  " << perRay(c.sphere_tests, traced) << " per ray" << std::endl;
+    os << "  RR terminations:   " << std::setw(14) << c.rr_terminations << "  " << perRay(c.rr_terminations, c.paths) * 100.0 << " % of paths" << std::endl;
+    if (c.cache_hits) {
+        os << "  Cache hits:        " << std::setw(14) << c.cache_hits << "  " << perRay(c.cache_hits, c.paths) * 100.0 << " % of paths" << std::endl;
+    }
+    os << "  Average path length: " << c.averagePathLength() << " segments" << std::endl;
+    os << std::defaultfloat;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+
+// Ray and traversal counters.
+//
+// Every thread counts into its own thread_local block with plain increments,
+// so the hot path never touches shared cache lines or takes a lock. Render
+// workers call flushThread() once when they finish, the renderer then collects
+// the pass totals with takePass() after joining the workers.
+//
+// Define RT_DISABLE_RAY_STATS to compile the counting macros away.
+struct RayCounters {
+    uint64_t primary_rays = 0;
+    uint64_t bounce_rays = 0;
+    uint64_t shadow_rays = 0;
+    uint64_t node_visits = 0;        // BVH nodes whose bounds were tested
+    uint64_t triangle_tests = 0;
+    uint64_t sphere_tests = 0;
+    uint64_t rr_terminations = 0;    // paths ended by Russian roulette
+    uint64_t cache_hits = 0;         // paths ended by a radiance cache lookup
+    uint64_t paths = 0;
+    uint64_t path_segments = 0;      // intersected segments over all paths
+
+    uint64_t totalRays() const { return primary_rays + bounce_rays + shadow_rays; }
+    double averagePathLength() const { return paths ? static_cast<double>(path_segments) / paths : 0.0; }
+
+    RayCounters& operator+=(const RayCounters& other);
+};
+
+class RayStats {
+public:
+    static thread_local RayCounters local;
+
+    // Adds the calling thread's counters to the current pass and clears them
+    static void flushThread();
+
+    // Returns the counters of the finished pass and adds them to the run totals
+    static RayCounters takePass();
+    static RayCounters total();
+    static void reset();
+
+    // One line per pass: Mrays/s for each ray type plus traversal work per ray
+    static void printPass(std::ostream& os, int pass, const RayCounters& counters, double seconds);
+    static void printSummary(std::ostream& os, const RayCounters& counters, double seconds);
+
+private:
+    static std::mutex mutex;
+    static RayCounters pass_counters;
+    static RayCounters total_counters;
+};
+
+#ifdef RT_DISABLE_RAY_STATS
+#define RAY_STAT_INC(field) ((void)0)
+#define RAY_STAT_ADD(field, amount) ((void)0)
+#else
+#define RAY_STAT_INC(field) (++RayStats::local.field)
+#define RAY_STAT_ADD(field, amount) (RayStats::local.field += (amount))
+#endif
@@ -0,0 +1,749 @@
+// raytrace_bench: reproducible performance runs over a fixed set of scenes.
+//
+//   raytrace_bench [--scenes spheres,soup_1m,...|all] [--width 640] [--height 360] [--spp 16]
+//                  [--pass 4] [--depth 8] [--seed 1] [--reference-spp 64] [--target-rmse 0.03]
+//                  [--denoise] [--integrator path|ao|direct|...] [--guiding] [--radiance-cache] [--no-packets] [--interleave] [--out bench_results.json]
+//   raytrace_bench micro [--filter aabb] [--min-time 0.25] [--repetitions 5] [--out micro.json]
+//   raytrace_bench load-check [--threads 4]
+//   raytrace_bench cache-check
+//   raytrace_bench glass-check
+//
+// Every scene is rendered headless with a fixed seed. The JSON report holds the
+// scene build and BVH build times, Mrays/s per ray type, peak resident memory and
+// the render time needed to get within the target RMSE of a higher sample count
+// reference render, so results can be compared release over release.
+// The "micro" mode runs the kernel microbenchmarks instead (see MicroBench.h).
+// "load-check" loads a generated multi-chunk OBJ through ScenePipeline on its own
+// pool and a scene file with the atmosphere disabled through SceneLoader, and exits
+// with 1 when a mesh is missing or a miss is not the background; ctest runs it with a timeout.
+// "cache-check" renders a small all-Lambertian scene with path guiding and the
+// radiance cache on and exits with 1 when either stays empty.
+// "glass-check" traces shadow rays through a pane of ior 1.5 glass at fixed angles
+// and exits with 1 when a thin pane blocks or bends them.
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <SDL_image.h>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+#include "BinaryMesh.h"
+#include "MappedMesh.h"
+#include "MicroBench.h"
+#include "Renderer.h"
+#include "SceneLoader.h"
+#include "ScenePipeline.h"
+#include "TaskPool.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct BenchOptions {
+        std::vector<std::string> scenes;
+        int width = 640;
+        int height = 360;
+        int spp = 16;
+        int samples_per_pass = 4;
+        int max_depth = 8;
+        uint32_t seed = 1;
+        int reference_spp = 64;       // 0 disables the RMSE measurement
+        double target_rmse = 0.03;    // display-referred, 0..1 per channel
+        std::string car_scene = "default_scene.json";
+        bool denoise = false;         // denoise the measured render after every pass (the reference stays raw)
+        std::string integrator = "path";  // used for the reference render too
+        bool guiding = false;         // path guiding for the measured render only
+        bool radiance_cache = false;  // radiance cache for the measured render only
+        bool packets = true;          // packet traversal for both renders (same mean image, different noise order)
+        bool interleave = false;      // interleaved traversal of independent rays for both renders (same image)
+        std::string out = "bench_results.json";
+    };
+
+    struct BenchScene {
+        std::string name;
+        CameraSettings camera;
+        size_t triangles = 0;
+        size_t spheres = 0;
+        double build_ms = 0.0;       // geometry generation/loading excluded from bvh_ms
+        double bvh_ms = 0.0;
+        HittableList world;
+        std::vector<std::shared_ptr<Light>> light_list;
+        std::shared_ptr<ParallelBVHNode> bvh;
+        Vec3SIMD background_color = Vec3SIMD(0.5f, 0.6f, 0.7f);
+        AtmosphericEffects atmosphere;
+        bool custom_atmosphere = false;   // false: plain background color, no fog
+        std::string temp_file;            // mapped by the scene, deleted once the scene is destroyed
+    };
+
+    struct BenchResult {
+        std::string name;
+        size_t triangles = 0, spheres = 0, lights = 0;
+        double build_ms = 0.0, bvh_ms = 0.0;
+        double render_seconds = 0.0;
+        RayCounters rays;
+        double peak_rss_mb = 0.0;
+        double final_rmse = -1.0;
+        double time_to_target = -1.0;
+    };
+
+    double peakRssMb() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+        }
+        return 0.0;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / (1024.0 * 1024.0);   // bytes
+#else
+        return usage.ru_maxrss / 1024.0;              // kilobytes
+#endif
+#endif
+    }
+
+    double msSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void defaultAtmosphere(AtmosphericEffects& atmosphere, const Vec3SIMD& background) {
+        atmosphere.enable = true;
+        atmosphere.use_background_texture = false;
+        atmosphere.setBackgroundColor(background);
+    }
+
+    // Procedural field of spheres with a mix of diffuse, metal and glass materials
+    void addSphereField(BenchScene& scene, int grid, std::mt19937& rng) {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::vector<std::shared_ptr<Hittable>> objects;
+        objects.push_back(std::make_shared<Sphere>(Vec3(0, -1000, 0), 1000.0, std::make_shared<Lambertian>(Vec3(0.5, 0.5, 0.5), 0.8f, 0.0f)));
+        for (int a = -grid; a < grid; ++a) {
+            for (int b = -grid; b < grid; ++b) {
+                const double radius = 0.1 + 0.1 * unit(rng);
+                const Vec3 center(a + 0.8 * unit(rng), radius, b + 0.8 * unit(rng));
+                const double choice = unit(rng);
+                std::shared_ptr<Material> material;
+                if (choice < 0.7) {
+                    material = std::make_shared<Lambertian>(Vec3(unit(rng), unit(rng), unit(rng)), 0.5f, 0.0f);
+                }
+                else if (choice < 0.9) {
+                    material = std::make_shared<Metal>(Vec3(0.5 + 0.5 * unit(rng), 0.5 + 0.5 * unit(rng), 0.5 + 0.5 * unit(rng)),
+                        static_cast<float>(0.3 * unit(rng)), 1.0f, 0.0f, 0.0f);
+                }
+                else {
+                    material = std::make_shared<Dielectric>(1.5, Vec3(0.95, 0.95, 1.0), 0.1, 0.006, 0.2, 0.001);
+                }
+                objects.push_back(std::make_shared<Sphere>(center, radius, material));
+            }
+        }
+        scene.spheres += objects.size();
+
+        const auto bvh_start = Clock::now();
+        for (auto& object : objects) scene.world.add(object);
+        scene.bvh = std::make_shared<ParallelBVHNode>(std::move(objects), 0.0, 1.0);
+        scene.bvh_ms += msSince(bvh_start);
+    }
+
+    BenchScene makeSpheres(const BenchOptions& options) {
+        BenchScene scene;
+        scene.name = "spheres";
+        std::mt19937 rng(options.seed);
+        const auto start = Clock::now();
+        addSphereField(scene, 50, rng);
+        scene.light_list.push_back(std::make_shared<DirectionalLight>(Vec3(-1, -2, -1), Vec3(1.5, 1.45, 1.4)));
+        scene.build_ms = msSince(start);
+        scene.camera.lookfrom = Vec3(13, 2, 3);
+        scene.camera.lookat = Vec3(0, 0, 0);
+        scene.camera.vfov = 30.0;
+        scene.camera.focus_distance = 10.0;
+        return scene;
+    }
+
+    // Many small point lights over a smaller sphere field; every shading point tests all of them
+    BenchScene makeManyLights(const BenchOptions& options) {
+        BenchScene scene;
+        scene.name = "many_lights";
+        std::mt19937 rng(options.seed + 1);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        const auto start = Clock::now();
+        addSphereField(scene, 15, rng);
+        for (int i = 0; i < 64; ++i) {
+            const Vec3 position(-15 + 30 * unit(rng), 1.0 + 4.0 * unit(rng), -15 + 30 * unit(rng));
+            const Vec3 color(0.3 + 0.7 * unit(rng), 0.3 + 0.7 * unit(rng), 0.3 + 0.7 * unit(rng));
+            scene.light_list.push_back(std::make_shared<PointLight>(position, color * 4.0, 0.1f));
+        }
+        for (int i = 0; i < 4; ++i) {
+            scene.light_list.push_back(std::make_shared<AreaLight>(Vec3(-10 + 6.0 * i, 8, -2), Vec3(1, 0, 0), Vec3(0, 0, 1), 2.0, 2.0, Vec3(3, 3, 3)));
+        }
+        scene.build_ms = msSince(start);
+        scene.camera.lookfrom = Vec3(13, 4, 6);
+        scene.camera.lookat = Vec3(0, 0, 0);
+        scene.camera.vfov = 40.0;
+        scene.camera.focus_distance = 10.0;
+        return scene;
+    }
+
+    // Uniformly scattered small triangles, stored as a memory mapped .rtmesh so 50M triangles stay affordable
+    BenchScene makeSoup(const BenchOptions& options, const std::string& name, size_t triangle_count) {
+        BenchScene scene;
+        scene.name = name;
+        const auto start = Clock::now();
+
+        MeshData data;
+        data.positions.resize(triangle_count * 9);
+        data.indices.resize(triangle_count * 3);
+        std::mt19937 rng(options.seed + static_cast<uint32_t>(triangle_count));
+        std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> offset(-0.15f, 0.15f);
+        for (size_t t = 0; t < triangle_count; ++t) {
+            const float cx = position(rng), cy = position(rng), cz = position(rng);
+            float* v = &data.positions[t * 9];
+            for (int c = 0; c < 3; ++c) {
+                v[c * 3 + 0] = cx + offset(rng);
+                v[c * 3 + 1] = cy + offset(rng);
+                v[c * 3 + 2] = cz + offset(rng);
+                data.indices[t * 3 + c] = static_cast<uint32_t>(t * 3 + c);
+            }
+        }
+
+        const std::string filename = (std::filesystem::temp_directory_path() /
+            ("raytrace_bench_" + name + "_" + std::to_string(options.seed) + ".rtmesh")).string();
+        if (!BinaryMesh::write(data, filename, true, &scene.bvh_ms)) {
+            throw std::runtime_error("could not write " + filename);
+        }
+        data = MeshData();
+        auto mesh = BinaryMesh::open(filename);
+        if (!mesh) {
+            std::filesystem::remove(filename);
+            throw std::runtime_error("could not map " + filename);
+        }
+        scene.temp_file = filename;
+
+        auto material = std::make_shared<Lambertian>(Vec3(0.7, 0.7, 0.7), 0.5f, 0.0f);
+        auto mapped = std::make_shared<MappedMesh>(mesh, std::vector<std::shared_ptr<Material>>{ material });
+        scene.world.add(mapped);
+        scene.bvh = std::make_shared<ParallelBVHNode>(scene.world.objects, 0, scene.world.objects.size(), 0.0, 1.0);
+        scene.triangles = triangle_count;
+        scene.light_list.push_back(std::make_shared<DirectionalLight>(Vec3(-1, -2, -1), Vec3(1.5, 1.45, 1.4)));
+        scene.build_ms = msSince(start);
+        scene.camera.lookfrom = Vec3(0, 0, 28);
+        scene.camera.lookat = Vec3(0, 0, 0);
+        scene.camera.vfov = 45.0;
+        scene.camera.focus_distance = 28.0;
+        return scene;
+    }
+
+    BenchScene makeCar(const BenchOptions& options) {
+        BenchScene scene;
+        scene.name = "car";
+        const auto start = Clock::now();
+        SceneDescription description = SceneLoader::load(options.car_scene);
+        ScenePipeline::StageTimings timings;
+        scene.bvh = SceneLoader::build(description, scene.world, scene.light_list, scene.atmosphere, scene.background_color, &timings);
+        scene.custom_atmosphere = true;
+        scene.build_ms = msSince(start);
+        scene.bvh_ms = timings.mesh_bvh_ms + timings.scene_bvh_ms;
+        scene.triangles = timings.triangle_count;
+        scene.camera = description.camera;
+
+        return scene;
+    }
+
+    std::vector<float> surfaceToFloats(const SDL_Surface* surface) {
+        std::vector<float> pixels(static_cast<size_t>(surface->w) * surface->h * 3);
+        for (int y = 0; y < surface->h; ++y) {
+            const Uint32* row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(surface->pixels) + y * surface->pitch);
+            for (int x = 0; x < surface->w; ++x) {
+                Uint8 r, g, b;
+                SDL_GetRGB(row[x], surface->format, &r, &g, &b);
+                float* p = &pixels[(static_cast<size_t>(y) * surface->w + x) * 3];
+                p[0] = r / 255.0f;
+                p[1] = g / 255.0f;
+                p[2] = b / 255.0f;
+            }
+        }
+        return pixels;
+    }
+
+    double rmse(const std::vector<float>& a, const std::vector<float>& b) {
+        double sum = 0.0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            const double d = a[i] - b[i];
+            sum += d * d;
+        }
+        return a.empty() ? 0.0 : std::sqrt(sum / a.size());
+    }
+
+    // Renders the prebuilt scene headless; the scene builder hands the shared geometry to the renderer
+    RayCounters renderScene(const BenchScene& scene, const BenchOptions& options, int spp, uint32_t seed, bool measured,
+        const Renderer::PassCallback& callback, double& seconds, std::vector<float>* final_image) {
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, options.width, options.height, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (surface == nullptr) {
+            throw std::runtime_error(std::string("could not create render surface: ") + SDL_GetError());
+        }
+
+        SceneDescription description;
+        description.camera = scene.camera;
+        description.render.width = options.width;
+        description.render.height = options.height;
+        description.render.samples_per_pixel = spp;
+        description.render.samples_per_pass = options.samples_per_pass;
+        description.render.max_depth = options.max_depth;
+        description.render.seed = seed;
+        // Denoising, guiding and the radiance cache only apply to the measured render, the reference stays plain path tracing
+        description.render.denoise_progressive = measured && options.denoise;
+        description.render.path_guiding = measured && options.guiding;
+        description.render.radiance_cache = measured && options.radiance_cache;
+        description.render.integrator = options.integrator;
+        description.render.ray_packets = options.packets;
+        description.render.interleaved_traversal = options.interleave;
+
+        Renderer renderer(options.width, options.height, options.max_depth);
+        renderer.set_scene(description);
+        renderer.set_scene_builder([&scene](HittableList& world, std::vector<std::shared_ptr<Light>>& lights,
+            AtmosphericEffects& atmosphere, Vec3SIMD& background_color) {
+            for (const auto& object : scene.world.objects) world.add(object);
+            lights = scene.light_list;
+            background_color = scene.background_color;
+            if (scene.custom_atmosphere) atmosphere = scene.atmosphere;
+            else defaultAtmosphere(atmosphere, background_color);
+            return scene.bvh;
+        });
+        renderer.set_pass_callback(callback);
+        renderer.render_image(surface, nullptr, spp, options.samples_per_pass);
+
+        seconds = renderer.trace_seconds();
+        if (final_image) *final_image = surfaceToFloats(surface);
+        SDL_FreeSurface(surface);
+        return renderer.ray_stats();
+    }
+
+    BenchResult runScene(BenchScene& scene, const BenchOptions& options) {
+        BenchResult result;
+        result.name = scene.name;
+        result.triangles = scene.triangles;
+        result.spheres = scene.spheres;
+        result.lights = scene.light_list.size();
+        result.build_ms = scene.build_ms;
+        result.bvh_ms = scene.bvh_ms;
+
+        std::vector<float> reference;
+        if (options.reference_spp > 0) {
+            double reference_seconds = 0.0;
+            std::cout << "[" << scene.name << "] reference render, " << options.reference_spp << " spp" << std::endl;
+            // Independent seed so the reference noise does not correlate with the measured render
+            renderScene(scene, options, options.reference_spp, options.seed ^ 0x5bd1e995u, false, nullptr, reference_seconds, &reference);
+        }
+
+        std::cout << "[" << scene.name << "] measured render, " << options.spp << " spp" << std::endl;
+        Renderer::PassCallback callback;
+        if (!reference.empty()) {
+            callback = [&](int, int, double seconds, const SDL_Surface* surface) {
+                result.final_rmse = rmse(surfaceToFloats(surface), reference);
+                if (result.time_to_target < 0.0 && result.final_rmse <= options.target_rmse) {
+                    result.time_to_target = seconds;
+                }
+            };
+        }
+        result.rays = renderScene(scene, options, options.spp, options.seed, true, callback, result.render_seconds, nullptr);
+        result.peak_rss_mb = peakRssMb();
+        return result;
+    }
+
+    double mrays(uint64_t count, double seconds) {
+        return seconds > 0.0 ? count / seconds / 1e6 : 0.0;
+    }
+
+    void writeJson(std::ostream& os, const BenchOptions& options, const std::vector<BenchResult>& results) {
+        os << std::fixed << std::setprecision(3);
+        os << "{\n  \"version\": 1,\n";
+        os << "  \"settings\": { \"width\": " << options.width << ", \"height\": " << options.height
+            << ", \"spp\": " << options.spp << ", \"samples_per_pass\": " << options.samples_per_pass
+            << ", \"max_depth\": " << options.max_depth << ", \"seed\": " << options.seed
+            << ", \"denoise\": " << (options.denoise ? "true" : "false") << ", \"integrator\": \"" << options.integrator << "\""
+            << ", \"guiding\": " << (options.guiding ? "true" : "false")
+            << ", \"radiance_cache\": " << (options.radiance_cache ? "true" : "false")
+            << ", \"packets\": " << (options.packets ? "true" : "false")
+            << ", \"interleave\": " << (options.interleave ? "true" : "false")
+            << ", \"reference_spp\": " << options.reference_spp << ", \"target_rmse\": " << options.target_rmse
+            << ", \"threads\": " << std::thread::hardware_concurrency() << " },\n";
+        os << "  \"scenes\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchResult& r = results[i];
+            const double s = r.render_seconds;
+            os << (i ? "," : "") << "\n    {\n";
+            os << "      \"name\": \"" << r.name << "\",\n";
+            os << "      \"triangles\": " << r.triangles << ", \"spheres\": " << r.spheres << ", \"lights\": " << r.lights << ",\n";
+            os << "      \"scene_build_ms\": " << r.build_ms << ", \"bvh_build_ms\": " << r.bvh_ms << ",\n";
+            os << "      \"render_seconds\": " << s << ",\n";
+            os << "      \"mrays_per_second\": { \"primary\": " << mrays(r.rays.primary_rays, s) << ", \"bounce\": " << mrays(r.rays.bounce_rays, s)
+                << ", \"shadow\": " << mrays(r.rays.shadow_rays, s) << ", \"total\": " << mrays(r.rays.totalRays(), s) << " },\n";
+            os << "      \"rays\": { \"primary\": " << r.rays.primary_rays << ", \"bounce\": " << r.rays.bounce_rays
+                << ", \"shadow\": " << r.rays.shadow_rays << " },\n";
+            os << "      \"nodes_per_ray\": " << (r.rays.totalRays() ? static_cast<double>(r.rays.node_visits) / r.rays.totalRays() : 0.0)
+                << ", \"average_path_length\": " << r.rays.averagePathLength() << ",\n";
+            os << "      \"peak_rss_mb\": " << r.peak_rss_mb << ",\n";
+            os << "      \"final_rmse\": ";
+            if (r.final_rmse >= 0.0) os << r.final_rmse; else os << "null";
+            os << ", \"time_to_target_rmse_seconds\": ";
+            if (r.time_to_target >= 0.0) os << r.time_to_target; else os << "null";
+            os << "\n    }";
+        }
+        os << "\n  ]\n}\n";
+        os << std::defaultfloat;
+    }
+
+    std::vector<std::string> splitList(const std::string& text) {
+        std::vector<std::string> items;
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            if (!item.empty()) items.push_back(item);
+        }
+        return items;
+    }
+
+    const std::vector<std::string>& allScenes() {
+        static const std::vector<std::string> scenes = { "spheres", "many_lights", "soup_1m", "soup_10m", "soup_50m", "car" };
+        return scenes;
+    }
+
+    // A scene file with "atmosphere": { "enable": false } goes through SceneLoader and the renderer.
+    // Camera rays past the one triangle must come back as the plain background color with both integrators
+    int checkDisabledAtmosphere() {
+        const std::filesystem::path dir = std::filesystem::temp_directory_path();
+        const std::string obj_file = (dir / "raytrace_bench_no_atmosphere.obj").string();
+        const std::string scene_file = (dir / "raytrace_bench_no_atmosphere.json").string();
+        {
+            std::ofstream obj(obj_file);
+            obj << "v -0.5 -0.5 0\nv 0.5 -0.5 0\nv 0 0.5 0\nf 1 2 3\n";
+            std::ofstream json(scene_file);
+            json << R"({
+  "render": { "width": 24, "height": 16, "samples_per_pixel": 4, "samples_per_pass": 2, "max_depth": 4 },
+  "camera": { "lookfrom": [0, 0, 5], "lookat": [0, 0, 0], "vfov": 40.0, "focus_distance": 5.0 },
+  "atmosphere": { "enable": false, "background_color": [0.2, 0.4, 0.6] },
+  "materials": { "plain": { "type": "lambertian", "albedo": [0.7, 0.7, 0.7] } },
+  "meshes": [ { "file": "raytrace_bench_no_atmosphere.obj", "material": "plain" } ],
+  "lights": [ { "type": "directional", "direction": [0, 0, -1], "intensity": [1, 1, 1] } ]
+})";
+            if (!obj || !json) {
+                std::cerr << "could not write " << scene_file << std::endl;
+                return 1;
+            }
+        }
+
+        int failed = 0;
+        for (const char* integrator : { "path", "wavefront" }) {
+            SceneDescription description = SceneLoader::load(scene_file);
+            description.render.integrator = integrator;
+            const RenderSettings& render = description.render;
+            SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, render.width, render.height, 32, SDL_PIXELFORMAT_ARGB8888);
+            if (surface == nullptr) {
+                std::cerr << "could not create render surface: " << SDL_GetError() << std::endl;
+                return 1;
+            }
+            Renderer renderer(render.width, render.height, render.max_depth);
+            renderer.set_scene(description);
+            renderer.render_image(surface, nullptr, render.samples_per_pixel, render.samples_per_pass);
+            SDL_FreeSurface(surface);
+
+            const Film& film = renderer.get_film();
+            const Vec3 corner = film.meanColor(film.index(0, 0));
+            const Vec3 center = film.meanColor(film.index(film.width / 2, film.height / 2));
+            const bool background = (corner - Vec3(0.2, 0.4, 0.6)).length() < 1e-4;
+            if (!background || (center - corner).length() < 1e-4) {
+                std::cerr << integrator << " without atmosphere: corner (" << corner.x << ", " << corner.y << ", " << corner.z
+                    << "), center (" << center.x << ", " << center.y << ", " << center.z << ")" << std::endl;
+                ++failed;
+            }
+        }
+        std::filesystem::remove(obj_file);
+        std::filesystem::remove(scene_file);
+        return failed;
+    }
+
+    // The same OBJ added three times: two meshes share one load, one waits on a material job.
+    // The file is large enough to be parsed in several chunks while the pool also runs the other jobs
+    int runLoadCheck(int argc, char* argv[]) {
+        unsigned threads = 4;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+            else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                return 1;
+            }
+        }
+
+        const std::string filename = (std::filesystem::temp_directory_path() / "raytrace_bench_load_check.obj").string();
+        constexpr int kVertices = 60000, kTriangles = 120000;
+        {
+            std::ofstream obj(filename);
+            std::mt19937 rng(1);
+            std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+            std::uniform_int_distribution<int> vertex(1, kVertices);
+            obj << std::fixed << std::setprecision(6);
+            for (int i = 0; i < kVertices; ++i) obj << "v " << position(rng) << ' ' << position(rng) << ' ' << position(rng) << '\n';
+            for (int i = 0; i < kTriangles; ++i) {
+                if (i % 30000 == 0) obj << "o part" << i / 30000 << '\n';
+                obj << "f " << vertex(rng) << ' ' << vertex(rng) << ' ' << vertex(rng) << '\n';
+            }
+            if (!obj) {
+                std::cerr << "could not write " << filename << std::endl;
+                return 1;
+            }
+        }
+
+        TaskPool pool(threads);
+        HittableList world;
+        ScenePipeline::StageTimings timings;
+        {
+            ScenePipeline pipeline("", pool);
+            auto plain = ScenePipeline::readyMaterial(std::make_shared<Lambertian>(Vec3(0.7, 0.7, 0.7), 0.5f, 0.0f));
+            auto built = pipeline.addMaterial([]() -> std::shared_ptr<Material> {
+                return std::make_shared<Lambertian>(Vec3(0.2, 0.4, 0.8), 0.5f, 0.0f);
+            });
+            pipeline.addMesh(filename, plain);
+            pipeline.addMesh(filename, plain);
+            pipeline.addMesh(filename, built);
+            pipeline.build(world);
+            timings = pipeline.timings();
+        }
+        std::filesystem::remove(filename);
+
+        int failed = 0;
+        for (const auto& mesh : timings.meshes) {
+            if (!mesh.loaded || mesh.triangle_count != kTriangles) {
+                std::cerr << mesh.filename << ": " << mesh.triangle_count << " of " << kTriangles << " triangles loaded" << std::endl;
+                ++failed;
+            }
+        }
+        if (timings.meshes.size() != 3) {
+            std::cerr << timings.meshes.size() << " of 3 meshes came back from the pipeline" << std::endl;
+            ++failed;
+        }
+        failed += checkDisabledAtmosphere();
+        std::cout << "load-check on " << threads << " threads: " << timings.triangle_count << " triangles in "
+            << timings.meshes.size() << " meshes, " << timings.total_ms << " ms" << (failed ? ", FAILED" : "") << std::endl;
+        return failed > 0 ? 1 : 0;
+    }
+
+    // Only plain diffuse spheres under a sun: every hit is a vertex the guide and the cache accept
+    int runCacheCheck(int argc, char* argv[]) {
+        if (argc > 1) {
+            std::cerr << "Unknown argument: " << argv[1] << std::endl;
+            return 1;
+        }
+        BenchScene scene;
+        scene.name = "cache_check";
+        std::vector<std::shared_ptr<Hittable>> objects;
+        objects.push_back(std::make_shared<Sphere>(Vec3(0, -1000, 0), 1000.0, std::make_shared<Lambertian>(Vec3(0.5, 0.5, 0.5), 0.8f, 0.0f)));
+        for (int i = 0; i < 5; ++i) {
+            const auto albedo = Vec3(0.3 + 0.1 * i, 0.7 - 0.1 * i, 0.5);
+            objects.push_back(std::make_shared<Sphere>(Vec3(-4.0 + 2.0 * i, 1.0, 0.0), 1.0, std::make_shared<Lambertian>(albedo, 0.5f, 0.0f)));
+        }
+        for (auto& object : objects) scene.world.add(object);
+        scene.bvh = std::make_shared<ParallelBVHNode>(std::move(objects), 0.0, 1.0);
+        scene.light_list.push_back(std::make_shared<DirectionalLight>(Vec3(-1, -2, -1), Vec3(1.5, 1.45, 1.4)));
+        scene.camera.lookfrom = Vec3(0, 3, 10);
+        scene.camera.lookat = Vec3(0, 1, 0);
+        scene.camera.vfov = 40.0;
+        scene.camera.focus_distance = 10.0;
+
+        BenchOptions options;
+        options.width = 96;
+        options.height = 54;
+        options.spp = 16;
+        options.guiding = true;
+        options.radiance_cache = true;
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, options.width, options.height, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (surface == nullptr) {
+            std::cerr << "could not create render surface: " << SDL_GetError() << std::endl;
+            return 1;
+        }
+
+        SceneDescription description;
+        description.camera = scene.camera;
+        description.render.width = options.width;
+        description.render.height = options.height;
+        description.render.samples_per_pixel = options.spp;
+        description.render.samples_per_pass = options.samples_per_pass;
+        description.render.max_depth = options.max_depth;
+        description.render.seed = options.seed;
+        description.render.path_guiding = options.guiding;
+        description.render.radiance_cache = options.radiance_cache;
+
+        Renderer renderer(options.width, options.height, options.max_depth);
+        renderer.set_scene(description);
+        renderer.set_scene_builder([&scene](HittableList& world, std::vector<std::shared_ptr<Light>>& lights,
+            AtmosphericEffects& atmosphere, Vec3SIMD& background_color) {
+            for (const auto& object : scene.world.objects) world.add(object);
+            lights = scene.light_list;
+            background_color = scene.background_color;
+            defaultAtmosphere(atmosphere, background_color);
+            return scene.bvh;
+        });
+        renderer.render_image(surface, nullptr, options.spp, options.samples_per_pass);
+        SDL_FreeSurface(surface);
+
+        const size_t guide_cells = renderer.get_path_guide().leafCount();
+        const size_t cache_cells = renderer.get_radiance_cache().cellCount();
+        const uint64_t cache_hits = renderer.ray_stats().cache_hits;
+        // A guide that never split and a cache with no records or hits mean no vertex counted as diffuse
+        const bool failed = guide_cells < 2 || cache_cells == 0 || cache_hits == 0;
+        std::cout << "cache-check: " << guide_cells << " guide cells, " << cache_cells << " cache cells, "
+            << cache_hits << " cache hits" << (failed ? ", FAILED" : "") << std::endl;
+        return failed ? 1 : 0;
+    }
+
+    // Thin glass keeps the shadow ray straight and lets it through at any angle, front or back face.
+    // Refracting glass still reflects totally past the critical angle (41.8 degrees for ior 1.5) on the inside
+    int runGlassCheck(int argc, char* argv[]) {
+        if (argc > 1) {
+            std::cerr << "Unknown argument: " << argv[1] << std::endl;
+            return 1;
+        }
+        Dielectric glass(1.5, Vec3(0.95, 0.95, 1.0), 0.1, 0.006, 0.0, 0.0);
+        const Vec3 outward(0, 0, 1);
+        int failed = 0;
+        auto check = [&](const char* label, bool ok, const Vec3& t) {
+            std::cout << "  " << label << ": T = (" << t.x << ", " << t.y << ", " << t.z << ")" << (ok ? "" : "  FAILED") << std::endl;
+            if (!ok) ++failed;
+        };
+        for (double degrees : { 0.0, 30.0, 45.0, 60.0, 75.0 }) {
+            const double theta = degrees * M_PI / 180.0;
+            // Front face: the ray comes in from outside. Back face: it leaves through the other side of the pane
+            const Vec3 entering(std::sin(theta), 0.0, -std::cos(theta));
+            const Vec3 leaving(std::sin(theta), 0.0, std::cos(theta));
+            HitRecord front;
+            front.point = Vec3(0.25, 0.5, 0.0);
+            front.set_face_normal(Ray(Vec3(0, 0, 1), entering), outward);
+            HitRecord back = front;
+            back.set_face_normal(Ray(Vec3(0, 0, -1), leaving), outward);
+
+            Vec3 front_direction = entering, back_direction = leaving;
+            const Vec3 t_front = glass.shadow_transmittance(front, front_direction, true);
+            const Vec3 t_back = glass.shadow_transmittance(back, back_direction, true);
+            const std::string angle = std::to_string(static_cast<int>(degrees)) + " deg";
+            check(("thin front " + angle).c_str(), t_front.x > 0.0 && (front_direction - entering).length() < 1e-12, t_front);
+            check(("thin back " + angle).c_str(), t_back.x > 0.0 && (back_direction - leaving).length() < 1e-12
+                && std::fabs(t_back.x - t_front.x) < 1e-9, t_back);
+
+            Vec3 refracted = leaving;
+            const Vec3 t_solid = glass.shadow_transmittance(back, refracted, false);
+            const bool total_reflection = 1.5 * std::sin(theta) > 1.0;
+            check(("refract back " + angle).c_str(), total_reflection ? t_solid.x == 0.0 : t_solid.x > 0.0, t_solid);
+        }
+        std::cout << "glass-check: " << (failed ? "FAILED" : "passed") << std::endl;
+        return failed > 0 ? 1 : 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "micro")
+        return MicroBench::run(argc - 1, argv + 1);
+    if (argc > 1 && std::string(argv[1]) == "load-check")
+        return runLoadCheck(argc - 1, argv + 1);
+    if (argc > 1 && std::string(argv[1]) == "cache-check")
+        return runCacheCheck(argc - 1, argv + 1);
+    if (argc > 1 && std::string(argv[1]) == "glass-check")
+        return runGlassCheck(argc - 1, argv + 1);
+
+    BenchOptions options;
+    options.scenes = allScenes();
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--scenes" && has_value) {
+            const std::string list = argv[++i];
+            options.scenes = list == "all" ? allScenes() : splitList(list);
+        }
+        else if (arg == "--width" && has_value) options.width = std::atoi(argv[++i]);
+        else if (arg == "--height" && has_value) options.height = std::atoi(argv[++i]);
+        else if (arg == "--spp" && has_value) options.spp = std::atoi(argv[++i]);
+        else if (arg == "--pass" && has_value) options.samples_per_pass = std::atoi(argv[++i]);
+        else if (arg == "--depth" && has_value) options.max_depth = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--reference-spp" && has_value) options.reference_spp = std::atoi(argv[++i]);
+        else if (arg == "--target-rmse" && has_value) options.target_rmse = std::atof(argv[++i]);
+        else if (arg == "--car-scene" && has_value) options.car_scene = argv[++i];
+        else if (arg == "--denoise") options.denoise = true;
+        else if (arg == "--guiding") options.guiding = true;
+        else if (arg == "--radiance-cache") options.radiance_cache = true;
+        else if (arg == "--no-packets") options.packets = false;
+        else if (arg == "--interleave") options.interleave = true;
+        else if (arg == "--integrator" && has_value) options.integrator = argv[++i];
+        else if (arg == "--out" && has_value) options.out = argv[++i];
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (options.width <= 0 || options.height <= 0 || options.spp <= 0 || options.samples_per_pass <= 0 || options.max_depth <= 0) {
+        std::cerr << "Image size, sample counts and depth must be positive" << std::endl;
+        return 1;
+    }
+    try {
+        Integrator::parse(options.integrator);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+    std::vector<BenchResult> results;
+    for (const std::string& name : options.scenes) {
+        std::string temp_file;
+        try {
+            BenchScene scene;
+            if (name == "spheres") scene = makeSpheres(options);
+            else if (name == "many_lights") scene = makeManyLights(options);
+            else if (name == "soup_1m") scene = makeSoup(options, name, 1000000);
+            else if (name == "soup_10m") scene = makeSoup(options, name, 10000000);
+            else if (name == "soup_50m") scene = makeSoup(options, name, 50000000);
+            else if (name == "car") scene = makeCar(options);
+            else {
+                std::cerr << "Unknown bench scene: " << name << std::endl;
+                continue;
+            }
+            temp_file = scene.temp_file;
+            results.push_back(runScene(scene, options));
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Scene " << name << " failed: " << e.what() << std::endl;
+        }
+        // The scene and its mapping are gone by now, so the file can be removed on Windows too
+        if (!temp_file.empty()) {
+            std::error_code ignored;
+            std::filesystem::remove(temp_file, ignored);
+        }
+    }
+
+    writeJson(std::cout, options, results);
+    std::ofstream out(options.out);
+    if (!out.is_open()) {
+        std::cerr << "Could not write " << options.out << std::endl;
+        return 1;
+    }
+    writeJson(out, options, results);
+    std::cout << "Results written to " << options.out << std::endl;
+
+    TextureManager::instance().shutdown();
+    return results.size() == options.scenes.size() ? 0 : 1;
+}
@@ -1,9 +1,9 @@
-#include "renderer.h"
+#include "Renderer.h"
 #include <SDL_image.h>
 
 
-Renderer::Renderer(int image_width, int image_height, int samples_per_pixel, int max_depth)
-    : image_width(image_width), image_height(image_height), aspect_ratio(static_cast<double>(image_width) / image_height) {}
+Renderer::Renderer(int image_width, int image_height, int max_depth)
+    : image_width(image_width), image_height(image_height), aspect_ratio(static_cast<double>(image_width) / image_height), MAX_DEPTH(max_depth) {}
 
 Renderer::~Renderer() {}
 void Renderer::set_window(SDL_Window* win) {
@@ -30,6 +30,7 @@ void Renderer::draw_progress_bar(SDL_Surface* surface, float progress) {
 }
 
 void Renderer::render_image(SDL_Surface* surface, SDL_Window* window, const int total_samples_per_pixel, const int samples_per_pass) {
+    PROFILE_SCOPE("render_image");
     unsigned int num_threads = std::thread::hardware_concurrency();
     std::vector<std::thread> threads;
    // std::cout << "Starting render with " << num_threads << " threads" << std::endl;
@@ -37,22 +38,57 @@ void Renderer::render_image(SDL_Surface* surface, SDL_Window* window, const int
     Vec3SIMD background_color;
   
     std::vector<std::shared_ptr<Light>> lights;
-    auto [world, bvh] = create_scene(lights, background_color);
+    HittableList world; // sahne burada yaar, create_scene dorudan bunu doldurur
+    std::shared_ptr<ParallelBVHNode> bvh;
+    {
+        PROFILE_SCOPE_CAT("create_scene", "scene");
+        bvh = scene_builder ? scene_builder(world, lights, atmosphericEffects, background_color)
+            : create_scene(world, lights, background_color);
+    }
+    // object_id AOV'u: st seviye nesneler sahnedeki sralaryla numaralanr
+    for (size_t i = 0; i < world.objects.size(); ++i) {
+        if (world.objects[i]->object_id < 0) world.objects[i]->object_id = static_cast<int>(i);
+    }
     auto create_scene_end_time = std::chrono::steady_clock::now();
     auto create_scene_duration = std::chrono::duration<double, std::milli>(create_scene_end_time - start_time);
     std::cout << "Create Scene Duration: " << create_scene_duration.count() / 1000 << " seconds" << std::endl;
 
-    std::thread display_thread(&Renderer::update_display, this, window, surface);
+    // window == nullptr: pencere olmadan (benchmark, batch) render
+    std::thread display_thread;
+    if (window) {
+        display_thread = std::thread(&Renderer::update_display, this, window, surface);
+    }
 
     const int num_passes = (total_samples_per_pixel + samples_per_pass - 1) / samples_per_pass;
+    RayStats::reset();
+    if (cost_metric != CostMetric::None) {
+        cost_buffer.assign(static_cast<size_t>(image_width) * image_height, 0.0f);
+    }
+    // Denoiser albedo/normal/depth AOV'larn klavuz olarak kullanr
+    film.reset(image_width, image_height, requested_aovs | (denoise_final || denoise_progressive ? Denoiser::guideAovs() : 0));
+    if (path_guiding) {
+        AABB bounds;
+        bvh->bounding_box(0.0, 1.0, bounds);
+        path_guide.reset(bounds, guide_settings);
+    }
+    if (radiance_caching) {
+        AABB bounds;
+        bvh->bounding_box(0.0, 1.0, bounds);
+        radiance_cache.reset(bounds, scene.camera.lookfrom, cache_settings);
+    }
+    double trace_seconds = 0.0; // sadece geilerin sresi, Mrays/s buna gre hesaplanr
+    double post_seconds = 0.0;  // denoise + ekran dnm sresi; gei callback'ine eklenir
 
     for (int pass = 0; pass < num_passes; ++pass) {
+        PROFILE_SCOPE("pass");
         std::cout << "Starting pass " << pass + 1 << " of " << num_passes << std::endl;
 
         next_row.store(0);  // Reset next_row for each pass
+        guide_training = path_guiding && path_guide.isTraining(pass);
+        auto pass_start_time = std::chrono::steady_clock::now();
 
         for (unsigned int t = 0; t < num_threads; ++t) {
-            threads.emplace_back(&Renderer::render_worker, this, image_height, surface, std::ref(world),
+            threads.emplace_back(&Renderer::render_worker, this, image_height,
                 std::ref(lights), background_color, bvh.get(), samples_per_pass, pass * samples_per_pass);
         }
 
@@ -62,22 +98,52 @@ void Renderer::render_image(SDL_Surface* surface, SDL_Window* window, const int
 
         threads.clear();
 
+        const double pass_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - pass_start_time).count();
+        trace_seconds += pass_seconds;
+        RayStats::printPass(std::cout, pass + 1, RayStats::takePass(), pass_seconds);
+        if (guide_training) {
+            // Eitim geiinin kaytlar dalmlara dnr; sonraki geiler yeni rehberle rnekler
+            const auto refine_start = std::chrono::steady_clock::now();
+            path_guide.refine();
+            post_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - refine_start).count();
+            std::cout << "Path guide: " << path_guide.leafCount() << " spatial cells, " << path_guide.directionalNodeCount() << " directional nodes" << std::endl;
+        }
+        if (radiance_caching) {
+            std::cout << "Radiance cache: " << radiance_cache.cellCount() << " cells" << std::endl;
+        }
+        film.samples = (pass + 1) * samples_per_pass;
+        // Ekran dnm gei bana bir kez, glgelendirme i paracklar bittikten sonra yaplr
+        const auto post_start = std::chrono::steady_clock::now();
+        if (denoise_progressive || (denoise_final && pass + 1 == num_passes)) {
+            denoise_to_surface(surface);
+        }
+        else {
+            DisplayTransform::resolve(film.color.data(), 1.0 / film.samples, image_width, image_height, surface, display);
+        }
+        post_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - post_start).count();
+        if (pass_callback) {
+            pass_callback(pass + 1, std::min((pass + 1) * samples_per_pass, total_samples_per_pixel), trace_seconds + post_seconds, surface);
+        }
+
         // Her geiten sonra ilerleme ubuunu gncelle
         float progress = static_cast<float>(pass + 1) / num_passes;
        // draw_progress_bar(surface, progress);
         
         std::cout << "\rRendering progress: " << std::fixed << std::setprecision(2) << progress << "%" << std::flush;
         // Pencere baln gncelle
-        char title[100];
-        snprintf(title, sizeof(title), "Rendering... %.1f%% Complete", progress * 100);
-        SDL_SetWindowTitle(window, title);
-
-        SDL_UpdateWindowSurface(window);
+        if (window) {
+            char title[100];
+            snprintf(title, sizeof(title), "Rendering... %.1f%% Complete", progress * 100);
+            SDL_SetWindowTitle(window, title);
+            SDL_UpdateWindowSurface(window);
+        }
         std::cout << "Pass " << pass + 1 << " completed. Progress: " << (progress * 100) << "%" << std::endl;
     }
 
     rendering_complete = true;
-    display_thread.join();
+    if (display_thread.joinable()) {
+        display_thread.join();
+    }
 
     std::cout << "\nRender completed." << std::endl;
     auto render_end_time = std::chrono::steady_clock::now();
@@ -87,9 +153,14 @@ void Renderer::render_image(SDL_Surface* surface, SDL_Window* window, const int
 
     std::cout << "Render Duration: " << render_duration.count() / 1000 << " seconds" << std::endl;
     std::cout << "Total Duration: " << total_duration.count() / 1000 << " seconds" << std::endl;
+    last_ray_counters = RayStats::total();
+    last_trace_seconds = trace_seconds;
+    RayStats::printSummary(std::cout, last_ray_counters, trace_seconds);
 
     // Render tamamlandnda pencere baln gncelle
-    SDL_SetWindowTitle(window, "Render Completed");
+    if (window) {
+        SDL_SetWindowTitle(window, "Render Completed");
+    }
 }
 
 // Dier fonksiyonlar (render_worker, render_chunk) ayn kalacak
@@ -108,16 +179,6 @@ Vec3 calculateNormal(const Vec3& v1, const Vec3& v2, const Vec3& v3) {
     Vec3 edge2 = v3 - v1;
     return (edge1.cross(edge2)).normalize();
 }
-// OBJ dosyalarnn listesi ve her biri iin bir materyal
-
-// Texture ykleme fonksiyonu
-
-struct ObjFile {
-    std::string filename;
-    std::shared_ptr<Material> material;
-    std::string texturePath;  // Objeye ait texture dosya yolu
-    
-};
 std::shared_ptr<Material> loadMaterialFromMtl(const std::string& materialName) {
     // MTL dosyasndan materyal bilgilerini ykleme
     // rnein, bir dosya okuyucu ve analizci ile
@@ -131,240 +192,275 @@ std::shared_ptr<Material> loadMaterialFromMtl(const std::string& materialName) {
     return std::make_shared<Lambertian>(Vec3(0.5f, 0.5f, 0.5f),0,0); // Gri
 }
 
-std::pair<HittableList, std::shared_ptr<ParallelBVHNode>> Renderer::create_scene(std::vector<std::shared_ptr<Light>>& lights, Vec3SIMD& background_color) {
-    HittableList world;
-    Vec3 v0, v1, v2;
-   
-    atmosphericEffects.use_background_texture = true;
-    atmosphericEffects.setBackgroundTexture("Texture/kure.jpg");
-    background_color = { 0.3, 0.4, 0.5 };   
-    atmosphericEffects.enable = true;
-    AtmosphericEffects atmosphericEffects(
-        100.0f,  // fog_start_distance
-        0.01f,   // fog_base_density
-        0.0001f, // fog_distance_factor
-        0.0002f  // haze_density
-    );
-    
-// Albedo, roughness, ve metallic iin texture oluturma
-    auto albedo_texture = std::make_shared<Texture>("Texture/granidalbedo.jpg");
-    auto roughness_texture = std::make_shared<Texture>("Texture/granidroug.jpg");
-    auto metallic_texture = std::make_shared<Texture>("Texture/granidroug.jpg");
-    auto Normal_texture = std::make_shared<Texture>("Texture/granidnormal.jpg");
-
-    Lambertian::TextureTransform customTransform(
-        Vec2(1.0, 1.0),  // scale
-        0.0,             // rotation
-        Vec2(0.0, 0.0),  // translation (orijinal rnekte belirtilmemi)
-        Vec2(2.0, 2.0),  // tiling
-        WrapMode::Planar // wrap mode (varsaylan olarak Repeat kullanld)
-    );
-    auto ground_material = std::make_shared<Lambertian>(albedo_texture, 0.05,0.9, Normal_texture, customTransform);
-    //TextureTransform customTransform(Vec2(1.0, 1.0), 0.0, Vec2(1.0, 1.0));
-    // Yeni PBR zelliklerini ayarlama
-    ground_material->setSpecular(Vec3(1, 1, 1), 1.0f);
-    ground_material->setEmission(Vec3(0.8, 0.1, 0.1), 0.0f); // Hafif bir emission ekleyelim
-    ground_material->setClearcoat(0.5f, 0.1f); // %50 clearcoat, 0.1 roughness ile
-   // ground_material->setAnisotropic(0.0f, Vec3(1, 0, 0)); // X ynnde %50 anizotropik
-    //ground_material->setMetallic(1.0, 0.0);
-    //ground_material->setSubsurfaceScattering(Vec3(0.8, 0.2, 0.2), 0.1f); // Krmzms subsurface scattering
-
-    // Opsiyonel: Wrap mode'u ayarlama
-    //customTransform.wrapMode = WrapMode::Mirror;
-    ground_material->setTextureTransform(customTransform);
-   
-
-   // customTransform.wrapMode= WrapMode::Clamp;
-    // Lambertian materyali oluturma
-   // auto ground_material = std::make_shared<Lambertian>(albedo_texture, roughness_texture, 0.95, Normal_texture, customTransform);
-
-    auto kaput_albedo = std::make_shared<Texture>("Texture/lambert/3dif.jpg");
-   
-    auto kaput_rough = std::make_shared<Texture>("Texture/lambert/3roug.jpg");
-    auto kaput_normal = std::make_shared<Texture>("Texture/lambert/3nor.jpg");
-    auto Home_texture1 = std::make_shared<Texture>("Texture/lambert/3dif.jpg");
-
-    auto car1_Material = std::make_shared<Metal>(Vec3(0.97f, 0.96f, 0.91f), 0.2, 1, 0.0, 1);
-    car1_Material->setSpecular(Vec3(1, 1, 1), 1.0f);
-    car1_Material->setClearcoat(1, 0.0, Vec3(0.97f, 0.96f, 0.91f));
-    car1_Material->setMetallic(1.0f, 1.0f, Vec3(0.97f, 0.96f, 0.91f));
-    car1_Material->setAnisotropic(0.0, Vec3(0, 0, 0.0));
-    car1_Material->setEmission(Vec3(0.1, 0.1, 0.1), 0.0);
-   
-   // car1_Material->setSubsurfaceScattering(Vec3(0.8,0.6, 0.4), 1.0f);
-    //Home_Material->setTilingFactor(Vec2(0.1, 0.1));  //  tiling
-   
+std::shared_ptr<ParallelBVHNode> Renderer::create_scene(HittableList& world, std::vector<std::shared_ptr<Light>>& lights, Vec3SIMD& background_color) {
+    // Sahne artk kodda deil, sahne dosyasnda tanml (bkz. default_scene.json)
+    return SceneLoader::build(scene, world, lights, atmosphericEffects, background_color);
+}
 
-    auto lastik_Material = std::make_shared<Metal>(Vec3(0.1, 0.1, 0.1), 0.012, 0.1, 0.2, 0.1);
-    lastik_Material->setEmission(Vec3(0.1, 0.1, 0.1), 0.0f); // Hafif bir emission ekleyelim
-    lastik_Material->setClearcoat(0.2, 0.2, Vec3(0.91, 0.92, 0.92));
-    lastik_Material->setSpecular(Vec3(1, 1, 1), 1.0f);
-    lastik_Material->setAnisotropic(0.0f, Vec3(1, 0, 1)); // X ynnde %50 anizotropik
-    //lastik_Material->setSubsurfaceScattering(Vec3(0.2, 0.2, 0.9), 0.2f); //  subsurface scattering
-    //Home_Material1->setTilingFactor(Vec2(0.01,0.01));  //  tiling
-    auto jant_Material = std::make_shared<Metal>(Vec3(0.97f, 0.96f, 0.91f), 0.2, 1, 0.0, 1);
-    jant_Material->setSpecular(Vec3(1, 1, 1), 1.0f);
-    jant_Material->setClearcoat(1, 0, Vec3(0.97f, 0.96f, 0.91f));
-    jant_Material->setMetallic(1, 1, Vec3(0.97f, 0.96f, 0.91f));
-    jant_Material->setEmission(Vec3(0.1, 0.1, 0.1), 0.0);
-
-    auto dielectric_material = std::make_shared<Dielectric>(1.5,Vec3(1,1,1), 0,0.006,0.2,0.001);
-    auto clean_windshield = std::make_shared<Dielectric>(1.0, Vec3(0.88, 0.88, 0.9), 0.1, 0.006, 0.2, 0.001);
-    auto decorative_glass = std::make_shared<Dielectric>(1.5, Vec3(0.9, 0.9, 0.92), 0.1, 0.01, 0.5, 0.001);
-    auto old_windshield = std::make_shared<Dielectric>(1.5, Vec3(0.95, 0.95, 0.97), 0.08, 0.006, 0.15, 0.01);
-    auto glass_block = std::make_shared<Dielectric>(1.5, Vec3(0.9, 0.95, 1.0), 0.2, 0.05, 0.008, 0.5);
-
-    auto kure_texture = std::make_shared<Texture>("Texture/kure.jpg");
-    Lambertian::TextureTransform kureTransform(
-        Vec2(1.0, 1.0),  // scale
-        30.0,             // rotation
-        Vec2(0.0, 0.0),  // translation (orijinal rnekte belirtilmemi)
-        Vec2(1.0, 1.0),  // tiling
-        WrapMode::Planar // wrap mode (varsaylan olarak Repeat kullanld)
-    );
-    Lambertian::TextureTransform kure(Vec2(1.0, 1.0), 0.0, Vec2(1.0, 1.0), Vec2(1.0, 1.0));
-    auto kure_material = std::make_shared<Lambertian>(kure_texture, 0, 0.0, kureTransform);
-    kure_material->setEmission(Vec3(0.1, 0.2, 0.2), 1);
-    kure_material->setSpecular(Vec3(0.5, 0.5, 0.5), 1);
-   // kure_material->setTextureTransform(kure);
-    auto ic_Material = std::make_shared<Lambertian>(Vec3(0.8, 0.4, 0.2), 0.1, 0.0);
-    ic_Material->setEmission(Vec3(0.1, 0.1, 0.1), 0.1f); // Hafif bir emission ekleyelim
-    //ic_Material->setClearcoat(0.0, 0.0);
-    ic_Material->setSpecular(Vec3(1, 1, 1), 1.0f);
-    //ic_Material->setAnisotropic(0.0f, Vec3(1, 0, 1)); // X ynnde %50 anizotropik
-   // ic_Material->setSubsurfaceScattering(Vec3(0.8, 0.7, 0.2), 0.5f); //  subsurface scattering
-//    auto kaput_Material = std::make_shared<Metal>(Vec3(0, 0, 0), 1);
-    
-    // Transform triangles and add to world
-   // OBJ dosyalarn ve materyallerini tanmlayalm
-    std::vector<ObjFile> obj_files = {
-        {"obj/ground.obj", ground_material},
-        {"car/kaput.obj", car1_Material},
-        {"car/camlar.obj", clean_windshield},
-        {"car/far.obj", decorative_glass},
-        {"car/farici.obj", jant_Material},
-        {"car/lastik.obj", lastik_Material},
-        {"car/jant.obj", jant_Material},
-        {"car/ic.obj", ic_Material},
-        {"obj/kure.obj", kure_material},
-   
-       // {"obj/ground.obj", loadMaterialFromMtl("ground.mtl")},
-       //{"obj/kure.obj", loadMaterialFromMtl("kure.mtl")}
-        // Dier obj dosyalar ve materyalleri buraya eklenebilir
-    };
-    ObjLoaderAdapter objAdapter;
-    for (const auto& obj_file : obj_files) {
-        std::vector<std::unique_ptr<Triangle>> triangles = objAdapter.loadObjToTriangles(obj_file.filename);
-        if (!triangles.empty()) {
-            // Tm genler iin ayn materyali kullan
-            std::shared_ptr<Material> materialToUse = obj_file.material;
-
-            for (auto& triangle : triangles) {
-                // Orijinal UV koordinatlarn koru
-                world.add(std::make_unique<Triangle>(
-                    triangle->v0, triangle->v1, triangle->v2,
-                    triangle->n0, triangle->n1, triangle->n2,
-                    triangle->t0, triangle->t1, triangle->t2,
-                    materialToUse,
-                    triangle->smoothGroup
-                ));
-            }
-            std::cout << obj_file.filename << " yklendi. gen says: " << triangles.size() << std::endl;
+template <typename RayAt>
+void Renderer::intersect_packets(const ParallelBVHNode* bvh, size_t count, RayAt&& ray_at, HitRecord* records, uint8_t* hit_flags) {
+    PROFILE_HOT_SCOPE("intersect");
+    RayPacket packet;
+    for (size_t base = 0; base < count; base += RayPacket::kMaxRays) {
+        const int lanes = static_cast<int>(std::min<size_t>(RayPacket::kMaxRays, count - base));
+        packet.begin(kSpawnTMin);
+        for (int i = 0; i < lanes; ++i) {
+            packet.add(ray_at(base + i), std::numeric_limits<float>::infinity());
+            records[base + i] = HitRecord();
         }
-        else {
-            std::cerr << obj_file.filename << " yklenemedi. Dier nesnelerle devam ediliyor." << std::endl;
+        packet.finish();
+        const uint32_t hits = bvh->hit_packet(packet, packet.allRays(), records + base);
+        for (int i = 0; i < lanes; ++i) {
+            hit_flags[base + i] = (hits >> i) & 1u;
         }
     }
-   // Add boxes and other objects to the world and their bounds to object_bounds
-   std::vector<std::pair<Vec3, double>> object_bounds;
-    auto add_object = [&](std::shared_ptr<Hittable> obj, const Vec3& center, double size) {
-        world.add(obj);
-        object_bounds.emplace_back(center, size);
-        };
-    
-      // Ik ekle
-    //lights.push_back(std::make_shared<PointLight>(Vec3(6, 5, 6), Vec3(42, 41, 40),0));
-   // lights.push_back(std::make_shared<PointLight>(Vec3(-3, 5, 6), Vec3(50, 50, 50), 0));
-    //lights.push_back(std::make_shared<PointLight>(Vec3(0, 5, 1), Vec3(5, 2, 2),10));
-    lights.push_back(std::make_shared<DirectionalLight>(Vec3(5, -8, 2), Vec3(1.55, 1.5, 1.45)));
-    //lights.push_back(std::make_shared<AreaLight>(Vec3(-5, 50, -1), Vec3(-5, -1, 2), Vec3(-5, -1, 2), 1, 1, Vec3(4, 3, 3)));
-
-    std::cout << "Total objects in the scene: " << world.size() << std::endl;
-
-    // BVH'yi olutur
-   
-    //auto bvh = std::make_shared<BVHNode>(world.objects, 0, world.objects.size(), 0.0, 1.0);
-    auto bvh = std::make_shared<ParallelBVHNode>(world.objects, 0, world.objects.size(), 0.0, 1.0);
+}
 
-    return std::make_pair(world, bvh);
+template <typename OriginAt>
+void Renderer::sun_shadow_packets(const ParallelBVHNode* bvh, size_t count, OriginAt&& origin_at, const Vec3& direction, Vec3SIMD* transmittance) {
+    PROFILE_HOT_SCOPE("shadow");
+    RayPacket packet;
+    HitRecord records[RayPacket::kMaxRays];
+    for (size_t base = 0; base < count; base += RayPacket::kMaxRays) {
+        const int lanes = static_cast<int>(std::min<size_t>(RayPacket::kMaxRays, count - base));
+        packet.begin(kSpawnTMin);
+        for (int i = 0; i < lanes; ++i) {
+            packet.add(Ray(origin_at(base + i), direction), std::numeric_limits<float>::infinity());
+            records[i] = HitRecord();
+        }
+        packet.finish();
+        RAY_STAT_ADD(shadow_rays, lanes);
+        const uint32_t hits = bvh->hit_packet(packet, packet.allRays(), records);
+        for (int i = 0; i < lanes; ++i) {
+            transmittance[base + i] = shadow_after_first_hit(bvh, (hits >> i) & 1u, records[i], origin_at(base + i), direction,
+                std::numeric_limits<float>::infinity());
+        }
+    }
+}
 
+template <typename RayAt, typename TMaxAt>
+void Renderer::intersect_interleaved(const ParallelBVHNode* bvh, size_t count, RayAt&& ray_at, TMaxAt&& t_max_at, HitRecord* records, uint8_t* hit_flags) {
+    thread_local std::vector<Ray> stream_rays;
+    thread_local std::vector<double> stream_t_max;
+    stream_rays.resize(count);
+    stream_t_max.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        stream_rays[k] = ray_at(k);
+        stream_t_max[k] = t_max_at(k);
+        records[k] = HitRecord();
+    }
+    bvh->hit_interleaved(count, stream_rays.data(), kSpawnTMin, stream_t_max.data(), records, hit_flags);
+}
 
+Vec3SIMD Renderer::shadow_after_first_hit(const ParallelBVHNode* bvh, bool occluded, const HitRecord& rec, const Vec3& origin, const Vec3& direction, float distance) {
+    if (!occluded) return Vec3SIMD(1, 1, 1);
+    Vec3 bent = direction;
+    if (integrator.shadow_glass == ShadowGlass::Opaque ||
+        !(Vec3SIMD(rec.material->shadow_transmittance(rec, bent, integrator.shadow_glass != ShadowGlass::Refract)).max_component() > 0.0f)) {
+        return Vec3SIMD(0, 0, 0);
+    }
+    // Camda duran n tek bana batan izlenir: shadow_transmittance ile birebir ayn sonu
+    return shadow_transmittance(bvh, origin, direction, distance);
 }
 
-void Renderer::render_chunk(int start_row, int end_row, SDL_Surface* surface, const HittableList& world,
+void Renderer::render_chunk(int start_row, int end_row,
     const std::vector<std::shared_ptr<Light>>& lights, const Vec3& background_color,
     const ParallelBVHNode* bvh, const int samples_per_pass, const int current_sample) {
-    // Define camera and world
-    Vec3 lookfrom(2.2, 1.2, 3.9);
-    Vec3 lookat(-2.0, 0.0, -1);
-    Vec3 vup(0, 1, 0);
-    double vfov = 40.0;
-    double aperture = 0.0;
-    double dist_to_focus = 2.3;// (lookfrom - lookat).length();
-    Camera cam(lookfrom, lookat, vup, vfov, aspect_ratio, aperture, dist_to_focus);
-    ThreadLocalRNG rng;
+    PROFILE_SCOPE("tile");
+    // Kamera sahne dosyasndan gelir
+    const CameraSettings& c = scene.camera;
+    Camera cam(c.lookfrom, c.lookat, c.vup, c.vfov, aspect_ratio, c.aperture, c.focus_distance);
+    // Tohum i paracna deil (satr, rnek) iftine bal: ayn seed ile render tekrarlanabilir
+    const uint32_t chunk_seed = hash_seed(scene.render.seed, static_cast<uint32_t>(start_row), static_cast<uint32_t>(current_sample));
+    ThreadLocalRNG rng(chunk_seed);
+    seed_random(chunk_seed ^ 0x9E3779B9u);
+    if (integrator.type == IntegratorType::Wavefront) {
+        render_rows_wavefront(start_row, end_row, lights, Vec3SIMD(background_color), bvh, samples_per_pass, cam, rng);
+        return;
+    }
+
+    // Paket modunda bir satrn btn kamera nlar nce retilir (ayn rng sras) ve paketlerle kesitirilir.
+    // Maliyet haritas piksel bana tam maliyet istedii iin tek nla kalr
+    const bool use_packets = ray_packets && integrator.type == IntegratorType::Path && cost_metric == CostMetric::None;
+    const DirectionalLight* sun = nullptr;
+    for (const auto& light : lights) {
+        if ((sun = dynamic_cast<const DirectionalLight*>(light.get()))) break;
+    }
+    thread_local std::vector<Ray> row_rays;
+    thread_local std::vector<HitRecord> row_records;
+    thread_local std::vector<uint8_t> row_hits;
+    thread_local std::vector<PrimaryHit> row_primary;
+    thread_local std::vector<size_t> sun_lanes;
+    thread_local std::vector<Vec3SIMD> sun_transmittance;
 
     // Iterate over pixels in chunk
     for (int j = end_row; j >= start_row; --j) {
+        if (use_packets) {
+            const size_t row_samples = static_cast<size_t>(image_width) * samples_per_pass;
+            row_rays.resize(row_samples);
+            row_records.resize(row_samples);
+            row_hits.resize(row_samples);
+            row_primary.resize(row_samples);
+            for (int i = 0; i < image_width; ++i) {
+                for (int s = 0; s < samples_per_pass; ++s) {
+                    auto u = (i + rng.get()) / (image_width - 1);
+                    auto v = (j + rng.get()) / (image_height - 1);
+                    row_rays[static_cast<size_t>(i) * samples_per_pass + s] = cam.get_ray(u, v);
+                }
+            }
+            intersect_packets(bvh, row_samples, [&](size_t k) { return row_rays[k]; }, row_records.data(), row_hits.data());
+            sun_lanes.clear();
+            for (size_t k = 0; k < row_samples; ++k) {
+                PrimaryHit& primary = row_primary[k];
+                primary.hit = row_hits[k] != 0;
+                primary.has_sun = false;
+                if (!primary.hit) continue;
+                primary.rec = std::move(row_records[k]);
+                // ray_color dorudan  sadece bu malzemelerde hesaplar
+                const MaterialType type = primary.rec.material->type();
+                if (sun && type != MaterialType::Dielectric && type != MaterialType::Volumetric) sun_lanes.push_back(k);
+            }
+            if (!sun_lanes.empty()) {
+                // calculate_direct_lighting ile ayn balang noktas ve float yuvarlamal yn
+                const Vec3 sun_direction = static_cast<Vec3>(-Vec3SIMD(sun->direction));
+                sun_transmittance.resize(sun_lanes.size());
+                sun_shadow_packets(bvh, sun_lanes.size(), [&](size_t k) { return offset_ray_origin(row_primary[sun_lanes[k]].rec, sun_direction); },
+                    sun_direction, sun_transmittance.data());
+                for (size_t k = 0; k < sun_lanes.size(); ++k) {
+                    row_primary[sun_lanes[k]].has_sun = true;
+                    row_primary[sun_lanes[k]].sun_transmittance = sun_transmittance[k];
+                }
+            }
+        }
         for (int i = 0; i < image_width; ++i) {
+            const auto pixel_start_time = cost_metric == CostMetric::Time ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+            const uint64_t pixel_start_work = RayStats::local.node_visits + RayStats::local.triangle_tests + RayStats::local.sphere_tests;
+            const size_t pixel_index = film.index(i, image_height - 1 - j);
+            const bool want_aovs = film.aov_mask != 0;
             Vec3 new_color(0, 0, 0);
+            float luminance_sum = 0.0f, luminance_sq_sum = 0.0f;
             // Accumulate colors from multiple samples
             for (int s = 0; s < samples_per_pass; ++s) {
                 // Generate ray
-                auto u = (i + rng.get()) / (image_width - 1);
-                auto v = (j + rng.get()) / (image_height - 1);
-                Ray r = cam.get_ray(u, v);
+                Ray r;
+                const PrimaryHit* primary = nullptr;
+                if (use_packets) {
+                    r = row_rays[static_cast<size_t>(i) * samples_per_pass + s];
+                    primary = &row_primary[static_cast<size_t>(i) * samples_per_pass + s];
+                }
+                else {
+                    auto u = (i + rng.get()) / (image_width - 1);
+                    auto v = (j + rng.get()) / (image_height - 1);
+                    r = cam.get_ray(u, v);
+                }
                 // Calculate ray color
-                new_color += ray_color(r, bvh, lights, background_color, MAX_DEPTH);
+                AovSample aov;
+                const Vec3 sample_color = integrator.type == IntegratorType::Path
+                    ? ray_color(r, bvh, lights, background_color, MAX_DEPTH, want_aovs ? &aov : nullptr, primary)
+                    : preview_color(r, bvh, lights, background_color, want_aovs ? &aov : nullptr);
+                new_color += sample_color;
+                const float luminance = Film::luminanceOf(sample_color);
+                luminance_sum += luminance;
+                luminance_sq_sum += luminance * luminance;
+                if (want_aovs) {
+                    film.addAov(pixel_index, aov);
+                }
             }
+            // Film'e her piksel tek bir i parac tarafndan yazlr
+            film.color[pixel_index] += new_color;
+            film.luminance[pixel_index] += luminance_sum;
+            film.luminance_sq[pixel_index] += luminance_sq_sum;
+
+            // Her piksel tek bir i parac tarafndan yazlr, kilit gerekmez
+            if (cost_metric == CostMetric::Time) {
+                cost_buffer[static_cast<size_t>(image_height - 1 - j) * image_width + i] +=
+                    std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - pixel_start_time).count();
+            }
+            else if (cost_metric == CostMetric::Traversal) {
+                cost_buffer[static_cast<size_t>(image_height - 1 - j) * image_width + i] += static_cast<float>(
+                    RayStats::local.node_visits + RayStats::local.triangle_tests + RayStats::local.sphere_tests - pixel_start_work);
+            }
+        }
+    }
+}
 
-            // Get existing color (linear space)
-            std::lock_guard<std::mutex> lock(mtx);
-            Uint32* pixel = static_cast<Uint32*>(surface->pixels) + (image_height - 1 - j) * surface->pitch / 4 + i;
-            Uint8 r, g, b;
-            SDL_GetRGB(*pixel, surface->format, &r, &g, &b);
-            Vec3 existing_color(r / 255.0, g / 255.0, b / 255.0);
-            existing_color = Vec3(existing_color.x * existing_color.x, existing_color.y * existing_color.y, existing_color.z * existing_color.z); // Gamma decode
-
-            // Combine existing and new colors in linear space
-            int total_samples = current_sample + samples_per_pass;
-            Vec3 combined_color = (existing_color * current_sample + new_color) / total_samples;
-
-            // Gamma correction
-            combined_color = Vec3(sqrt(combined_color.x), sqrt(combined_color.y), sqrt(combined_color.z));
-
-            // Convert color to SDL pixel format
-            int ir = static_cast<int>(256 * clamp(combined_color.x, 0.0, 0.999));
-            int ig = static_cast<int>(256 * clamp(combined_color.y, 0.0, 0.999));
-            int ib = static_cast<int>(256 * clamp(combined_color.z, 0.0, 0.999));
+bool Renderer::save_aovs(const std::string& output) const {
+    bool ok = true;
+    for (int t = 0; t < static_cast<int>(AovType::Count); ++t) {
+        const AovType type = static_cast<AovType>(t);
+        if (!(requested_aovs & aovBit(type))) continue;
+        ok = Aov::writePreview(film.resolveAov(type), type, image_width, image_height, Aov::pathFor(output, type)) && ok;
+    }
+    return ok;
+}
 
-            // Set pixel color in SDL surface
-            *pixel = SDL_MapRGB(surface->format, ir, ig, ib);
+bool Renderer::save_hdr(const std::string& filename, bool half) const {
+    HdrImage::Image image;
+    image.width = film.width;
+    image.height = film.height;
+    image.samples = film.samples;
+
+    // Ana RGB her zaman ham film ortalamas: ksmi render'lar ancak byle birletirilebilir
+    HdrImage::Layer beauty;
+    beauty.values.resize(static_cast<size_t>(film.width) * film.height * 3);
+    for (size_t i = 0; i < beauty.values.size() / 3; ++i) {
+        const Vec3 c = film.meanColor(i);
+        beauty.values[i * 3 + 0] = static_cast<float>(c.x);
+        beauty.values[i * 3 + 1] = static_cast<float>(c.y);
+        beauty.values[i * 3 + 2] = static_cast<float>(c.z);
+    }
+    image.layers.push_back(std::move(beauty));
+
+    if (!denoised.empty() && denoised.size() == static_cast<size_t>(film.width) * film.height) {
+        HdrImage::Layer layer;
+        layer.name = "denoised";
+        layer.values.resize(denoised.size() * 3);
+        for (size_t i = 0; i < denoised.size(); ++i) {
+            layer.values[i * 3 + 0] = static_cast<float>(denoised[i].x);
+            layer.values[i * 3 + 1] = static_cast<float>(denoised[i].y);
+            layer.values[i * 3 + 2] = static_cast<float>(denoised[i].z);
         }
+        image.layers.push_back(std::move(layer));
+    }
+    for (int t = 0; t < static_cast<int>(AovType::Count); ++t) {
+        const AovType type = static_cast<AovType>(t);
+        if (!(requested_aovs & aovBit(type))) continue;
+        HdrImage::Layer layer;
+        layer.name = Aov::name(type);
+        layer.channels = Aov::channels(type);
+        layer.is_id = Aov::isId(type);
+        layer.values = film.resolveAov(type);
+        image.layers.push_back(std::move(layer));
     }
+
+    if (!HdrImage::write(filename, image, half)) {
+        return false;
+    }
+    std::cout << "HDR image written to " << filename << std::endl;
+    return true;
+}
+
+// Filmi denoise edip ekran yzeyine yazar; film kendisi grltl kalr ki sonraki geiler ona eklensin
+void Renderer::denoise_to_surface(SDL_Surface* surface) {
+    Denoiser::denoise(film, denoised);
+    DisplayTransform::resolve(denoised.data(), 1.0, image_width, image_height, surface, display);
 }
 
-void Renderer::render_worker(int image_height, SDL_Surface* surface, const HittableList& world,
+void Renderer::render_worker(int image_height,
     const std::vector<std::shared_ptr<Light>>& lights, const Vec3& background_color,
     const ParallelBVHNode* bvh, const int samples_per_pass, const int current_sample) {
+    if (Profiler::instance().isEnabled()) {
+        Profiler::instance().setThreadName("render worker");
+    }
     while (true) {
         int start_row = next_row.fetch_add(16); // 16 satrlk chunk'lar
         if (start_row >= image_height) {
             break;
         }
         int end_row = std::min(start_row + 15, image_height - 1);
-        render_chunk(start_row, end_row, surface, world, lights, background_color, bvh, samples_per_pass, current_sample);
+        render_chunk(start_row, end_row, lights, background_color, bvh, samples_per_pass, current_sample);
     }
+    RayStats::flushThread();
 }
 
 
@@ -418,38 +514,85 @@ void Renderer::create_coordinate_system(const Vec3& N, Vec3& T, Vec3& B) {
 }
 
 
-Vec3SIMD Renderer::ray_color(const Ray& r, const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const Vec3SIMD& background_color, int depth) {
+Vec3SIMD Renderer::ray_color(const Ray& r, const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const Vec3SIMD& background_color, int depth, AovSample* aov,
+    const PrimaryHit* primary) {
     Vec3SIMD final_color(0, 0, 0);
     Vec3SIMD throughput(1, 1, 1);
     Ray current_ray = r;
     float total_distance = 0.0f;
     Vec3SIMD sky_color;
-    for (int bounce = 0; bounce < MAX_DEPTH; ++bounce) {
+    RAY_STAT_INC(paths);
+    // Rehber eitimi iin difz keler: konum, sekme yn, o ana kadarki renk ve throughput, rnekleme pdf'i ve kosins
+    struct GuideVertex {
+        Vec3 point;
+        Vec3 direction;
+        Vec3SIMD color;
+        Vec3SIMD throughput;
+        float pdf;
+        float cosine;
+    };
+    constexpr int kMaxGuideVertices = 16;
+    GuideVertex guide_vertices[kMaxGuideVertices];
+    int guide_vertex_count = 0;
+    // Inm nbellei iin difz keler: konum, ynlendirilmi normal, dorudan ktan sonraki renk ve gelen throughput
+    struct CacheVertex {
+        Vec3 point;
+        Vec3 normal;
+        Vec3SIMD color;
+        Vec3SIMD throughput;
+    };
+    constexpr int kMaxCacheVertices = 16;
+    CacheVertex cache_vertices[kMaxCacheVertices];
+    int cache_vertex_count = 0;
+    bool diffuse_bounce = false; // yol en az bir difz yzeyden sekti mi
+    for (int bounce = 0; bounce < depth; ++bounce) {
         HitRecord rec;
-        if (!bvh->hit(current_ray, EPSILON, std::numeric_limits<float>::infinity(), rec)) {
+        bool hit;
+        {
+            PROFILE_HOT_SCOPE("intersect");
+            if (bounce == 0) RAY_STAT_INC(primary_rays);
+            else RAY_STAT_INC(bounce_rays);
+            if (bounce == 0 && primary) {
+                hit = primary->hit;
+                if (hit) rec = primary->rec;
+            }
+            else {
+                hit = bvh->hit(current_ray, kSpawnTMin, std::numeric_limits<float>::infinity(), rec);
+            }
+        }
+        if (!hit) {
             if (atmosphericEffects.enable) {
                 if (background_texture) {
                     // Eer background texture varsa, onu kullan
-                    float u = 0.5f + std::atan2(current_ray.direction.z, current_ray.direction.x) / (2 * M_PI);
-                    float v = 0.5f - std::asin(current_ray.direction.y) / M_PI;
+                    float u = 0.5f + fastmath::atan2(static_cast<float>(current_ray.direction.z), static_cast<float>(current_ray.direction.x)) / (2 * M_PI);
+                    float v = 0.5f - fastmath::asin(static_cast<float>(current_ray.direction.y)) / M_PI;
                     sky_color = background_texture->get_color(u, v);
                 }
-                else if (!background_texture) {
+                else {
                     // Yoksa background_color' kullan
                     sky_color = background_color;
                     final_color += throughput * atmosphericEffects.applyAtmosphericEffects(sky_color, total_distance);
                 }
-                else {
-                    final_color += throughput * background_color;
-                }
-                break;
             }
+            else {
+                // Atmosfer kapal (sahne dosyasnda "enable": false): sis olmadan dz arka plan rengi
+                final_color += throughput * background_color;
+            }
+            break;
         }
         // Normal map uygulamas
         Vec3SIMD original_normal(rec.normal);
         Vec3SIMD transformed_normal = apply_normal_map(rec);
         rec.normal = static_cast<Vec3>(transformed_normal);
 
+        if (bounce == 0 && aov) {
+            aov->normal = rec.normal;
+            aov->depth = static_cast<float>(rec.t);
+            aov->material_id = rec.material->material_id;
+            aov->object_id = rec.object_id;
+        }
+
+        RAY_STAT_INC(path_segments);
         float segment_distance = rec.t;
         total_distance += segment_distance;
 
@@ -466,21 +609,52 @@ Vec3SIMD Renderer::ray_color(const Ray& r, const ParallelBVHNode* bvh, const std
         // Malzeme ilemleri...
         Vec3SIMD emitted = Vec3SIMD(rec.material->emitted(rec.u, rec.v, rec.point));
         final_color += throughput * emitted;
+        if (bounce == 0 && aov) aov->emission = emitted;
 
        
          if (rec.material->type() == MaterialType::Volumetric) {
             // Volumetric malzeme ilemleri...
         }
         else {
+            PROFILE_HOT_SCOPE("shade");
             Vec3 attenuation;
             Ray scattered;
             if (!rec.material->scatter(current_ray, rec, attenuation, scattered)) {
                 break;
             }
+            if (bounce == 0 && aov) {
+                aov->albedo = attenuation.clamp(0.0, 1.0);
+            }
 
             if (rec.material->type() != MaterialType::Dielectric && rec.material->type() != MaterialType::Volumetric) {
-                Vec3SIMD direct_light = calculate_direct_lighting(bvh, lights, rec, rec.normal);
+                Vec3SIMD direct_light = calculate_direct_lighting(bvh, lights, rec, rec.normal,
+                    bounce == 0 && primary && primary->has_sun ? &primary->sun_transmittance : nullptr);
                 final_color += throughput * Vec3SIMD(attenuation) * direct_light;
+                if (bounce == 0 && aov) aov->direct = Vec3SIMD(attenuation) * direct_light;
+            }
+
+            if (radiance_caching && rec.material->is_pure_diffuse()) {
+                const Vec3 geometric = static_cast<Vec3>(original_normal);
+                const Vec3 facing = Vec3::dot(geometric, current_ray.direction) > 0.0 ? -geometric : geometric;
+                Vec3 cached;
+                // lk difz sekmeden sonra nbellekte yeterli kayt varsa dolayl k oradan alnr ve yol biter.
+                // Kamerann dorudan grd yzey hi nbellekten okunmaz, bulanklk sadece dolayl kta kalr
+                if (bounce > 0 && diffuse_bounce && radiance_cache.lookup(rec.point, facing, cached)) {
+                    RAY_STAT_INC(cache_hits);
+                    final_color += throughput * Vec3SIMD(cached);
+                    break;
+                }
+                if (cache_vertex_count < kMaxCacheVertices) {
+                    cache_vertices[cache_vertex_count++] = { rec.point, facing, final_color, throughput };
+                }
+                diffuse_bounce = true;
+            }
+
+            // Difz kelerde sekme yn yol rehberi ile BSDF arasndan seilir
+            const bool guided_vertex = path_guiding && rec.material->is_pure_diffuse();
+            float bounce_pdf = 0.0f;
+            if (guided_vertex) {
+                attenuation = guided_bounce(current_ray, rec, static_cast<Vec3>(original_normal), attenuation, scattered, bounce_pdf);
             }
 
             // Normal'i orijinal haline geri dndr (gerekirse)
@@ -489,17 +663,220 @@ Vec3SIMD Renderer::ray_color(const Ray& r, const ParallelBVHNode* bvh, const std
 
             float p = std::max(0.1f, std::min(0.95f, throughput.max_component()));
             if (random_double() >= p) {
+                RAY_STAT_INC(rr_terminations);
                 break;
             }
             throughput /= p;
-            current_ray = scattered;
+            if (guided_vertex && guide_training && guide_vertex_count < kMaxGuideVertices && bounce_pdf > 0.0f) {
+                guide_vertices[guide_vertex_count++] = { rec.point, scattered.direction, final_color, throughput, bounce_pdf,
+                    static_cast<float>(std::fabs(Vec3::dot(rec.normal, scattered.direction))) };
+            }
+            // Sekme n yzeyin kt tarafna, konumun yuvarlama hatas kadar itilir (bkz. RayOffset.h)
+            current_ray = Ray(offset_ray_origin(scattered.origin, geometric_normal(rec), scattered.direction), scattered.direction);
         }
     }
 
+    // Yol bittikten sonra her kaydedilen keye, sekme ynnden gelen k (sonraki katklar / o andaki throughput) yazlr.
+    // Kosinsle arplr: difz yzeyde rehber bylece integrandn tamamn (Li * cos) renir
+    for (int i = 0; i < guide_vertex_count; ++i) {
+        const GuideVertex& v = guide_vertices[i];
+        const float throughput_luminance = Film::luminanceOf(Vec3(v.throughput));
+        const float radiance = throughput_luminance > 0.0f ? Film::luminanceOf(Vec3(final_color - v.color)) / throughput_luminance : 0.0f;
+        path_guide.record(v.point, v.direction, radiance * v.cosine / v.pdf);
+    }
+    // Her difz keden kan dolayl k: sonraki katklar / keye gelen throughput (bileen bileen)
+    for (int i = 0; i < cache_vertex_count; ++i) {
+        const CacheVertex& v = cache_vertices[i];
+        const Vec3 gathered(final_color - v.color);
+        const Vec3 weight(v.throughput);
+        if (!(weight.x > 0.0) || !(weight.y > 0.0) || !(weight.z > 0.0)) continue;
+        radiance_cache.record(v.point, v.normal, Vec3(gathered.x / weight.x, gathered.y / weight.y, gathered.z / weight.z));
+    }
+
+    if (aov) {
+        // Iskalayan kamera n (depth 0): arka plan emission saylr. Geri kalan her ey dolayl k
+        if (aov->depth == 0.0f) aov->emission = final_color;
+        aov->indirect = Vec3(final_color) - aov->direct - aov->emission;
+    }
     return final_color;
 }
+// Rehberli keler normal haritasz saf difz yzeylerdir (is_pure_diffuse): BSDF, normal etrafnda kosins
+// lobu ve attenuation = f * cos / pdf_cos. Yn (1 - bsdf_fraction olaslkla) rehberden ya da ayn normal etrafnda
+// kosins rneklemesiyle seilir, arlk karm pdf'ine gre dzeltilir: tek rnekli MIS. Malzemenin kendi
+// rnei kullanlmaz, bylece iki dal da ayn normale ve ayn younlua gre hesaplanr.
+Vec3 Renderer::guided_bounce(const Ray& r_in, const HitRecord& rec, const Vec3& normal, const Vec3& attenuation, Ray& scattered, float& pdf) {
+    const Vec3 n = Vec3::dot(normal, r_in.direction) > 0.0 ? -normal : normal;
+    const int leaf = path_guide.isReady() ? path_guide.lookup(rec.point) : -1;
+    // Bu blgede henz veri yoksa sadece BSDF
+    const float guide_fraction = leaf < 0 ? 0.0f : 1.0f - path_guide.bsdfFraction();
+    if (guide_fraction > 0.0f && random_double() < guide_fraction) {
+        float sample_pdf;
+        Vec3 direction = path_guide.sample(leaf, random_double(), random_double(), random_double(), sample_pdf);
+        // Yzeyin altna den rnek yanstlr; hcrede farkl ynl yzeyler olsa da rnek boa gitmez
+        const double below = Vec3::dot(direction, n);
+        if (below < 0.0) direction = direction - n * (2.0 * below);
+        scattered = Ray(scattered.origin, direction);
+    }
+    else {
+        Vec3 T, B;
+        create_coordinate_system(n, T, B);
+        const double r1 = random_double(), r2 = random_double();
+        float sin_phi, cos_phi;
+        fastmath::sincos(static_cast<float>(2.0 * M_PI * r1), sin_phi, cos_phi);
+        const double radius = std::sqrt(r2);
+        scattered = Ray(scattered.origin, T * (radius * cos_phi) + B * (radius * sin_phi) + n * std::sqrt(1.0 - r2));
+    }
+    const double cos_theta = Vec3::dot(n, scattered.direction);
+    if (cos_theta <= 0.0) {
+        pdf = 0.0f;
+        return Vec3(0.0, 0.0, 0.0);
+    }
+    const float bsdf_pdf = static_cast<float>(cos_theta / M_PI);
+    if (leaf < 0) {
+        pdf = bsdf_pdf;
+        return attenuation;
+    }
+    // Katlanm rehber younluu: ynn kendisi ve aynadaki ei
+    const Vec3 mirrored = scattered.direction - n * (2.0 * cos_theta);
+    const float guide_pdf = path_guide.pdf(leaf, scattered.direction) + path_guide.pdf(leaf, mirrored);
+    pdf = guide_fraction * guide_pdf + (1.0f - guide_fraction) * bsdf_pdf;
+    return attenuation * (bsdf_pdf / pdf);
+}
+
+// Yerleim nizlemeleri: sadece ilk vuru (one_bounce hari), ayn BVH ve kamera ile
+Vec3SIMD Renderer::preview_color(const Ray& r, const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const Vec3SIMD& background_color, AovSample* aov) {
+    if (integrator.type == IntegratorType::OneBounce) {
+        // Kamera vuruu + bir sekme
+        return ray_color(r, bvh, lights, background_color, 2, aov);
+    }
+    RAY_STAT_INC(paths);
+    RAY_STAT_INC(primary_rays);
+    HitRecord rec;
+    bool hit;
+    {
+        PROFILE_HOT_SCOPE("intersect");
+        hit = bvh->hit(r, kSpawnTMin, std::numeric_limits<float>::infinity(), rec);
+    }
+    if (!hit) {
+        Vec3SIMD miss(0, 0, 0);
+        if (integrator.type == IntegratorType::AmbientOcclusion) {
+            miss = Vec3SIMD(1, 1, 1); // gkyz tamamen ak
+        }
+        else if (integrator.type == IntegratorType::Direct) {
+            if (background_texture) {
+                float u = 0.5f + fastmath::atan2(static_cast<float>(r.direction.z), static_cast<float>(r.direction.x)) / (2 * M_PI);
+                float v = 0.5f - fastmath::asin(static_cast<float>(r.direction.y)) / M_PI;
+                miss = background_texture->get_color(u, v);
+            }
+            else {
+                miss = background_color;
+            }
+        }
+        if (aov) {
+            aov->emission = miss;
+        }
+        return miss;
+    }
+    RAY_STAT_INC(path_segments);
+    rec.normal = static_cast<Vec3>(apply_normal_map(rec));
+    if (aov) {
+        aov->normal = rec.normal;
+        aov->depth = static_cast<float>(rec.t);
+        aov->material_id = rec.material->material_id;
+        aov->object_id = rec.object_id;
+    }
+
+    Vec3SIMD color(0, 0, 0);
+    switch (integrator.type) {
+    case IntegratorType::Normal:
+        color = Vec3SIMD(rec.normal * 0.5 + Vec3(0.5, 0.5, 0.5));
+        break;
+    case IntegratorType::Uv:
+        color = Vec3SIMD(static_cast<float>(rec.u - std::floor(rec.u)), static_cast<float>(rec.v - std::floor(rec.v)), 0.0f);
+        break;
+    case IntegratorType::Material: {
+        uint8_t cr, cg, cb;
+        Aov::idColor(rec.material->material_id, cr, cg, cb);
+        color = Vec3SIMD(cr / 255.0f, cg / 255.0f, cb / 255.0f);
+        break;
+    }
+    case IntegratorType::AmbientOcclusion: {
+        // Kosins arlkl yarm kre rnekleri; ao_distance iinde bir eye arpan n kapal saylr
+        Vec3 T, B;
+        create_coordinate_system(rec.normal, T, B);
+        const int samples = std::max(integrator.ao_samples, 0);
+        thread_local std::vector<Vec3> directions;
+        thread_local std::vector<HitRecord> occluders;
+        thread_local std::vector<uint8_t> occluded;
+        directions.resize(samples);
+        occluders.resize(samples);
+        occluded.resize(samples);
+        // Ynler sekizer sekizer tek hassasiyette retilir; rastgele saylar rnek srasyla ekilir
+        const Vec3x8 tangent(T), bitangent(B), normal(rec.normal);
+        for (int base = 0; base < samples; base += 8) {
+            const int lanes = std::min(8, samples - base);
+            alignas(32) float u1[8] = {}, u2[8] = {};
+            for (int i = 0; i < lanes; ++i) {
+                u1[i] = static_cast<float>(random_double());
+                u2[i] = static_cast<float>(random_double());
+            }
+            const Vec3x8 local = sampleCosineHemisphere(Floatx8::load(u1), Floatx8::load(u2));
+            const Vec3x8 world = fromLocal(local, tangent, bitangent, normal);
+            for (int i = 0; i < lanes; ++i) directions[base + i] = world.lane(i);
+        }
+        {
+            PROFILE_HOT_SCOPE("shadow");
+            RAY_STAT_ADD(shadow_rays, samples);
+            if (interleaved_traversal) {
+                // rnek nlar birbirinden bamsz: hepsi birlikte, i ie izlenir
+                intersect_interleaved(bvh, samples, [&](size_t i) { return spawn_ray(rec, directions[i]); },
+                    [&](size_t) { return integrator.ao_distance; }, occluders.data(), occluded.data());
+            }
+            else {
+                for (int i = 0; i < samples; ++i) {
+                    occluders[i] = HitRecord();
+                    occluded[i] = bvh->hit(spawn_ray(rec, directions[i]), kSpawnTMin, integrator.ao_distance, occluders[i]) ? 1 : 0;
+                }
+            }
+        }
+        int open = 0;
+        for (int i = 0; i < samples; ++i) {
+            if (!occluded[i]) ++open;
+        }
+        const float visibility = static_cast<float>(open) / std::max(integrator.ao_samples, 1);
+        color = Vec3SIMD(visibility, visibility, visibility);
+        break;
+    }
+    case IntegratorType::Direct:
+    default: {
+        const Vec3SIMD emitted = Vec3SIMD(rec.material->emitted(rec.u, rec.v, rec.point));
+        color = emitted;
+        if (aov) aov->emission = emitted;
+        Vec3 attenuation;
+        Ray scattered;
+        PROFILE_HOT_SCOPE("shade");
+        if (rec.material->scatter(r, rec, attenuation, scattered)) {
+            if (aov) aov->albedo = attenuation.clamp(0.0, 1.0);
+            // Yol izleyici gibi: dielektrikler dorudan k almaz
+            if (rec.material->type() != MaterialType::Dielectric && rec.material->type() != MaterialType::Volumetric) {
+                const Vec3SIMD direct = Vec3SIMD(attenuation) * calculate_direct_lighting(bvh, lights, rec, rec.normal);
+                color += direct;
+                if (aov) aov->direct = direct;
+            }
+        }
+        break;
+    }
+    }
+    if (aov && integrator.type != IntegratorType::Direct) {
+        aov->direct = Vec3(color);
+        // Hata ayklama grnmleri grltsz: deeri albedo olarak yazmak denoiser'n onlar bulanklatrmasn nler
+        if (integrator.type != IntegratorType::AmbientOcclusion) aov->albedo = Vec3(color);
+    }
+    return color;
+}
+
 Vec3SIMD fresnelSchlick(float cosTheta, const Vec3SIMD& F0) {
-    return F0 + (Vec3SIMD(1.0f) - F0) * pow(1.0f - cosTheta, 5.0f);
+    return F0 + (Vec3SIMD(1.0f) - F0) * fastmath::pow5(1.0f - cosTheta);
 }
 
 Vec3SIMD Renderer::calculate_light_contribution(const std::shared_ptr<Light>& light, const Vec3SIMD& point, const Vec3SIMD& geometric_normal, const Vec3SIMD& shading_normal, const Vec3SIMD& view_direction, float shininess,float metallic, bool is_global) {
@@ -586,12 +963,13 @@ Vec3SIMD Renderer::calculate_light_contribution(const std::shared_ptr<Light>& li
     return (Vec3SIMD(intensity) * cos_theta) + specular;
 }
 
-Vec3SIMD Renderer::calculate_direct_lighting(const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const HitRecord& rec, const Vec3SIMD& normal) {
-    Vec3SIMD direct_light(0, 0, 0);
+// Her k rnei iin visit(a yn, uzaklk, glgesiz katk) arlr; glge testi arana kalr.
+// Yol izleyici hemen test eder, wavefront entegratr glge nlarn kuyrua yazar
+template <typename Visit>
+void Renderer::for_each_light_sample(const std::vector<std::shared_ptr<Light>>& lights, const HitRecord& rec, const Vec3SIMD& normal, Visit&& visit) {
     const Vec3SIMD& hit_point = rec.point;
     const Vec3SIMD& hit_normal = normal;  // Use the provided normal instead of rec.normal
     Vec3SIMD shading_normal = apply_normal_map(rec);
-    HitRecord shadow_rec;  // Create a single HitRecord object and reuse it
     Vec3SIMD view_direction = (camera_position - hit_point).normalize();
     
     float shininess = rec.material->get_shininess();
@@ -616,35 +994,343 @@ Vec3SIMD Renderer::calculate_direct_lighting(const ParallelBVHNode* bvh, const s
             constexpr int num_samples = 16;
             const float area = area_light->getWidth() * area_light->getHeight();
             const float intensity_factor = area_light->getIntensity().length() / area;
-            Vec3SIMD area_light_contribution(0, 0, 0);
 
             for (int i = 0; i < num_samples; ++i) {
                 Vec3SIMD random_light_pos = Vec3SIMD(area_light->random_point());
                 Vec3SIMD to_light = random_light_pos - hit_point;
                 float light_distance = to_light.length();
                 to_light = to_light.normalize();
-                shadow_rec = HitRecord();  // Reset the HitRecord
-
-                if (!bvh->hit(Ray(hit_point, to_light), EPSILON, light_distance, shadow_rec)) {
-                    area_light_contribution += calculate_light_contribution(light, hit_point, hit_normal, shading_normal, view_direction, shininess, metallic)
-                        * (intensity_factor / num_samples);
-                }
+                visit(to_light, light_distance, calculate_light_contribution(light, hit_point, hit_normal, shading_normal, view_direction, shininess, metallic)
+                    * (intensity_factor / num_samples));
             }
-            direct_light += area_light_contribution;
             continue;  // Area light calculation is complete, skip the rest of the loop
         }
         else {
             continue;  // Unknown light type, move to the next light
         }
 
-        shadow_rec = HitRecord();  // Reset the HitRecord
-        if (!bvh->hit(Ray(hit_point, to_light), EPSILON, light_distance, shadow_rec)) {
-            direct_light += light_contribution;
-        }
+        visit(to_light, light_distance, light_contribution);
     }
+}
 
+Vec3SIMD Renderer::calculate_direct_lighting(const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const HitRecord& rec, const Vec3SIMD& normal,
+    const Vec3SIMD* sun_transmittance) {
+    Vec3SIMD direct_light(0, 0, 0);
+    for_each_light_sample(lights, rec, normal, [&](const Vec3SIMD& to_light, float light_distance, const Vec3SIMD& light_contribution) {
+        // Sonsuz uzaklktaki ilk rnek listedeki ilk ynl ktr
+        Vec3SIMD transmittance;
+        if (sun_transmittance && std::isinf(light_distance)) {
+            transmittance = *sun_transmittance;
+            sun_transmittance = nullptr;
+        }
+        else {
+            const Vec3 direction = static_cast<Vec3>(to_light);
+            transmittance = shadow_transmittance(bvh, offset_ray_origin(rec, direction), direction, light_distance);
+        }
+        if (transmittance.max_component() > 0.0f) {
+            direct_light += transmittance * light_contribution;
+        }
+    });
     return direct_light;
 }
 
+// Wavefront entegratr: ray_color ile ayn tahminci, ama yollar tek tek deil gruplar halinde ilerler.
+// Her sekmede tm canl nlar kesitirilir, isabetler malzemeye gre sralanp glgelendirilir,
+// dorudan n glge nlar kuyrua yazlp sekmenin sonunda topluca izlenir.
+// Yol rehberi, nm nbellei ve piksel maliyet haritas bu modda kullanlmaz
+void Renderer::render_rows_wavefront(int start_row, int end_row, const std::vector<std::shared_ptr<Light>>& lights, const Vec3SIMD& background_color,
+    const ParallelBVHNode* bvh, int samples_per_pass, const Camera& cam, ThreadLocalRNG& rng) {
+    // Bir gruptaki yol says snrl: kuyruklar i parac bana birka on MB' gemez
+    constexpr size_t kMaxBatchPaths = size_t(1) << 16;
+    const size_t paths_per_row = static_cast<size_t>(image_width) * samples_per_pass;
+    const int rows_per_batch = std::max(1, static_cast<int>(kMaxBatchPaths / std::max<size_t>(paths_per_row, 1)));
+    const bool want_aovs = film.aov_mask != 0;
+
+    // Kuyruklar i parac bana bir kez byr, sonraki paralarda yeniden kullanlr
+    thread_local PathStates paths;
+    thread_local RayQueue rays, next_rays;
+    thread_local ShadowQueue shadows;
+    thread_local std::vector<HitRecord> hits;
+    thread_local std::vector<uint8_t> hit_flags;
+    thread_local std::vector<uint64_t> shade_order;
+    thread_local std::vector<AovSample> aovs;
+    thread_local std::vector<Vec3SIMD> shadow_results;
+    thread_local std::vector<size_t> stream_entries;   // i ie izlenecek glge nlarnn kuyruktaki yeri
+    thread_local std::vector<HitRecord> stream_hits;
+    thread_local std::vector<uint8_t> stream_flags;
+
+    for (int batch_top = end_row; batch_top >= start_row; batch_top -= rows_per_batch) {
+        const int batch_bottom = std::max(start_row, batch_top - rows_per_batch + 1);
+        const size_t pixel_count = static_cast<size_t>(batch_top - batch_bottom + 1) * image_width;
+        const size_t path_count = pixel_count * samples_per_pass;
+
+        // 1) retim: kamera nlar render_chunk ile ayn srada; bir pikselin rnekleri art arda
+        {
+            PROFILE_SCOPE("wavefront_generate");
+            paths.reset(path_count);
+            rays.clear();
+            if (want_aovs) aovs.assign(path_count, AovSample());
+            uint32_t path = 0;
+            for (int j = batch_top; j >= batch_bottom; --j) {
+                for (int i = 0; i < image_width; ++i) {
+                    const uint32_t pixel = static_cast<uint32_t>((batch_top - j) * image_width + i);
+                    for (int s = 0; s < samples_per_pass; ++s, ++path) {
+                        auto u = (i + rng.get()) / (image_width - 1);
+                        auto v = (j + rng.get()) / (image_height - 1);
+                        const Ray r = cam.get_ray(u, v);
+                        paths.pixel[path] = pixel;
+                        rays.push(r.origin, r.direction, path);
+                        RAY_STAT_INC(paths);
+                    }
+                }
+            }
+        }
+
+        for (int bounce = 0; bounce < MAX_DEPTH && !rays.empty(); ++bounce) {
+            const size_t ray_count = rays.size();
+
+            // 2) Kesiim: sadece BVH, baka i yok
+            {
+                PROFILE_SCOPE("wavefront_intersect");
+                hits.resize(ray_count);
+                hit_flags.resize(ray_count);
+                if (bounce == 0 && ray_packets) {
+                    // Kamera nlar komu piksellerden gelir: paketlerle
+                    RAY_STAT_ADD(primary_rays, ray_count);
+                    intersect_packets(bvh, ray_count, [&](size_t k) { return rays.ray(k); }, hits.data(), hit_flags.data());
+                }
+                else if (interleaved_traversal) {
+                    // Sekme nlar dank: birka n i ie ilerler, dm beklemeleri rtr
+                    if (bounce == 0) RAY_STAT_ADD(primary_rays, ray_count);
+                    else RAY_STAT_ADD(bounce_rays, ray_count);
+                    intersect_interleaved(bvh, ray_count, [&](size_t k) { return rays.ray(k); },
+                        [](size_t) { return std::numeric_limits<float>::infinity(); }, hits.data(), hit_flags.data());
+                }
+                else {
+                    for (size_t k = 0; k < ray_count; ++k) {
+                        if (bounce == 0) RAY_STAT_INC(primary_rays);
+                        else RAY_STAT_INC(bounce_rays);
+                        hits[k] = HitRecord();
+                        hit_flags[k] = bvh->hit(rays.ray(k), kSpawnTMin, std::numeric_limits<float>::infinity(), hits[k]) ? 1 : 0;
+                    }
+                }
+            }
+
+            // 3) Iskalayanlar arka plan alr; isabetler nce malzeme trne, sonra malzeme id'sine gre sralanr
+            {
+                PROFILE_SCOPE("wavefront_sort");
+                shade_order.clear();
+                for (size_t k = 0; k < ray_count; ++k) {
+                    const uint32_t path = rays.path[k];
+                    if (!hit_flags[k]) {
+                        if (atmosphericEffects.enable && !background_texture) {
+                            paths.addColor(path, paths.throughput(path) * atmosphericEffects.applyAtmosphericEffects(background_color, paths.distance[path]));
+                        }
+                        else if (!atmosphericEffects.enable) {
+                            paths.addColor(path, paths.throughput(path) * background_color);
+                        }
+                        continue;
+                    }
+                    const Material* material = hits[k].material.get();
+                    shade_order.push_back((static_cast<uint64_t>(material->type()) << 56) |
+                        ((static_cast<uint64_t>(material->material_id + 1) & 0xFFFFFFu) << 32) | k);
+                }
+                std::sort(shade_order.begin(), shade_order.end());
+            }
+
+            // 4) Glgelendirme: ayn malzemenin isabetleri art arda; klar glge kuyruuna rneklenir
+            {
+                PROFILE_SCOPE("wavefront_shade");
+                next_rays.clear();
+                shadows.clear();
+                for (const uint64_t key : shade_order) {
+                    const size_t k = static_cast<size_t>(key & 0xFFFFFFFFu);
+                    const uint32_t path = rays.path[k];
+                    HitRecord& rec = hits[k];
+                    const Ray current_ray = rays.ray(k);
+                    AovSample* aov = want_aovs && bounce == 0 ? &aovs[path] : nullptr;
+                    Vec3SIMD throughput = paths.throughput(path);
+
+                    rec.normal = static_cast<Vec3>(apply_normal_map(rec));
+                    if (aov) {
+                        aov->normal = rec.normal;
+                        aov->depth = static_cast<float>(rec.t);
+                        aov->material_id = rec.material->material_id;
+                        aov->object_id = rec.object_id;
+                    }
+
+                    RAY_STAT_INC(path_segments);
+                    const float segment_start = paths.distance[path];
+                    const float segment_end = segment_start + static_cast<float>(rec.t);
+                    paths.distance[path] = segment_end;
+                    if (atmosphericEffects.enable) {
+                        throughput = atmosphericEffects.attenuateSegment(throughput, segment_start, segment_end);
+                        paths.addColor(path, throughput * atmosphericEffects.calculateSegmentContribution(segment_start, segment_end));
+                    }
+
+                    const Vec3SIMD emitted = Vec3SIMD(rec.material->emitted(rec.u, rec.v, rec.point));
+                    paths.addColor(path, throughput * emitted);
+                    if (aov) aov->emission = emitted;
+
+                    if (rec.material->type() == MaterialType::Volumetric) {
+                        // ray_color gibi: n deimeden sonraki sekmeye geer
+                        paths.setThroughput(path, throughput);
+                        next_rays.push(current_ray.origin, current_ray.direction, path);
+                        continue;
+                    }
+
+                    Vec3 attenuation;
+                    Ray scattered;
+                    if (!rec.material->scatter(current_ray, rec, attenuation, scattered)) {
+                        continue;
+                    }
+                    if (aov) aov->albedo = attenuation.clamp(0.0, 1.0);
+
+                    if (rec.material->type() != MaterialType::Dielectric) {
+                        const Vec3SIMD weight = throughput * Vec3SIMD(attenuation);
+                        for_each_light_sample(lights, rec, rec.normal, [&](const Vec3SIMD& to_light, float light_distance, const Vec3SIMD& light_contribution) {
+                            const Vec3 direction = static_cast<Vec3>(to_light);
+                            shadows.push(offset_ray_origin(rec, direction), direction, light_distance, weight * light_contribution, path, bounce == 0);
+                        });
+                    }
+
+                    throughput *= Vec3SIMD(attenuation);
+                    float p = std::max(0.1f, std::min(0.95f, throughput.max_component()));
+                    if (random_double() >= p) {
+                        RAY_STAT_INC(rr_terminations);
+                        continue;
+                    }
+                    throughput /= p;
+                    paths.setThroughput(path, throughput);
+                    next_rays.push(offset_ray_origin(scattered.origin, geometric_normal(rec), scattered.direction), scattered.direction, path);
+                }
+            }
+
+            // 5) Glge nlar: bu sekmenin btn dorudan k rnekleri topluca izlenir
+            {
+                PROFILE_SCOPE("wavefront_shadow");
+                shadow_results.resize(shadows.size());
+                stream_entries.clear();
+                for (size_t k = 0; k < shadows.size();) {
+                    if (ray_packets && std::isinf(shadows.distance[k])) {
+                        // Art arda ayn yndeki ynl k glge nlar tek pakette
+                        size_t end = k + 1;
+                        while (end < shadows.size() && end - k < RayPacket::kMaxRays && std::isinf(shadows.distance[end]) &&
+                            shadows.rays.dx[end] == shadows.rays.dx[k] && shadows.rays.dy[end] == shadows.rays.dy[k] && shadows.rays.dz[end] == shadows.rays.dz[k]) {
+                            ++end;
+                        }
+                        if (end - k > 1) {
+                            sun_shadow_packets(bvh, end - k, [&](size_t lane) { return shadows.rays.ray(k + lane).origin; },
+                                shadows.rays.ray(k).direction, shadow_results.data() + k);
+                            k = end;
+                            continue;
+                        }
+                    }
+                    if (interleaved_traversal) {
+                        stream_entries.push_back(k);
+                    }
+                    else {
+                        const Ray shadow_ray = shadows.rays.ray(k);
+                        shadow_results[k] = shadow_transmittance(bvh, shadow_ray.origin, shadow_ray.direction, shadows.distance[k]);
+                    }
+                    ++k;
+                }
+                if (!stream_entries.empty()) {
+                    // Kalan glge nlarnn ilk kesiimi i ie izlenir, sonu shadow_transmittance ile ayn
+                    const size_t stream_count = stream_entries.size();
+                    stream_hits.resize(stream_count);
+                    stream_flags.resize(stream_count);
+                    RAY_STAT_ADD(shadow_rays, stream_count);
+                    {
+                        PROFILE_HOT_SCOPE("shadow");
+                        intersect_interleaved(bvh, stream_count, [&](size_t e) { return shadows.rays.ray(stream_entries[e]); },
+                            [&](size_t e) { return shadows.distance[stream_entries[e]]; }, stream_hits.data(), stream_flags.data());
+                    }
+                    for (size_t e = 0; e < stream_count; ++e) {
+                        const size_t k = stream_entries[e];
+                        const Ray shadow_ray = shadows.rays.ray(k);
+                        shadow_results[k] = shadow_after_first_hit(bvh, stream_flags[e], stream_hits[e], shadow_ray.origin, shadow_ray.direction, shadows.distance[k]);
+                    }
+                }
+                for (size_t k = 0; k < shadows.size(); ++k) {
+                    const Vec3SIMD& transmittance = shadow_results[k];
+                    if (!(transmittance.max_component() > 0.0f)) continue;
+                    const Vec3SIMD light = transmittance * shadows.contribution(k);
+                    const uint32_t path = shadows.rays.path[k];
+                    paths.addColor(path, light);
+                    if (want_aovs && shadows.primary[k]) aovs[path].direct += Vec3(light);
+                }
+            }
+
+            rays.swap(next_rays);
+        }
+
+        // 6) rnekler piksellere toplanr; film alanlar render_chunk ile ayn
+        for (size_t pixel = 0; pixel < pixel_count; ++pixel) {
+            const int i = static_cast<int>(pixel % image_width);
+            const int j = batch_top - static_cast<int>(pixel / image_width);
+            const size_t pixel_index = film.index(i, image_height - 1 - j);
+            Vec3 new_color(0, 0, 0);
+            float luminance_sum = 0.0f, luminance_sq_sum = 0.0f;
+            for (int s = 0; s < samples_per_pass; ++s) {
+                const size_t path = pixel * samples_per_pass + s;
+                const Vec3 sample_color = paths.color(path);
+                new_color += sample_color;
+                const float luminance = Film::luminanceOf(sample_color);
+                luminance_sum += luminance;
+                luminance_sq_sum += luminance * luminance;
+                if (want_aovs) {
+                    AovSample& aov = aovs[path];
+                    if (aov.depth == 0.0f) aov.emission = sample_color;
+                    aov.indirect = sample_color - aov.direct - aov.emission;
+                    film.addAov(pixel_index, aov);
+                }
+            }
+            film.color[pixel_index] += new_color;
+            film.luminance[pixel_index] += luminance_sum;
+            film.luminance_sq[pixel_index] += luminance_sq_sum;
+        }
+    }
+}
+
+// Glge n camlarda durmaz: her dielektrik yzeyin geirgenlii arplp n devam eder.
+// Opak bir engel ya da kShadowSurfaces'ten fazla cam yzeyi  tamamen keser
+Vec3SIMD Renderer::shadow_transmittance(const ParallelBVHNode* bvh, const Vec3& origin, const Vec3& direction, float distance) {
+    constexpr int kShadowSurfaces = 8;
+    Vec3SIMD transmittance(1, 1, 1);
+    Vec3 ray_origin = origin;
+    Vec3 ray_direction = direction;
+    const Vec3 light_direction = ray_direction;
+    const bool thin = integrator.shadow_glass != ShadowGlass::Refract;
+    for (int surface = 0; surface <= kShadowSurfaces; ++surface) {
+        HitRecord shadow_rec;
+        bool occluded;
+        {
+            PROFILE_HOT_SCOPE("shadow");
+            RAY_STAT_INC(shadow_rays);
+            occluded = bvh->hit(Ray(ray_origin, ray_direction), kSpawnTMin, distance, shadow_rec);
+        }
+        if (!occluded) {
+            // Krlan n a ancak ayn ynde karsa ular (paralel cam yzeyler)
+            if (!thin && Vec3::dot(ray_direction.normalize(), light_direction.normalize()) < 0.9999) {
+                return Vec3SIMD(0, 0, 0);
+            }
+            return transmittance;
+        }
+        if (integrator.shadow_glass == ShadowGlass::Opaque || surface == kShadowSurfaces) {
+            return Vec3SIMD(0, 0, 0);
+        }
+        // Opak malzemeler 0 dndrr
+        transmittance *= Vec3SIMD(shadow_rec.material->shadow_transmittance(shadow_rec, ray_direction, thin));
+        if (!(transmittance.max_component() > 0.0f)) {
+            return Vec3SIMD(0, 0, 0);
+        }
+        // Geilen yzeyin arkasndan devam edilir
+        ray_origin = offset_ray_origin(shadow_rec, ray_direction);
+        distance -= static_cast<float>(shadow_rec.t);
+    }
+    return Vec3SIMD(0, 0, 0);
+}
+
 
 
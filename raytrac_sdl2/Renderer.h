@@ -33,8 +33,9 @@
 #include <chrono>
 #include <iostream>
 #include <iomanip>
+#include <functional>
 #include "HittableList.h"
-#include "light.h"
+#include "Light.h"
 #include "Vec3.h"
 #include "Camera.h"
 #include "globals.h"
@@ -42,7 +43,7 @@
 #include "DirectionalLight.h"
 #include "AreaLight.h"
 #include "Volumetric.h"
-#include "matrix4x4.h"
+#include "Matrix4x4.h"
 #include "DirectionalLight.h"
 #include "Lambertian.h"
 #include "Dielectric.h"
@@ -55,28 +56,43 @@
 #include "ThreadLocalRNG.h"
 #include "Vec2.h"
 #include "Vec3SIMD.h"
+#include "Vec3x8.h"
+#include "FastMath.h"
 #include "Mesh.h"
 #include "AABB.h"
 #include "Ray.h"
+#include "RayOffset.h"
 #include "Hittable.h"
 #include "EmissiveMaterial.h"
 #include "DiffuseLight.h"
-#include "EnhancedObjLoader.h"
-#include "SSSMaterial.h"
 #include "ThreadLocalRNG.h"
 #include "ObjLoaderAdapter.h"
 #include "AtmosphericEffects.h"
 #include "ParallelBVHNode.h"
+#include "TextureManager.h"
+#include "ScenePipeline.h"
+#include "SceneLoader.h"
+#include "Profiler.h"
+#include "RayStats.h"
+#include "CostHeatmap.h"
+#include "Film.h"
+#include "Denoiser.h"
+#include "HdrImage.h"
+#include "DisplayTransform.h"
+#include "Integrator.h"
+#include "PathGuide.h"
+#include "RadianceCache.h"
+#include "Wavefront.h"
 
 class Renderer {
 public:
-    Renderer(int image_width, int image_height, int max_depth, int samples_per_pixel);;
+    Renderer(int image_width, int image_height, int max_depth);
     ~Renderer();
 
  
     //std::pair<HittableList, std::shared_ptr<BVHNode>> create_scene(std::vector<std::shared_ptr<Light>>& lights, Vec3& background_color);
-    std::pair<HittableList, std::shared_ptr<ParallelBVHNode>> create_scene(std::vector<std::shared_ptr<Light>>& lights, Vec3SIMD& background_color);
-    void render_chunk(int start_row, int end_row, SDL_Surface* surface, const HittableList& world, const std::vector<std::shared_ptr<Light>>& lights, const Vec3& background_color, const ParallelBVHNode* bvh, const int samples_per_pass, const int current_sample);
+    std::shared_ptr<ParallelBVHNode> create_scene(HittableList& world, std::vector<std::shared_ptr<Light>>& lights, Vec3SIMD& background_color);
+    void render_chunk(int start_row, int end_row, const std::vector<std::shared_ptr<Light>>& lights, const Vec3& background_color, const ParallelBVHNode* bvh, const int samples_per_pass, const int current_sample);
     void progressive_render(SDL_Surface* surface, const Vec3& background_color);
     void set_window(SDL_Window* win);
 
@@ -86,7 +102,81 @@ public:
     void set_camera_position(const Vec3SIMD& position) {
         camera_position = position;
     }
+    // create_scene ve kamera bu sahne aklamasn kullanr
+    void set_scene(const SceneDescription& description) {
+        scene = description;
+        cost_metric = CostHeatmap::parseMetric(description.render.cost_heatmap);
+        denoise_final = description.render.denoise;
+        denoise_progressive = description.render.denoise_progressive;
+        requested_aovs = Aov::parseList(description.render.aovs);
+        display.tonemap = DisplayTransform::parse(description.render.tonemap);
+        display.exposure = static_cast<float>(description.render.exposure);
+        integrator.type = Integrator::parse(description.render.integrator);
+        integrator.ao_distance = description.render.ao_distance;
+        integrator.ao_samples = description.render.ao_samples;
+        integrator.shadow_glass = Integrator::parseShadowGlass(description.render.shadow_glass);
+        ray_packets = description.render.ray_packets;
+        interleaved_traversal = description.render.interleaved_traversal;
+        path_guiding = description.render.path_guiding;
+        guide_settings.training_passes = description.render.guiding_training_passes;
+        guide_settings.bsdf_fraction = static_cast<float>(description.render.guiding_bsdf_fraction);
+        radiance_caching = description.render.radiance_cache;
+        cache_settings.cell_size = description.render.radiance_cache_cell;
+    }
+    // Piksel bana maliyet (sre s veya BVH dm + primitive testi), st satr ilk srada
+    const std::vector<float>& cost_map() const { return cost_buffer; }
+    bool save_cost_heatmap(const std::string& filename) const {
+        return CostHeatmap::write(cost_buffer, image_width, image_height, filename);
+    }
+    bool has_cost_heatmap() const { return cost_metric != CostMetric::None; }
+
+    // Sahne dosyas yerine kodla kurulan sahneler iin (benchmark sahneleri)
+    using SceneBuilder = std::function<std::shared_ptr<ParallelBVHNode>(HittableList& world,
+        std::vector<std::shared_ptr<Light>>& lights, AtmosphericEffects& atmosphere, Vec3SIMD& background_color)>;
+    void set_scene_builder(SceneBuilder builder) { scene_builder = std::move(builder); }
+
+    // Her geiten sonra arlr: gei no, toplam rnek, geilerde + denoise'da geen sre (s), yzey
+    using PassCallback = std::function<void(int pass, int samples, double seconds, const SDL_Surface* surface)>;
+    void set_pass_callback(PassCallback callback) { pass_callback = std::move(callback); }
+
+    // Son render_image arsnn n sayalar ve sadece geilerde geen sre
+    const RayCounters& ray_stats() const { return last_ray_counters; }
+    double trace_seconds() const { return last_trace_seconds; }
+
+    // Dorusal birikim filmi (grltl, denoise edilmemi toplamlar)
+    const Film& get_film() const { return film; }
+    // Son render'da renilen yol rehberi ve k nbellei (path_guiding / radiance_cache kapalysa bo)
+    const PathGuide& get_path_guide() const { return path_guide; }
+    const RadianceCache& get_radiance_cache() const { return radiance_cache; }
+    // stenen AOV'lar <output>_<aov>.png nizlemeleri olarak yazar
+    bool save_aovs(const std::string& output) const;
+    AovMask aovs() const { return requested_aovs; }
+    // Filmin ortalamasn krpmadan .exr/.pfm olarak yazar; EXR'a denoise sonucu ve AOV'lar katman olarak eklenir
+    bool save_hdr(const std::string& filename, bool half = false) const;
 private:
+    Film film;
+    AovMask requested_aovs = 0;
+    bool denoise_final = false;       // son geiten sonra denoise
+    bool denoise_progressive = false; // her geite ekranda denoise edilmi nizleme
+    std::vector<Vec3> denoised;
+    DisplaySettings display;          // film -> 8-bit yzey dnm (tonemap, pozlama)
+    IntegratorSettings integrator;    // path veya hzl nizleme (ao, direct, one_bounce, normal, uv, material)
+    bool path_guiding = false;        // difz sekmeler renilen gelen k dalmyla kartrlr
+    PathGuide::Settings guide_settings;
+    PathGuide path_guide;
+    bool guide_training = false;      // bu gei rehber iin kayt topluyor mu
+    bool radiance_caching = false;    // difz dolayl k dnya uzayndaki nbellekte birikir, isabetlerde yol biter
+    RadianceCache::Settings cache_settings;
+    RadianceCache radiance_cache;
+    Vec3 guided_bounce(const Ray& r_in, const HitRecord& rec, const Vec3& normal, const Vec3& attenuation, Ray& scattered, float& pdf);
+    void denoise_to_surface(SDL_Surface* surface);
+    SceneBuilder scene_builder;
+    PassCallback pass_callback;
+    RayCounters last_ray_counters;
+    double last_trace_seconds = 0.0;
+    CostMetric cost_metric = CostMetric::None;
+    std::vector<float> cost_buffer;
+    SceneDescription scene;
     Vec3SIMD camera_position;
     AtmosphericEffects atmosphericEffects;
     SDL_Renderer* sdlRenderer; // SDL_Renderer pointer' ekleyin
@@ -95,14 +185,46 @@ private:
     Vec3SIMD sample_point_light(const ParallelBVHNode* bvh, const PointLight* light, const HitRecord& rec, const Vec3SIMD& light_contribution);
     Vec3SIMD sample_area_light(const ParallelBVHNode* bvh, const AreaLight* light, const HitRecord& rec, const Vec3SIMD& light_contribution, int num_samples);
     
-    void render_worker(int image_height, SDL_Surface* surface, const HittableList& world, const std::vector<std::shared_ptr<Light>>& lights, const Vec3& background_color, const ParallelBVHNode* bvh, const int samples_per_pass, const int current_sample);
+    // Wavefront entegratr: satrlar yol gruplar halinde, aama aama ilenir (ret, kesitir, srala, glgelendir, glge)
+    void render_rows_wavefront(int start_row, int end_row, const std::vector<std::shared_ptr<Light>>& lights, const Vec3SIMD& background_color,
+        const ParallelBVHNode* bvh, int samples_per_pass, const Camera& cam, ThreadLocalRNG& rng);
+    template <typename Visit>
+    void for_each_light_sample(const std::vector<std::shared_ptr<Light>>& lights, const HitRecord& rec, const Vec3SIMD& normal, Visit&& visit);
+    void render_worker(int image_height, const std::vector<std::shared_ptr<Light>>& lights, const Vec3& background_color, const ParallelBVHNode* bvh, const int samples_per_pass, const int current_sample);
     
     void update_display(SDL_Window* window, SDL_Surface* surface);
     Vec3SIMD apply_normal_map(const HitRecord& rec);
     void create_coordinate_system(const Vec3& N, Vec3& T, Vec3& B);
-    Vec3SIMD ray_color(const Ray& r, const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const Vec3SIMD& background_color, int depth=0);
+    // Paketle nceden bulunmu kamera vuruu ve (ilk ynl k varsa) o noktadan gnee geirgenlik
+    struct PrimaryHit {
+        bool hit = false;
+        HitRecord rec;
+        bool has_sun = false;
+        Vec3SIMD sun_transmittance;
+    };
+    bool ray_packets = true;          // kamera nlar ve ynl k glge nlar 16'lk paketlerle izlenir
+    // ray_at(k) ile verilen ardk nlar 16'lk paketlerle kesitirilir (n sayalarn aran artrr)
+    template <typename RayAt>
+    void intersect_packets(const ParallelBVHNode* bvh, size_t count, RayAt&& ray_at, HitRecord* records, uint8_t* hit_flags);
+    // Ayn yndeki glge nlar (ynl k) paketlerle; sonu shadow_transmittance ile ayndr
+    template <typename OriginAt>
+    void sun_shadow_packets(const ParallelBVHNode* bvh, size_t count, OriginAt&& origin_at, const Vec3& direction, Vec3SIMD* transmittance);
+    bool interleaved_traversal = false; // birbirinden bamsz nlar (sekmeler, glge ve AO nlar) i ie, nbellek n yklemeli izlenir
+    // ray_at(k) n (kSpawnTMin, t_max_at(k)] aralnda; hit_interleaved ile birka n ayn anda ilerler
+    template <typename RayAt, typename TMaxAt>
+    void intersect_interleaved(const ParallelBVHNode* bvh, size_t count, RayAt&& ray_at, TMaxAt&& t_max_at, HitRecord* records, uint8_t* hit_flags);
+    // lk glge kesiiminden geirgenlik: boluk 1, opak engel 0; cama arpan n shadow_transmittance ile batan izlenir
+    Vec3SIMD shadow_after_first_hit(const ParallelBVHNode* bvh, bool occluded, const HitRecord& rec, const Vec3& origin, const Vec3& direction, float distance);
+    // depth: en fazla sekme says (kamera vuruu dahil); primary verilirse ilk kesiim yaplmaz
+    Vec3SIMD ray_color(const Ray& r, const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const Vec3SIMD& background_color, int depth, AovSample* aov = nullptr,
+        const PrimaryHit* primary = nullptr);
+    Vec3SIMD preview_color(const Ray& r, const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const Vec3SIMD& background_color, AovSample* aov = nullptr);
     Vec3SIMD calculate_light_contribution(const std::shared_ptr<Light>& light, const Vec3SIMD& point, const Vec3SIMD& geometric_normal, const Vec3SIMD& shading_normal, const Vec3SIMD& view_direction, float shininess, float metallic, bool is_global=false);
-    Vec3SIMD calculate_direct_lighting(const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const HitRecord& rec, const Vec3SIMD& normal);
+    // Ia kadar kalan geirgenlik: opak engelde 0, camlardan geerken renk tonu ve Fresnel kayb birikir
+    Vec3SIMD shadow_transmittance(const ParallelBVHNode* bvh, const Vec3& origin, const Vec3& direction, float distance);
+    // sun_transmittance verilirse ilk ynl k iin glge n atlmaz, bu deer kullanlr
+    Vec3SIMD calculate_direct_lighting(const ParallelBVHNode* bvh, const std::vector<std::shared_ptr<Light>>& lights, const HitRecord& rec, const Vec3SIMD& normal,
+        const Vec3SIMD* sun_transmittance = nullptr);
     int image_width;
     int image_height;
     double aspect_ratio;
@@ -0,0 +1,375 @@
+#include "SceneLoader.h"
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include "Aov.h"
+#include "AreaLight.h"
+#include "Dielectric.h"
+#include "DirectionalLight.h"
+#include "DisplayTransform.h"
+#include "HdrImage.h"
+#include "Integrator.h"
+#include "Lambertian.h"
+#include "Metal.h"
+#include "PointLight.h"
+#include "Profiler.h"
+#include "ScenePipeline.h"
+
+namespace {
+    Vec3 readVec3(const JsonValue& value, const Vec3& fallback) {
+        if (value.isNumber()) {
+            const double v = value.asNumber();
+            return Vec3(v, v, v);
+        }
+        if (!value.isArray() || value.size() != 3) return fallback;
+        return Vec3(value[0].asNumber(fallback.x), value[1].asNumber(fallback.y), value[2].asNumber(fallback.z));
+    }
+
+    Vec2 readVec2(const JsonValue& value, const Vec2& fallback) {
+        if (!value.isArray() || value.size() != 2) return fallback;
+        return Vec2(value[0].asNumber(fallback.u), value[1].asNumber(fallback.v));
+    }
+
+    // Properties that are either a plain number or an object carrying "amount" plus extra parameters
+    double readAmount(const JsonValue& value, double fallback) {
+        return value.isObject() ? value["amount"].asNumber(fallback) : value.asNumber(fallback);
+    }
+
+    WrapMode readWrapMode(const std::string& name) {
+        if (name == "mirror") return WrapMode::Mirror;
+        if (name == "clamp") return WrapMode::Clamp;
+        if (name == "planar") return WrapMode::Planar;
+        if (name == "cubic") return WrapMode::Cubic;
+        return WrapMode::Repeat;
+    }
+
+    Lambertian::TextureTransform readTextureTransform(const JsonValue& value) {
+        return Lambertian::TextureTransform(
+            readVec2(value["scale"], Vec2(1.0, 1.0)),
+            value["rotation"].asNumber(0.0),
+            readVec2(value["translation"], Vec2(0.0, 0.0)),
+            readVec2(value["tiling"], Vec2(1.0, 1.0)),
+            readWrapMode(value["wrap"].asString("repeat")));
+    }
+
+    std::string resolvePath(const SceneDescription& scene, const std::string& path) {
+        std::filesystem::path p(path);
+        if (p.is_absolute() || scene.asset_root.empty()) return p.lexically_normal().generic_string();
+        return (std::filesystem::path(scene.asset_root) / p).lexically_normal().generic_string();
+    }
+
+    using TextureHandles = std::map<std::string, ScenePipeline::TextureHandle>;
+
+    // Texture references are names from the "textures" block or plain file paths
+    ScenePipeline::TextureHandle textureFor(const JsonValue& reference, const SceneDescription& scene,
+        ScenePipeline& pipeline, TextureHandles& handles) {
+        const std::string name = reference.asString();
+        auto it = handles.find(name);
+        if (it != handles.end()) return it->second;
+        return handles.emplace(name, pipeline.loadTexture(resolvePath(scene, name))).first->second;
+    }
+
+    template <typename MaterialType>
+    void applyCommonLayers(MaterialType& material, const JsonValue& desc) {
+        if (desc.has("specular")) {
+            const JsonValue& s = desc["specular"];
+            material.setSpecular(readVec3(s["color"], Vec3(1, 1, 1)), static_cast<float>(s["intensity"].asNumber(1.0)));
+        }
+        if (desc.has("emission")) {
+            const JsonValue& e = desc["emission"];
+            material.setEmission(readVec3(e["color"], Vec3(0, 0, 0)), static_cast<float>(e["intensity"].asNumber(1.0)));
+        }
+        if (desc.has("anisotropic")) {
+            const JsonValue& a = desc["anisotropic"];
+            material.setAnisotropic(static_cast<float>(readAmount(a, 0.0)), readVec3(a["direction"], Vec3(1, 0, 0)));
+        }
+    }
+
+    std::shared_ptr<Material> createLambertian(const JsonValue& desc, const std::map<std::string, std::shared_ptr<Texture>>& textures) {
+        auto texture = [&](const char* key) -> std::shared_ptr<Texture> {
+            auto it = textures.find(key);
+            return it != textures.end() ? it->second : nullptr;
+        };
+        const float roughness = static_cast<float>(desc["roughness"].asNumber(0.5));
+        const float metallic = static_cast<float>(readAmount(desc["metallic"], 0.0));
+        const Lambertian::TextureTransform transform = readTextureTransform(desc["texture_transform"]);
+
+        std::shared_ptr<Lambertian> material;
+        auto albedo = texture("albedo_texture");
+        auto normal = texture("normal_texture");
+        auto rough = texture("roughness_texture");
+        if (albedo && rough) {
+            material = normal ? std::make_shared<Lambertian>(albedo, rough, metallic, normal, transform)
+                : std::make_shared<Lambertian>(albedo, rough, metallic);
+        }
+        else if (albedo) {
+            material = normal ? std::make_shared<Lambertian>(albedo, roughness, metallic, normal, transform)
+                : std::make_shared<Lambertian>(albedo, roughness, metallic, transform);
+        }
+        else {
+            material = std::make_shared<Lambertian>(readVec3(desc["albedo"], Vec3(0.8, 0.8, 0.8)), roughness, metallic);
+        }
+
+        applyCommonLayers(*material, desc);
+        if (desc["metallic"].isObject()) {
+            material->setMetallic(metallic, static_cast<float>(desc["metallic"]["intensity"].asNumber(1.0)));
+        }
+        if (desc.has("clearcoat")) {
+            const JsonValue& c = desc["clearcoat"];
+            material->setClearcoat(static_cast<float>(readAmount(c, 0.0)), static_cast<float>(c["roughness"].asNumber(0.1)));
+        }
+        if (desc.has("subsurface")) {
+            const JsonValue& s = desc["subsurface"];
+            material->setSubsurfaceScattering(readVec3(s["color"], Vec3(1, 1, 1)), static_cast<float>(s["radius"].asNumber(0.1)));
+        }
+        if (albedo && desc.has("texture_transform")) {
+            material->setTextureTransform(transform);
+        }
+        return material;
+    }
+
+    std::shared_ptr<Material> createMetal(const JsonValue& desc, const std::map<std::string, std::shared_ptr<Texture>>& textures) {
+        const float roughness = static_cast<float>(desc["roughness"].asNumber(0.2));
+        const float metallic = static_cast<float>(readAmount(desc["metallic"], 1.0));
+        const float fuzz = static_cast<float>(desc["fuzz"].asNumber(0.0));
+        const float clearcoat = static_cast<float>(readAmount(desc["clearcoat"], 0.0));
+
+        std::shared_ptr<Metal> material;
+        auto it = textures.find("albedo_texture");
+        if (it != textures.end() && it->second) {
+            material = std::make_shared<Metal>(it->second, roughness, metallic, fuzz, clearcoat);
+        }
+        else {
+            material = std::make_shared<Metal>(readVec3(desc["albedo"], Vec3(0.9, 0.9, 0.9)), roughness, metallic, fuzz, clearcoat);
+        }
+
+        applyCommonLayers(*material, desc);
+        if (desc["metallic"].isObject()) {
+            const JsonValue& m = desc["metallic"];
+            material->setMetallic(metallic, static_cast<float>(m["intensity"].asNumber(1.0)), readVec3(m["color"], Vec3(1, 1, 1)));
+        }
+        if (desc["clearcoat"].isObject()) {
+            const JsonValue& c = desc["clearcoat"];
+            material->setClearcoat(clearcoat, static_cast<float>(c["roughness"].asNumber(0.1)), readVec3(c["color"], Vec3(1, 1, 1)));
+        }
+        return material;
+    }
+
+    std::shared_ptr<Material> createDielectric(const JsonValue& desc) {
+        return std::make_shared<Dielectric>(
+            desc["ior"].asNumber(1.5),
+            readVec3(desc["color"], Vec3(0.95, 0.95, 1.0)),
+            desc["caustic_intensity"].asNumber(0.1),
+            desc["thickness"].asNumber(0.006),
+            desc["tint"].asNumber(0.2),
+            desc["scratch_density"].asNumber(0.001));
+    }
+
+    std::shared_ptr<Light> createLight(const JsonValue& desc) {
+        const std::string type = desc["type"].asString();
+        const Vec3 intensity = readVec3(desc["intensity"], Vec3(1, 1, 1));
+        if (type == "directional") {
+            return std::make_shared<DirectionalLight>(readVec3(desc["direction"], Vec3(0, -1, 0)), intensity);
+        }
+        if (type == "point") {
+            return std::make_shared<PointLight>(readVec3(desc["position"], Vec3(0, 5, 0)), intensity,
+                static_cast<float>(desc["radius"].asNumber(0.0)));
+        }
+        if (type == "area") {
+            return std::make_shared<AreaLight>(readVec3(desc["position"], Vec3(0, 5, 0)),
+                readVec3(desc["u"], Vec3(1, 0, 0)), readVec3(desc["v"], Vec3(0, 0, 1)),
+                desc["width"].asNumber(1.0), desc["height"].asNumber(1.0), intensity);
+        }
+        throw std::runtime_error("Unknown light type: '" + type + "'");
+    }
+
+    void applyAtmosphere(const JsonValue& desc, const SceneDescription& scene, AtmosphericEffects& atmosphere, Vec3SIMD& background_color) {
+        background_color = Vec3SIMD(readVec3(desc["background_color"], Vec3(0.3, 0.4, 0.5)));
+        atmosphere.enable = desc["enable"].asBool(true);
+        atmosphere.setBackgroundColor(background_color);
+        if (desc.has("background_texture")) {
+            atmosphere.setBackgroundTexture(resolvePath(scene, desc["background_texture"].asString()));
+        }
+        else {
+            atmosphere.use_background_texture = false;
+        }
+        atmosphere.setFogStartDistance(static_cast<float>(desc["fog_start"].asNumber(atmosphere.getFogStartDistance())));
+        atmosphere.setFogBaseDensity(static_cast<float>(desc["fog_density"].asNumber(atmosphere.getFogBaseDensity())));
+        atmosphere.setFogDistanceFactor(static_cast<float>(desc["fog_distance_factor"].asNumber(atmosphere.getFogDistanceFactor())));
+        atmosphere.setHazeDensity(static_cast<float>(desc["haze_density"].asNumber(atmosphere.getHazeDensity())));
+        if (desc.has("fog_color")) atmosphere.setFogColor(Vec3SIMD(readVec3(desc["fog_color"], atmosphere.getFogColor())));
+        if (desc.has("haze_color")) atmosphere.setHazeColor(Vec3SIMD(readVec3(desc["haze_color"], atmosphere.getHazeColor())));
+    }
+}
+
+SceneDescription SceneLoader::load(const std::string& filename) {
+    PROFILE_SCOPE_CAT("scene_parse", "scene");
+    SceneDescription scene;
+    scene.filename = filename;
+    scene.root = JsonValue::parseFile(filename);
+    if (!scene.root.isObject()) {
+        throw std::runtime_error(filename + ": scene file must contain a JSON object");
+    }
+
+    const JsonValue& root = scene.root;
+    std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    if (root.has("asset_root")) directory /= root["asset_root"].asString();
+    scene.asset_root = directory.lexically_normal().generic_string();
+
+    const JsonValue& render = root["render"];
+    RenderSettings& settings = scene.render;
+    settings.width = render["width"].asInt(settings.width);
+    settings.height = render["height"].asInt(settings.height);
+    settings.samples_per_pixel = render["samples_per_pixel"].asInt(settings.samples_per_pixel);
+    settings.samples_per_pass = render["samples_per_pass"].asInt(settings.samples_per_pass);
+    settings.max_depth = render["max_depth"].asInt(settings.max_depth);
+    settings.output = render["output"].asString(settings.output);
+    settings.cost_heatmap = render["cost_heatmap"].asString(settings.cost_heatmap);
+    settings.seed = static_cast<uint32_t>(render["seed"].asNumber(settings.seed));
+    settings.denoise = render["denoise"].asBool(settings.denoise);
+    settings.denoise_progressive = render["denoise_progressive"].asBool(settings.denoise_progressive);
+    if (render["aovs"].isArray()) {
+        settings.aovs.clear();
+        for (const JsonValue& aov : render["aovs"].items()) {
+            settings.aovs += (settings.aovs.empty() ? "" : ",") + aov.asString();
+        }
+    }
+    else {
+        settings.aovs = render["aovs"].asString(settings.aovs);
+    }
+    settings.hdr_output = render["hdr_output"].asString(settings.hdr_output);
+    settings.hdr_half = render["hdr_half"].asBool(settings.hdr_half);
+    if (!settings.hdr_output.empty() && !HdrImage::isHdrPath(settings.hdr_output)) {
+        throw std::runtime_error(filename + ": hdr_output must end in .exr or .pfm");
+    }
+    settings.tonemap = render["tonemap"].asString(settings.tonemap);
+    settings.exposure = render["exposure"].asNumber(settings.exposure);
+    settings.integrator = render["integrator"].asString(settings.integrator);
+    settings.ao_distance = render["ao_distance"].asNumber(settings.ao_distance);
+    settings.ao_samples = render["ao_samples"].asInt(settings.ao_samples);
+    settings.shadow_glass = render["shadow_glass"].asString(settings.shadow_glass);
+    settings.ray_packets = render["ray_packets"].asBool(settings.ray_packets);
+    settings.interleaved_traversal = render["interleaved_traversal"].asBool(settings.interleaved_traversal);
+    settings.path_guiding = render["path_guiding"].asBool(settings.path_guiding);
+    settings.guiding_training_passes = render["guiding_training_passes"].asInt(settings.guiding_training_passes);
+    settings.guiding_bsdf_fraction = render["guiding_bsdf_fraction"].asNumber(settings.guiding_bsdf_fraction);
+    settings.radiance_cache = render["radiance_cache"].asBool(settings.radiance_cache);
+    settings.radiance_cache_cell = render["radiance_cache_cell"].asNumber(settings.radiance_cache_cell);
+    settings.mesh_cache = render["mesh_cache"].asString(settings.mesh_cache);
+    try {
+        Aov::parseList(settings.aovs);
+        DisplayTransform::parse(settings.tonemap);
+        Integrator::parse(settings.integrator);
+        Integrator::parseShadowGlass(settings.shadow_glass);
+    }
+    catch (const std::exception& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+    if (settings.ao_distance <= 0.0 || settings.ao_samples <= 0) {
+        throw std::runtime_error(filename + ": ao_distance and ao_samples must be positive");
+    }
+    if (settings.guiding_training_passes < 0 || settings.guiding_bsdf_fraction <= 0.0 || settings.guiding_bsdf_fraction > 1.0) {
+        throw std::runtime_error(filename + ": guiding_training_passes must be >= 0 and guiding_bsdf_fraction in (0, 1]");
+    }
+    if (settings.radiance_cache_cell < 0.0) {
+        throw std::runtime_error(filename + ": radiance_cache_cell must be >= 0");
+    }
+    if (settings.width <= 0 || settings.height <= 0 || settings.samples_per_pixel <= 0 || settings.samples_per_pass <= 0) {
+        throw std::runtime_error(filename + ": render size and sample counts must be positive");
+    }
+
+    const JsonValue& camera = root["camera"];
+    CameraSettings& cam = scene.camera;
+    cam.lookfrom = readVec3(camera["lookfrom"], cam.lookfrom);
+    cam.lookat = readVec3(camera["lookat"], cam.lookat);
+    cam.vup = readVec3(camera["vup"], cam.vup);
+    cam.vfov = camera["vfov"].asNumber(cam.vfov);
+    cam.aperture = camera["aperture"].asNumber(cam.aperture);
+    cam.focus_distance = camera["focus_distance"].asNumber((cam.lookfrom - cam.lookat).length());
+
+    return scene;
+}
+
+std::shared_ptr<ParallelBVHNode> SceneLoader::build(const SceneDescription& scene, HittableList& world,
+    std::vector<std::shared_ptr<Light>>& lights, AtmosphericEffects& atmosphere, Vec3SIMD& background_color,
+    ScenePipeline::StageTimings* timings) {
+    PROFILE_SCOPE_CAT("scene_load", "scene");
+    const JsonValue& root = scene.root;
+    applyAtmosphere(root["atmosphere"], scene, atmosphere, background_color);
+
+    // Texture decode, material setup and mesh loading all overlap in the pipeline
+    ScenePipeline pipeline(scene.render.mesh_cache);
+    TextureHandles texture_handles;
+    const JsonValue& textures = root["textures"];
+    for (size_t i = 0; i < textures.keys().size(); ++i) {
+        texture_handles.emplace(textures.keys()[i], pipeline.loadTexture(resolvePath(scene, textures.items()[i].asString())));
+    }
+
+    std::map<std::string, ScenePipeline::MaterialHandle> materials;
+    const JsonValue& material_descs = root["materials"];
+    for (size_t i = 0; i < material_descs.keys().size(); ++i) {
+        const std::string& name = material_descs.keys()[i];
+        const JsonValue& desc = material_descs.items()[i];
+        const std::string type = desc["type"].asString("lambertian");
+        if (type != "lambertian" && type != "metal" && type != "dielectric") {
+            throw std::runtime_error(scene.filename + ": material '" + name + "' has unknown type '" + type + "'");
+        }
+
+        std::map<std::string, ScenePipeline::TextureHandle> handles;
+        std::vector<ScenePipeline::TextureHandle> inputs;
+        for (const char* key : { "albedo_texture", "roughness_texture", "normal_texture" }) {
+            if (desc[key].isString()) {
+                inputs.push_back(textureFor(desc[key], scene, pipeline, texture_handles));
+                handles.emplace(key, inputs.back());
+            }
+        }
+
+        const int material_id = static_cast<int>(i);
+        materials.emplace(name, pipeline.addMaterial([desc, type, handles, material_id]() -> std::shared_ptr<Material> {
+            std::map<std::string, std::shared_ptr<Texture>> loaded;
+            for (const auto& [key, handle] : handles) loaded.emplace(key, handle.get());
+            std::shared_ptr<Material> material;
+            if (type == "metal") material = createMetal(desc, loaded);
+            else if (type == "dielectric") material = createDielectric(desc);
+            else material = createLambertian(desc, loaded);
+            // Tanım sırası: material_id AOV'u çalıştırmadan çalıştırmaya aynı kalır
+            material->material_id = material_id;
+            return material;
+        }, inputs));
+    }
+
+    const JsonValue& meshes = root["meshes"];
+    ScenePipeline::MaterialHandle default_material;
+    for (const JsonValue& mesh : meshes.items()) {
+        const std::string file = mesh["file"].asString();
+        if (file.empty()) {
+            throw std::runtime_error(scene.filename + ": mesh entry without \"file\"");
+        }
+        ScenePipeline::MaterialHandle material;
+        if (mesh.has("material")) {
+            auto it = materials.find(mesh["material"].asString());
+            if (it == materials.end()) {
+                throw std::runtime_error(scene.filename + ": mesh '" + file + "' references unknown material '" + mesh["material"].asString() + "'");
+            }
+            material = it->second;
+        }
+        else {
+            if (!default_material.valid()) {
+                default_material = ScenePipeline::readyMaterial(std::make_shared<Lambertian>(Vec3(0.8, 0.8, 0.8), 0.5f, 0.0f));
+            }
+            material = default_material;
+        }
+        pipeline.addMesh(resolvePath(scene, file), material);
+    }
+
+    for (const JsonValue& light : root["lights"].items()) {
+        lights.push_back(createLight(light));
+    }
+
+    auto bvh = pipeline.build(world);
+    pipeline.printTimings();
+    if (timings) *timings = pipeline.timings();
+    std::cout << "Total objects in the scene: " << world.size() << " meshes, " << pipeline.timings().triangle_count << " triangles" << std::endl;
+    return bvh;
+}
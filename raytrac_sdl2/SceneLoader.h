@@ -0,0 +1,94 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "AtmosphericEffects.h"
+#include "HittableList.h"
+#include "Json.h"
+#include "Light.h"
+#include "ParallelBVHNode.h"
+#include "ScenePipeline.h"
+#include "Vec3.h"
+#include "Vec3SIMD.h"
+
+struct CameraSettings {
+    Vec3 lookfrom = Vec3(2.2, 1.2, 3.9);
+    Vec3 lookat = Vec3(-2.0, 0.0, -1.0);
+    Vec3 vup = Vec3(0, 1, 0);
+    double vfov = 40.0;
+    double aperture = 0.0;
+    double focus_distance = 2.3;
+};
+
+struct RenderSettings {
+    int width = 1280;
+    int height = 720;
+    int samples_per_pixel = 100;
+    int samples_per_pass = 5;
+    int max_depth = 30;
+    std::string output = "output.png";
+    std::string cost_heatmap;   // "time" or "traversal" writes <output>_cost.png, empty disables it
+    uint32_t seed = 0;          // sampling seed; the same seed reproduces the same image
+    bool denoise = false;              // à-trous denoise the final image before it is saved
+    bool denoise_progressive = false;  // also denoise the preview after every pass
+    std::string aovs;                  // "albedo,normal,depth,material_id,object_id,direct,indirect,emission" or "all"
+    std::string hdr_output;            // .exr (beauty + AOV layers) or .pfm float image of the linear film, empty disables it
+    bool hdr_half = false;             // EXR channels as half instead of float
+    std::string tonemap = "gamma";     // display transform: "gamma", "linear", "srgb", "reinhard" or "aces"
+    double exposure = 0.0;             // stops applied before the display transform
+    std::string integrator = "path";   // "path", "wavefront" or a preview: "ao", "direct", "one_bounce", "normal", "uv", "material"
+    double ao_distance = 1.0;          // ambient occlusion ray length for the "ao" integrator
+    int ao_samples = 4;                // occlusion rays per camera sample
+    std::string shadow_glass = "thin"; // shadow rays through dielectrics: "thin", "refract" or "opaque"
+    bool ray_packets = true;           // trace camera rays and directional-light shadow rays in packets of 16
+    bool interleaved_traversal = false; // trace independent rays (bounces, shadow and AO rays) several at a time with prefetching
+    bool path_guiding = false;         // learn incident radiance online and guide diffuse bounces with it
+    int guiding_training_passes = 4;   // passes that train the guide; it is frozen afterwards
+    double guiding_bsdf_fraction = 0.5; // share of diffuse bounces still sampled from the BSDF
+    bool radiance_cache = false;       // cache indirect diffuse light in a world-space hash grid and end paths on hits
+    double radiance_cache_cell = 0.0;  // cache cell size near the camera, 0 picks scene diagonal / 1024
+    std::string mesh_cache;            // directory for converted .rtmesh files, empty disables cache writes
+};
+
+// Parsed scene file. Camera and render settings are read eagerly,
+// everything that loads assets is kept as JSON until SceneLoader::build.
+struct SceneDescription {
+    std::string filename;
+    std::string asset_root;   // relative asset paths are resolved against this directory
+    JsonValue root;
+    RenderSettings render;
+    CameraSettings camera;
+};
+
+// Data-driven replacement for the hardcoded scene setup.
+//
+// {
+//   "render":     { "width", "height", "samples_per_pixel", "samples_per_pass", "max_depth", "output", "cost_heatmap", "seed",
+//                   "denoise", "denoise_progressive", "aovs": ["albedo", "normal", ...],
+//                   "hdr_output": "render.exr", "hdr_half", "tonemap": "aces", "exposure",
+//                   "integrator": "path" | "wavefront" | "ao" | "direct" | ..., "ao_distance", "ao_samples",
+//                   "shadow_glass": "thin" | "refract" | "opaque", "ray_packets", "interleaved_traversal",
+//                   "path_guiding", "guiding_training_passes", "guiding_bsdf_fraction",
+//                   "radiance_cache", "radiance_cache_cell", "mesh_cache": "cache/meshes" },
+//   "camera":     { "lookfrom": [x,y,z], "lookat", "vup", "vfov", "aperture", "focus_distance" },
+//   "atmosphere": { "enable", "background_color", "background_texture", "fog_start", "fog_density", ... },
+//   "textures":   { "name": "path.jpg", ... },
+//   "materials":  { "name": { "type": "lambertian" | "metal" | "dielectric", ... }, ... },
+//   "meshes":     [ { "file": "model.obj", "material": "name" }, ... ],
+//   "lights":     [ { "type": "directional" | "point" | "area", ... }, ... ]
+// }
+//
+// Textures go through TextureManager and, with "mesh_cache" set, meshes through the
+// .rtmesh cache, so running many variants of the same assets back to back only pays
+// for the first load.
+class SceneLoader {
+public:
+    // Parses the file and the camera/render blocks. Throws std::runtime_error on malformed input.
+    static SceneDescription load(const std::string& filename);
+
+    // Loads textures, materials and meshes through ScenePipeline, fills world and lights,
+    // applies the atmosphere block and returns the top-level BVH. Stage timings are copied to timings when given.
+    static std::shared_ptr<ParallelBVHNode> build(const SceneDescription& scene, HittableList& world,
+        std::vector<std::shared_ptr<Light>>& lights, AtmosphericEffects& atmosphere, Vec3SIMD& background_color,
+        ScenePipeline::StageTimings* timings = nullptr);
+};
@@ -0,0 +1,243 @@
+#include "ScenePipeline.h"
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include "BinaryMesh.h"
+#include "MappedMesh.h"
+#include "ObjLoaderAdapter.h"
+#include "Profiler.h"
+
+ScenePipeline::ScenePipeline(const std::string& cacheDirectory, TaskPool& taskPool)
+    : pool(taskPool), start_time(Clock::now()), cache_directory(cacheDirectory) {
+    if (!cache_directory.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(cache_directory, error);
+        if (error) {
+            std::cerr << "Mesh cache directory " << cache_directory << " is not usable, meshes will not be cached." << std::endl;
+            cache_directory.clear();
+        }
+    }
+}
+
+ScenePipeline::~ScenePipeline() {
+    // Background tasks reference this object, they must finish before it goes away
+    for (auto& mesh : meshes) {
+        if (mesh.valid()) mesh.wait();
+    }
+    for (auto& texture : textures) {
+        texture.wait();
+    }
+}
+
+double ScenePipeline::elapsedMs() const {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start_time).count();
+}
+
+ScenePipeline::TextureHandle ScenePipeline::loadTexture(const std::string& filename) {
+    // The decode job itself records when it finished; textures already in the registry cost nothing here
+    TextureHandle handle = TextureManager::instance().loadAsync(filename, [this]() {
+        std::lock_guard<std::mutex> lock(timing_mutex);
+        last_texture_ready_ms = std::max(last_texture_ready_ms, elapsedMs());
+    });
+
+    textures.push_back(handle);
+    return handle;
+}
+
+ScenePipeline::MaterialHandle ScenePipeline::addMaterial(std::function<std::shared_ptr<Material>()> factory,
+    const std::vector<TextureHandle>& textures) {
+    std::vector<std::function<bool()>> inputs;
+    for (const auto& texture : textures) inputs.push_back(TaskPool::ready(texture));
+    return pool.submitAfter(std::move(inputs), std::move(factory)).share();
+}
+
+ScenePipeline::MaterialHandle ScenePipeline::readyMaterial(const std::shared_ptr<Material>& material) {
+    std::promise<std::shared_ptr<Material>> promise;
+    promise.set_value(material);
+    return promise.get_future().share();
+}
+
+void ScenePipeline::addMesh(const std::string& filename, MaterialHandle material) {
+    const std::string key = std::filesystem::path(filename).lexically_normal().generic_string();
+
+    // Reuse the load already started for this file unless its parsed data has been handed out
+    std::shared_ptr<MeshSource>& source = mesh_sources[key];
+    bool first_user = false;
+    if (source) {
+        std::lock_guard<std::mutex> lock(source->mutex);
+        if (source->released) source.reset();
+        else ++source->users;
+    }
+    if (!source) {
+        source = std::make_shared<MeshSource>();
+        source->users = 1;
+        source->loaded = pool.submit([this, filename, source]() { loadSource(filename, *source); }).share();
+        first_user = true;
+    }
+
+    // Queued behind the load and the material instead of waiting on them inside the job
+    meshes.push_back(pool.submitAfter({ TaskPool::ready(source->loaded), TaskPool::ready(material) },
+        [this, filename, source, first_user, material]() { return instanceMesh(filename, *source, first_user, material); }));
+}
+
+void ScenePipeline::loadSource(const std::string& filename, MeshSource& source) const {
+    PROFILE_SCOPE_CAT("load_mesh", "scene");
+    auto parse_start = Clock::now();
+
+    // Preferred path: a mapped binary mesh, either shipped next to the OBJ or from the cache directory
+    std::string cache = BinaryMesh::cachePath(filename);
+    if (!BinaryMesh::isCacheFresh(filename, cache) && !cache_directory.empty()) {
+        cache = BinaryMesh::cachePath(filename, cache_directory);
+    }
+    if (BinaryMesh::isCacheFresh(filename, cache)) {
+        source.binary = BinaryMesh::open(cache);
+    }
+
+    if (!source.binary) {
+        auto model = std::make_unique<ObjLoader::ObjModel>();
+        if (!ObjLoader::Loader::loadObj(filename, *model, static_cast<unsigned>(pool.threadCount()))) {
+            std::cerr << "Failed to load OBJ file: " << filename << std::endl;
+        }
+        // The parsed model is kept when the cache cannot be written or mapped
+        else if (!cache_directory.empty() && BinaryMesh::convert(*model, cache) && (source.binary = BinaryMesh::open(cache))) {
+            model.reset();
+        }
+        else {
+            source.model = std::move(model);
+        }
+    }
+    source.parse_ms = std::chrono::duration<double, std::milli>(Clock::now() - parse_start).count();
+    source.ready_ms = elapsedMs();
+}
+
+ScenePipeline::MeshResult ScenePipeline::instanceMesh(const std::string& filename, MeshSource& source, bool first_user,
+    MaterialHandle material) const {
+    MeshResult result;
+    result.timing.filename = filename;
+
+    // Queued only after the source load and the material finished, so nothing below blocks
+    result.timing.material_wait_ms = elapsedMs() - source.ready_ms;
+    if (first_user) result.timing.parse_ms = source.parse_ms;
+
+    if (source.binary) {
+        result.timing.from_cache = true;
+        if (source.binary->triangleCount() == 0) {
+            return result;
+        }
+
+        std::shared_ptr<Material> materialToUse = material.get();
+        auto bvh_start = Clock::now();
+        {
+            PROFILE_SCOPE_CAT("mesh_bvh", "scene");
+            result.bvh = std::make_shared<MappedMesh>(source.binary, std::vector<std::shared_ptr<Material>>{ materialToUse });
+        }
+        result.timing.bvh_ms = std::chrono::duration<double, std::milli>(Clock::now() - bvh_start).count();
+        result.timing.triangle_count = source.binary->triangleCount();
+        result.timing.ready_ms = elapsedMs();
+        result.timing.loaded = true;
+        return result;
+    }
+
+    std::shared_ptr<Material> materialToUse = material.get();
+    auto bvh_start = Clock::now();
+
+    // The last user takes the parsed model and frees its buffers while streaming the triangles out,
+    // earlier users copy from it and leave it in place
+    std::unique_ptr<ObjLoader::ObjModel> owned;
+    const ObjLoader::ObjModel* shared = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(source.mutex);
+        if (source.users == 1) {
+            owned = std::move(source.model);
+            source.users = 0;
+            source.released = true;
+        }
+        else {
+            shared = source.model.get();
+        }
+    }
+
+    std::vector<std::shared_ptr<Hittable>> objects;
+    size_t triangle_count = 0;
+    if (owned) {
+        triangle_count = ObjLoaderAdapter::appendTriangles(*owned, objects, materialToUse);
+        owned.reset(); // vertex buffers are copied into the triangles, drop them before the BVH build
+    }
+    else if (shared) {
+        triangle_count = ObjLoaderAdapter::appendTriangles(*shared, objects, materialToUse);
+        std::lock_guard<std::mutex> lock(source.mutex);
+        if (--source.users == 0) {
+            source.model.reset();
+            source.released = true;
+        }
+    }
+    if (triangle_count == 0) {
+        return result;
+    }
+
+    // The BVH takes the list over and sorts it in place
+    {
+        PROFILE_SCOPE_CAT("mesh_bvh", "scene");
+        result.bvh = std::make_shared<ParallelBVHNode>(std::move(objects), 0.0, 1.0);
+    }
+    result.timing.bvh_ms = std::chrono::duration<double, std::milli>(Clock::now() - bvh_start).count();
+    result.timing.triangle_count = triangle_count;
+    result.timing.ready_ms = elapsedMs();
+    result.timing.loaded = true;
+    return result;
+}
+
+std::shared_ptr<ParallelBVHNode> ScenePipeline::build(HittableList& world) {
+    world.reserve(world.size() + meshes.size());
+    for (auto& mesh : meshes) {
+        MeshResult result = mesh.get();
+        if (result.timing.loaded) {
+            world.add(result.bvh);
+            stage_timings.mesh_parse_ms += result.timing.parse_ms;
+            stage_timings.mesh_bvh_ms += result.timing.bvh_ms;
+            stage_timings.triangle_count += result.timing.triangle_count;
+        }
+        else {
+            std::cerr << result.timing.filename << " could not be loaded, continuing with the remaining objects." << std::endl;
+        }
+        stage_timings.meshes.push_back(std::move(result.timing));
+    }
+    meshes.clear();
+    mesh_sources.clear();
+
+    for (auto& texture : textures) {
+        texture.wait();
+    }
+    stage_timings.texture_count = textures.size();
+    {
+        std::lock_guard<std::mutex> lock(timing_mutex);
+        stage_timings.texture_decode_ms = last_texture_ready_ms;
+    }
+
+    std::shared_ptr<ParallelBVHNode> bvh;
+    auto bvh_start = Clock::now();
+    if (!world.objects.empty()) {
+        PROFILE_SCOPE_CAT("scene_bvh", "scene");
+        bvh = std::make_shared<ParallelBVHNode>(world.objects, 0, world.objects.size(), 0.0, 1.0);
+    }
+    stage_timings.scene_bvh_ms = std::chrono::duration<double, std::milli>(Clock::now() - bvh_start).count();
+    stage_timings.total_ms = elapsedMs();
+    return bvh;
+}
+
+void ScenePipeline::printTimings(std::ostream& os) const {
+    const StageTimings& t = stage_timings;
+    os << std::fixed << std::setprecision(1);
+    for (const auto& mesh : t.meshes) {
+        if (!mesh.loaded) continue;
+        os << "  " << mesh.filename << ": " << mesh.triangle_count << " triangles, "
+            << (mesh.from_cache ? "mapped " : "parse ") << mesh.parse_ms
+            << " ms, material wait " << mesh.material_wait_ms << " ms, BVH " << mesh.bvh_ms
+            << " ms, ready at " << mesh.ready_ms << " ms" << std::endl;
+    }
+    os << "Texture decode (" << t.texture_count << " files): ready at " << t.texture_decode_ms << " ms" << std::endl;
+    os << "OBJ parse (sum): " << t.mesh_parse_ms << " ms, mesh BVH (sum): " << t.mesh_bvh_ms << " ms" << std::endl;
+    os << "Scene BVH: " << t.scene_bvh_ms << " ms, triangles: " << t.triangle_count << std::endl;
+    os << "Scene load wall time: " << t.total_ms << " ms" << std::endl;
+    os << std::defaultfloat;
+}
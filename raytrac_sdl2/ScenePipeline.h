@@ -0,0 +1,112 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BinaryMesh.h"
+#include "HittableList.h"
+#include "Material.h"
+#include "ObjLoader.h"
+#include "ParallelBVHNode.h"
+#include "TaskPool.h"
+#include "Texture.h"
+#include "TextureManager.h"
+
+// Concurrent scene loading pipeline.
+// Texture decodes, material setup and OBJ parses all run as jobs on the TaskPool.
+// No job waits on another one: materials and mesh instances are queued only
+// once the textures, mesh loads and materials they use are ready.
+// Each mesh builds its own BVH right after parsing, the top-level BVH is then
+// built over the per-mesh BVHs. Cold start is bounded by the slowest asset
+// instead of the sum of all of them.
+class ScenePipeline {
+public:
+    using TextureHandle = TextureManager::TextureHandle;
+    using MaterialHandle = std::shared_future<std::shared_ptr<Material>>;
+
+    struct MeshTiming {
+        std::string filename;
+        size_t triangle_count = 0;
+        double parse_ms = 0.0;
+        double material_wait_ms = 0.0;
+        double bvh_ms = 0.0;
+        double ready_ms = 0.0;   // pipeline start -> mesh BVH ready
+        bool loaded = false;
+        bool from_cache = false;  // served from the mapped .rtmesh file
+    };
+
+    struct StageTimings {
+        double texture_decode_ms = 0.0;   // pipeline start -> last texture decoded
+        double mesh_parse_ms = 0.0;       // sum of all OBJ parse / mesh map times
+        double mesh_bvh_ms = 0.0;         // sum of all per-mesh BVH builds
+        double scene_bvh_ms = 0.0;        // top-level BVH over the meshes
+        double total_ms = 0.0;            // pipeline start -> scene ready
+        size_t texture_count = 0;
+        size_t triangle_count = 0;
+        std::vector<MeshTiming> meshes;
+    };
+
+    // cacheDirectory receives converted .rtmesh files; empty disables cache writes.
+    explicit ScenePipeline(const std::string& cacheDirectory = "", TaskPool& taskPool = TaskPool::instance());
+    ~ScenePipeline();
+    ScenePipeline(const ScenePipeline&) = delete;
+    ScenePipeline& operator=(const ScenePipeline&) = delete;
+
+    TextureHandle loadTexture(const std::string& filename);
+
+    // The factory runs as a pool job once every handle in textures is decoded.
+    MaterialHandle addMaterial(std::function<std::shared_ptr<Material>()> factory, const std::vector<TextureHandle>& textures = {});
+    static MaterialHandle readyMaterial(const std::shared_ptr<Material>& material);
+
+    // Loads the mesh as a pool job and builds its BVH as soon as the material is known.
+    // A fresh .rtmesh next to the OBJ is mapped as is. Otherwise the OBJ is parsed and, with a
+    // cache directory set, converted once into it so later runs map the cache instead.
+    // Adding the same file again shares one load between both meshes.
+    void addMesh(const std::string& filename, MaterialHandle material);
+
+    // Waits for every mesh, adds the per-mesh BVHs to world and returns the top-level BVH.
+    std::shared_ptr<ParallelBVHNode> build(HittableList& world);
+
+    const StageTimings& timings() const { return stage_timings; }
+    void printTimings(std::ostream& os = std::cout) const;
+
+private:
+    struct MeshResult {
+        std::shared_ptr<Hittable> bvh;
+        MeshTiming timing;
+    };
+
+    // One load per unique mesh path, shared by every addMesh call for that file.
+    // The parsed OBJ is released by the last user that has turned it into triangles.
+    struct MeshSource {
+        std::shared_future<void> loaded;
+        std::shared_ptr<BinaryMesh> binary;
+        std::unique_ptr<ObjLoader::ObjModel> model;
+        double parse_ms = 0.0;
+        double ready_ms = 0.0;   // pipeline start -> load finished
+        std::mutex mutex;
+        int users = 0;
+        bool released = false;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    void loadSource(const std::string& filename, MeshSource& source) const;
+    MeshResult instanceMesh(const std::string& filename, MeshSource& source, bool first_user, MaterialHandle material) const;
+    double elapsedMs() const;
+
+    TaskPool& pool;
+    Clock::time_point start_time;
+    std::string cache_directory;
+    std::unordered_map<std::string, std::shared_ptr<MeshSource>> mesh_sources;
+    std::vector<TextureHandle> textures;
+    std::mutex timing_mutex;
+    double last_texture_ready_ms = 0.0;
+    std::vector<std::future<MeshResult>> meshes;
+    StageTimings stage_timings;
+};
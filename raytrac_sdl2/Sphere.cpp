@@ -1,10 +1,12 @@
 #include "Sphere.h"
+#include "RayStats.h"
 
 Sphere::Sphere() {}
 Sphere::Sphere(Vec3 cen, double r, std::shared_ptr<Material> m)
     : center(cen), radius(r), material(m) {}
 
 bool Sphere::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const {
+    RAY_STAT_INC(sphere_tests);
     Vec3 oc = r.origin - center;
     auto a = Vec3::dot(r.direction, r.direction);
     auto b = Vec3::dot(oc, r.direction);
@@ -18,6 +20,7 @@ bool Sphere::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const
             rec.t = temp;
             rec.point = r.at(rec.t);
             Vec3 outward_normal = (rec.point - center) / radius;
+            rec.face_normal = outward_normal;
             rec.set_face_normal(r, outward_normal);
             rec.material = material;
             return true;
@@ -27,6 +30,7 @@ bool Sphere::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const
             rec.t = temp;
             rec.point = r.at(rec.t);
             Vec3 outward_normal = (rec.point - center) / radius;
+            rec.face_normal = outward_normal;
             rec.set_face_normal(r, outward_normal);
             rec.material = material;
             return true;
@@ -0,0 +1,111 @@
+#include "TaskPool.h"
+#include <algorithm>
+#include "Profiler.h"
+
+namespace {
+    // Live pools, woken after every job in any of them. Constructed inside the first pool's
+    // constructor, so it outlives the static instance() pool
+    std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+    std::vector<TaskPool*>& registry() {
+        static std::vector<TaskPool*> pools;
+        return pools;
+    }
+}
+
+TaskPool& TaskPool::instance() {
+    static TaskPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+TaskPool::TaskPool(unsigned thread_count) {
+    Profiler::instance(); // constructed first so it outlives the workers that record into it
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registry().push_back(this);
+    }
+    workers.reserve(thread_count);
+    for (unsigned i = 0; i < thread_count; ++i) {
+        workers.emplace_back(&TaskPool::workerLoop, this);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    job_available.notify_all();
+    // Workers drain the queue and the pending jobs before they exit, so no submitted future is left broken
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    // Only now: pending jobs drained above may have waited on inputs from other pools
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto& pools = registry();
+    pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+}
+
+void TaskPool::inputsChanged() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (TaskPool* pool : registry()) {
+        pool->wakeIfPending();
+    }
+}
+
+// Taking the mutex orders this after a worker's last readiness check, so the wakeup can not be lost
+void TaskPool::wakeIfPending() {
+    bool waiting;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        waiting = !pending.empty();
+    }
+    if (waiting) job_available.notify_all();
+}
+
+void TaskPool::enqueue(std::vector<std::function<bool()>> inputs, std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const bool ready = std::all_of(inputs.begin(), inputs.end(), [](const auto& input) { return input(); });
+        if (ready) jobs.push_back(std::move(job));
+        else pending.push_back({ std::move(inputs), std::move(job) });
+    }
+    job_available.notify_one();
+}
+
+// Caller holds the mutex
+void TaskPool::releaseReady() {
+    auto ready = std::stable_partition(pending.begin(), pending.end(), [](const PendingJob& p) {
+        return !std::all_of(p.inputs.begin(), p.inputs.end(), [](const auto& input) { return input(); });
+    });
+    for (auto it = ready; it != pending.end(); ++it) {
+        jobs.push_back(std::move(it->job));
+    }
+    if (ready != pending.end()) job_available.notify_all();
+    pending.erase(ready, pending.end());
+}
+
+void TaskPool::workerLoop() {
+    Profiler::instance().setThreadName("loader worker");
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                // Any finished job may complete the inputs of a pending one
+                releaseReady();
+                if (!jobs.empty()) break;
+                if (pending.empty() && stopping) return;
+                // New jobs and finished inputs (from this or any other pool) both notify job_available
+                job_available.wait(lock);
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+        // The job's future is set by now and may be the last input of a pending job here or elsewhere
+        inputsChanged();
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Bounded worker pool for scene loading jobs (texture decodes, material setup,
+// mesh parses). Jobs run in submission order on a fixed set of threads, so a
+// scene with hundreds of assets still only uses hardware_concurrency threads.
+//
+// Jobs never block on other jobs: a worker that waits on the queue it serves can
+// end up waiting on a job queued behind itself. Work that depends on earlier jobs
+// is submitted with submitAfter() and only enters the queue once its inputs are ready.
+// Every finished job wakes the workers of all pools that hold pending jobs, so inputs
+// from another pool (texture decodes run on instance()) release their dependents too.
+class TaskPool {
+public:
+    // Shared pool with one worker per hardware thread.
+    static TaskPool& instance();
+
+    explicit TaskPool(unsigned thread_count);
+    ~TaskPool();
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F&& job) {
+        return submitAfter({}, std::forward<F>(job));
+    }
+
+    // Queues the job once every future in inputs is ready, so it can get() them without blocking.
+    // The futures may come from any pool or an already set promise; the job is not queued before they are set.
+    // An input completed outside every pool must be followed by inputsChanged().
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submitAfter(std::vector<std::function<bool()>> inputs, F&& job) {
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        std::future<Result> future = task->get_future();
+        enqueue(std::move(inputs), [task]() { (*task)(); });
+        return future;
+    }
+
+    // Input for submitAfter(): true once the future holds a value or an exception.
+    template <typename T>
+    static std::function<bool()> ready(std::shared_future<T> future) {
+        return [future = std::move(future)]() {
+            return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        };
+    }
+
+    size_t threadCount() const { return workers.size(); }
+
+    // Re-checks the pending jobs of every pool. Called after each job, and by code that
+    // completes a submitAfter() input on its own thread.
+    static void inputsChanged();
+
+private:
+    struct PendingJob {
+        std::vector<std::function<bool()>> inputs;
+        std::function<void()> job;
+    };
+
+    void enqueue(std::vector<std::function<bool()>> inputs, std::function<void()> job);
+    void releaseReady();
+    void wakeIfPending();
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::vector<PendingJob> pending;   // waiting for their inputs, not yet in jobs
+    std::mutex mutex;
+    std::condition_variable job_available;
+    bool stopping = false;
+};
@@ -2,6 +2,7 @@
 
 #include "Texture.h"
 #include <iostream>
+#include "Vec3x8.h"
 
 Texture::Texture(const std::string& filename) {
     SDL_Surface* surface = IMG_Load(filename.c_str());
@@ -12,7 +13,9 @@ Texture::Texture(const std::string& filename) {
 
     width = surface->w;
     height = surface->h;
-    pixels.resize(width * height);
+    red.resize(width * height);
+    green.resize(width * height);
+    blue.resize(width * height);
 
     SDL_LockSurface(surface);
     Uint8* pixelData = static_cast<Uint8*>(surface->pixels);
@@ -74,16 +77,16 @@ Texture::Texture(const std::string& filename) {
             float normalized_b = b / 255.0f;
             float normalized_a = a / 255.0f;
 
-            // Alfa deerini de kullanmak isterseniz:
-            // pixels[y * width + x] = Vec4(normalized_r, normalized_g, normalized_b, normalized_a);
-            // Eer Vec3 kullanmaya devam etmek istiyorsanz:
-            pixels[y * width + x] = Vec3(normalized_r, normalized_g, normalized_b);
+            red[y * width + x] = normalized_r;
+            green[y * width + x] = normalized_g;
+            blue[y * width + x] = normalized_b;
         }
     }
 
 
     SDL_UnlockSurface(surface);
     SDL_FreeSurface(surface);
+    m_is_loaded = true;
 }
 
 Vec3 Texture::get_color(double u, double v) const {
@@ -101,18 +104,41 @@ Vec3 Texture::get_color(double u, double v) const {
     double tx = x - x0;
     double ty = y - y0;
 
-    Vec3 c00 = pixels[y0 * width + x0];
-    Vec3 c10 = pixels[y0 * width + x1];
-    Vec3 c01 = pixels[y1 * width + x0];
-    Vec3 c11 = pixels[y1 * width + x1];
+    const int i00 = y0 * width + x0, i10 = y0 * width + x1;
+    const int i01 = y1 * width + x0, i11 = y1 * width + x1;
+    Vec3 c00(red[i00], green[i00], blue[i00]);
+    Vec3 c10(red[i10], green[i10], blue[i10]);
+    Vec3 c01(red[i01], green[i01], blue[i01]);
+    Vec3 c11(red[i11], green[i11], blue[i11]);
 
     Vec3 c0 = c00 * (1 - tx) + c10 * tx;
     Vec3 c1 = c01 * (1 - tx) + c11 * tx;   
     return c0 * (1 - ty) + c1 * ty;
 }
 
-
-Texture::~Texture() {
-    // SDL_image'in kulland kaynaklar temizle
-    IMG_Quit();
-}
\ No newline at end of file
+void Texture::get_color8(const float* u, const float* v, float* r, float* g, float* b) const {
+    if (!m_is_loaded) {
+        for (int i = 0; i < 8; ++i) r[i] = g[i] = b[i] = 0.0f;
+        return;
+    }
+    // get_color ile ayn filtre, sekiz koordinat iin tek seferde
+    const Floatx8 x = clamp(Floatx8::load(u), Floatx8(0.0f), Floatx8(1.0f)) * Floatx8(static_cast<float>(width - 1));
+    const Floatx8 y = (Floatx8(1.0f) - clamp(Floatx8::load(v), Floatx8(0.0f), Floatx8(1.0f))) * Floatx8(static_cast<float>(height - 1));
+
+    const Intx8 x0 = toInt(floor(x)), y0 = toInt(floor(y));
+    const Intx8 x1 = min(x0 + Intx8(1), Intx8(width - 1)), y1 = min(y0 + Intx8(1), Intx8(height - 1));
+    const Floatx8 tx = x - toFloat(x0), ty = y - toFloat(y0);
+
+    const Intx8 row0 = y0 * Intx8(width), row1 = y1 * Intx8(width);
+    const Intx8 i00 = row0 + x0, i10 = row0 + x1, i01 = row1 + x0, i11 = row1 + x1;
+    const std::vector<float>* planes[3] = { &red, &green, &blue };
+    float* out[3] = { r, g, b };
+    for (int c = 0; c < 3; ++c) {
+        const float* plane = planes[c]->data();
+        const Floatx8 c00 = gather(plane, i00), c10 = gather(plane, i10);
+        const Floatx8 c01 = gather(plane, i01), c11 = gather(plane, i11);
+        const Floatx8 c0 = fmadd(c10 - c00, tx, c00);
+        const Floatx8 c1 = fmadd(c11 - c01, tx, c01);
+        fmadd(c1 - c0, ty, c0).store(out[c]);
+    }
+}
@@ -7,9 +7,10 @@
 
 class Texture {
 private:
-    std::vector<Vec3> pixels;
-    int width;
-    int height;
+    // One float plane per channel; get_color reads them one texel at a time, get_color8 gathers eight
+    std::vector<float> red, green, blue;
+    int width = 0;
+    int height = 0;
      bool m_is_loaded = false;
 public:
     Texture(const std::string& filename);
@@ -18,7 +19,8 @@ public:
     }
 
     Vec3 get_color(double u, double v) const;
-    ~Texture();
+    // Eight bilinear lookups at once in single precision; u, v, r, g and b point to eight floats
+    void get_color8(const float* u, const float* v, float* r, float* g, float* b) const;
     bool is_loaded() const { return m_is_loaded; }
     
 };
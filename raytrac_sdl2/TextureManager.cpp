@@ -0,0 +1,100 @@
+#include "TextureManager.h"
+#include <filesystem>
+#include <iostream>
+#include "Profiler.h"
+#include "TaskPool.h"
+
+TextureManager& TextureManager::instance() {
+    static TextureManager manager;
+    return manager;
+}
+
+TextureManager::~TextureManager() {
+    shutdown();
+}
+
+std::string TextureManager::normalizePath(const std::string& filename) {
+    // "Texture/./kure.jpg" and "Texture\\kure.jpg" must map to the same entry
+    return std::filesystem::path(filename).lexically_normal().generic_string();
+}
+
+void TextureManager::ensureDecoder() {
+    if (decoder_initialized) return;
+
+    const int flags = IMG_INIT_JPG | IMG_INIT_PNG;
+    if ((IMG_Init(flags) & flags) != flags) {
+        std::cerr << "SDL_image decoder could not be fully initialized: " << IMG_GetError() << std::endl;
+    }
+    decoder_initialized = true;
+}
+
+std::shared_ptr<Texture> TextureManager::load(const std::string& filename) {
+    return loadAsync(filename).get();
+}
+
+TextureManager::TextureHandle TextureManager::loadAsync(const std::string& filename, std::function<void()> on_decoded) {
+    const std::string key = normalizePath(filename);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = textures.find(key);
+    if (it != textures.end()) {
+        // A failed decode is not cached: the file may have been fixed or written since
+        const bool failed = it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready && !it->second.get();
+        if (!failed) return it->second;
+        textures.erase(it);
+    }
+
+    ensureDecoder();
+    TextureHandle handle = TaskPool::instance().submit([key, on_decoded = std::move(on_decoded)]() -> std::shared_ptr<Texture> {
+        PROFILE_SCOPE_CAT("texture_decode", "scene");
+        auto texture = std::make_shared<Texture>(key);
+        if (on_decoded) on_decoded();
+        return texture->is_loaded() ? texture : nullptr;
+    }).share();
+
+    textures.emplace(key, handle);
+    return handle;
+}
+
+bool TextureManager::contains(const std::string& filename) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return textures.find(normalizePath(filename)) != textures.end();
+}
+
+size_t TextureManager::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return textures.size();
+}
+
+size_t TextureManager::releaseUnused() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t released = 0;
+    for (auto it = textures.begin(); it != textures.end();) {
+        const bool ready = it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (ready && it->second.get().use_count() <= 1) {
+            it = textures.erase(it);
+            ++released;
+        }
+        else {
+            ++it;
+        }
+    }
+    return released;
+}
+
+void TextureManager::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    textures.clear();
+}
+
+void TextureManager::shutdown() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : textures) {
+        entry.second.wait(); // decoder must not be shut down under a running decode
+    }
+    textures.clear();
+    if (decoder_initialized) {
+        IMG_Quit();
+        decoder_initialized = false;
+    }
+}
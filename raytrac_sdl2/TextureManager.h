@@ -0,0 +1,56 @@
+#pragma once
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Texture.h"
+
+// Global, path-keyed texture registry.
+// Each image file is decoded once and every material shares the same
+// std::shared_ptr<Texture>. The SDL_image decoder lifetime is owned here,
+// Texture objects never call IMG_Init/IMG_Quit themselves.
+class TextureManager {
+public:
+    static TextureManager& instance();
+
+    using TextureHandle = std::shared_future<std::shared_ptr<Texture>>;
+
+    // Loads the file on first request, returns the cached texture afterwards.
+    // Returns nullptr if the image could not be decoded.
+    // Blocks until the decode, which runs on TaskPool::instance(), is done. Must not be
+    // called from a TaskPool job: the decode can be queued behind the caller and never
+    // start. Pool jobs take a loadAsync handle as a TaskPool::submitAfter input instead.
+    std::shared_ptr<Texture> load(const std::string& filename);
+
+    // Queues the decode on the shared TaskPool and returns immediately.
+    // Concurrent requests for the same file share one decode. on_decoded runs
+    // inside the decode job; it is not called when the file is already registered.
+    // Failed decodes are not kept: a later request for the file decodes it again.
+    TextureHandle loadAsync(const std::string& filename, std::function<void()> on_decoded = {});
+
+    bool contains(const std::string& filename) const;
+    size_t size() const;
+
+    // Drops textures that are only referenced by the registry itself.
+    size_t releaseUnused();
+    void clear();
+
+    // Clears the cache and shuts the SDL_image decoder down.
+    void shutdown();
+
+    TextureManager(const TextureManager&) = delete;
+    TextureManager& operator=(const TextureManager&) = delete;
+
+private:
+    TextureManager() = default;
+    ~TextureManager();
+
+    static std::string normalizePath(const std::string& filename);
+    void ensureDecoder();
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, TextureHandle> textures;
+    bool decoder_initialized = false;
+};
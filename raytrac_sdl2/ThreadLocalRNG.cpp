@@ -5,6 +5,10 @@ ThreadLocalRNG::ThreadLocalRNG()
     dis(0.0f, 1.0f) {
 }
 
+ThreadLocalRNG::ThreadLocalRNG(uint32_t seed)
+    : gen(seed), dis(0.0f, 1.0f) {
+}
+
 float ThreadLocalRNG::get() {
     return dis(gen);
 }
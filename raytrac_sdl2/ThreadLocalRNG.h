@@ -3,6 +3,7 @@
 
 #include <random>
 #include <thread>
+#include <cstdint>
 
 class ThreadLocalRNG {
 private:
@@ -11,7 +12,17 @@ private:
 
 public:
     ThreadLocalRNG();
+    explicit ThreadLocalRNG(uint32_t seed);
     float get();
 };
 
+// Birden fazla değeri tek bir tohumda karıştırır (tekrarlanabilir render için)
+inline uint32_t hash_seed(uint32_t a, uint32_t b, uint32_t c) {
+    uint64_t h = a * 0x9E3779B97F4A7C15ull;
+    h ^= (h >> 32) + b * 0xC2B2AE3D27D4EB4Full;
+    h ^= (h >> 29) + c * 0x165667B19E3779F9ull;
+    h ^= h >> 32;
+    return static_cast<uint32_t>(h);
+}
+
 #endif // THREAD_LOCAL_RNG_H
@@ -7,89 +7,134 @@
 #include <iostream>
 #include "ObjLoader.h"
 #include "globals.h"
+#include "RayStats.h"
 #include "Lambertian.h"
 
+namespace {
+    inline void store(float* out, const Vec3& v) {
+        out[0] = static_cast<float>(v.x);
+        out[1] = static_cast<float>(v.y);
+        out[2] = static_cast<float>(v.z);
+    }
+
+    inline Vec3 load(const float* v) {
+        return Vec3(v[0], v[1], v[2]);
+    }
+
+    // Unit normal, or zero for a missing (zero) normal
+    inline void store_normal(float* out, const Vec3& n) {
+        store(out, n.length_squared() > 0.0 ? n.normalize() : n);
+    }
+
+    inline void cross(const float* a, const float* b, float* out) {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    inline float dot(const float* a, const float* b) {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+}
+
 Triangle::Triangle()
-    : smoothGroup(0) {}
+    : smoothGroup(0), vertices{}, normals{} {}
 
 Triangle::Triangle(const Vec3& a, const Vec3& b, const Vec3& c, std::shared_ptr<Material> m)
-    : v0(a), v1(b), v2(c), material(m), smoothGroup(0) {}
+    : material(m), smoothGroup(0), normals{} {
+    store(vertices[0], a);
+    store(vertices[1], b);
+    store(vertices[2], c);
+}
 
 Triangle::Triangle(const Vec3& a, const Vec3& b, const Vec3& c,
     const Vec3& na, const Vec3& nb, const Vec3& nc,
     const Vec2& ta, const Vec2& tb, const Vec2& tc,
     std::shared_ptr<Material> m, int sg)
-    : v0(a), v1(b), v2(c),
-    n0(na), n1(nb), n2(nc),
-    t0(ta), t1(tb), t2(tc),
+    : t0(ta), t1(tb), t2(tc),
     material(m), smoothGroup(sg) {
-    update_bounding_box();
+    store(vertices[0], a);
+    store(vertices[1], b);
+    store(vertices[2], c);
+    store_normal(normals[0], na);
+    store_normal(normals[1], nb);
+    store_normal(normals[2], nc);
 }
 
 
 void Triangle::set_normals(const Vec3& normal0, const Vec3& normal1, const Vec3& normal2) {
-    n0 = normal0.normalize();
-    n1 = normal1.normalize();
-    n2 = normal2.normalize();
+    store_normal(normals[0], normal0);
+    store_normal(normals[1], normal1);
+    store_normal(normals[2], normal2);
 }
 
 void Triangle::set_transform(const Matrix4x4& t) {
-    transform = t;
-
-    update_bounding_box();
-}
-
-void Triangle::update_bounding_box() {
-    Vec3 transformed_v0 = transform.transform_point(v0);
-    Vec3 transformed_v1 = transform.transform_point(v1);
-    Vec3 transformed_v2 = transform.transform_point(v2);
-
-    min_point = Vec3(
-        std::min({ transformed_v0.x, transformed_v1.x, transformed_v2.x }),
-        std::min({ transformed_v0.y, transformed_v1.y, transformed_v2.y }),
-        std::min({ transformed_v0.z, transformed_v1.z, transformed_v2.z })
-    );
-    max_point = Vec3(
-        std::max({ transformed_v0.x, transformed_v1.x, transformed_v2.x }),
-        std::max({ transformed_v0.y, transformed_v1.y, transformed_v2.y }),
-        std::max({ transformed_v0.z, transformed_v1.z, transformed_v2.z })
-    );
-}
-float safeAcos(float x) {
-    if (x < -1.0f) x = -1.0f;
-    else if (x > 1.0f) x = 1.0f;
-    return std::acos(x);
+    for (int i = 0; i < 3; ++i) {
+        store(vertices[i], t.transform_point(load(vertices[i])));
+        store_normal(normals[i], t.transform_vector(load(normals[i])));
+    }
 }
-bool Triangle::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const {
-    // Transform the vertices
-    Vec3 transformed_v0 = transform.transform_point(v0);
-    Vec3 transformed_v1 = transform.transform_point(v1);
-    Vec3 transformed_v2 = transform.transform_point(v2);
-
-    Vec3 edge1 = transformed_v1 - transformed_v0;
-    Vec3 edge2 = transformed_v2 - transformed_v0;
-    Vec3 h = Vec3::cross(r.direction, edge2);
-    double a = Vec3::dot(edge1, h);
-   
-    if (std::abs(a) < EPSILON)
-        return false;
 
-    double f = 1.0 / a;
-    Vec3 s = r.origin - transformed_v0;
-    double u = f * Vec3::dot(s, h);
+bool Triangle::intersect(const float* p0, const float* p1, const float* p2, const Ray& r,
+    double t_min, double t_max, double& t, double& u, double& v) {
+    // Watertight test: the vertices are moved to the ray origin and sheared so the ray runs down
+    // the z axis, then the origin is classified against the three edges in 2D. A vertex shared by
+    // two triangles is transformed to the same floats in both, so no ray slips between neighbours
+    const float direction[3] = { static_cast<float>(r.direction.x), static_cast<float>(r.direction.y), static_cast<float>(r.direction.z) };
+    int kz = 0;
+    if (std::abs(direction[1]) > std::abs(direction[kz])) kz = 1;
+    if (std::abs(direction[2]) > std::abs(direction[kz])) kz = 2;
+    int kx = kz == 2 ? 0 : kz + 1;
+    int ky = kx == 2 ? 0 : kx + 1;
+    if (direction[kz] < 0.0f) std::swap(kx, ky);   // keeps the winding
+    const float inv_z = 1.0f / direction[kz];
+    const float shear_x = direction[kx] * inv_z;
+    const float shear_y = direction[ky] * inv_z;
+
+    const float origin[3] = { static_cast<float>(r.origin.x), static_cast<float>(r.origin.y), static_cast<float>(r.origin.z) };
+    const float* points[3] = { p0, p1, p2 };
+    float x[3], y[3];
+    for (int i = 0; i < 3; ++i) {
+        const float z = points[i][kz] - origin[kz];
+        x[i] = (points[i][kx] - origin[kx]) - shear_x * z;
+        y[i] = (points[i][ky] - origin[ky]) - shear_y * z;
+    }
 
-    if (u < 0.0 || u > 1.0)
+    // Edge functions; e0 weights p0 (edge p1-p2), e1 weights p1, e2 weights p2. Float products are
+    // exact in double, so each sign is exact for the transformed vertices and an edge seen from the
+    // other triangle is its exact negative, FMA contraction or not
+    const double e0 = double(x[2]) * y[1] - double(y[2]) * x[1];
+    const double e1 = double(x[0]) * y[2] - double(y[0]) * x[2];
+    const double e2 = double(x[1]) * y[0] - double(y[1]) * x[0];
+    if ((e0 < 0.0 || e1 < 0.0 || e2 < 0.0) && (e0 > 0.0 || e1 > 0.0 || e2 > 0.0))
+        return false;
+    const double determinant = e0 + e1 + e2;
+    if (determinant == 0.0)
         return false;
 
-    Vec3 q = Vec3::cross(s, edge1);
-    double v = f * Vec3::dot(r.direction, q);
-
-    if (v < 0.0 || u + v > 1.0)
+    // Plane distance n.(p0 - origin) / n.direction. Float products are exact in double, so the
+    // numerator only rounds at the scale of the origin and p0; a t from the float vertices above
+    // would round at the scale of p0 - origin, which a large triangle makes larger than the spawn offset
+    const float edge1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    const float edge2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    float n[3];
+    cross(edge1, edge2, n);
+    const double numerator = double(n[0]) * p0[0] + double(n[1]) * p0[1] + double(n[2]) * p0[2]
+        - (n[0] * r.origin.x + n[1] * r.origin.y + n[2] * r.origin.z);
+    t = numerator / (n[0] * r.direction.x + n[1] * r.direction.y + n[2] * r.direction.z);
+
+    if (!(t >= t_min && t <= t_max))
         return false;
 
-    double t = f * Vec3::dot(edge2, q);
+    u = e1 / determinant;
+    v = e2 / determinant;
+    return true;
+}
 
-    if (t < t_min || t > t_max)
+bool Triangle::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) const {
+    RAY_STAT_INC(triangle_tests);
+    double t, u, v;
+    if (!intersect(vertices[0], vertices[1], vertices[2], r, t_min, t_max, t, u, v))
         return false;
 
     rec.t = t;
@@ -99,22 +144,18 @@ bool Triangle::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) con
 
     const double w = 1.0 - u - v;
 
-    // Transform and normalize the normals
-    Vec3 transformed_n0 = transform.transform_vector(n0).normalize();
-    Vec3 transformed_n1 = transform.transform_vector(n1).normalize();
-    Vec3 transformed_n2 = transform.transform_vector(n2).normalize();
-
-    rec.interpolated_normal = (w * transformed_n0 + u * transformed_n1 + v * transformed_n2).normalize();
-    rec.face_normal = Vec3::cross(edge1, edge2).normalize();
+    const Vec3 p0 = load(vertices[0]);
+    rec.face_normal = Vec3::cross(load(vertices[1]) - p0, load(vertices[2]) - p0).normalize();
+    const Vec3 interpolated = w * load(normals[0]) + u * load(normals[1]) + v * load(normals[2]);
+    rec.interpolated_normal = interpolated.length_squared() > 1e-12 ? interpolated.normalize() : rec.face_normal;
 
     // Set smoothGroup
     rec.smoothGroup = smoothGroup;
 
     // Calculate normal based on smoothGroup
     if (smoothGroup > 0) {
-        float angle = safeAcos(Vec3::dot(rec.interpolated_normal, rec.face_normal));
-        float angle_threshold = 60.0f * M_PI / 180.0f;
-        rec.normal = (angle <= angle_threshold) ? rec.interpolated_normal : rec.face_normal;
+        // Angle <= 60 degrees compared as cosine >= cos(60) = 0.5, without the acos
+        rec.normal = (Vec3::dot(rec.interpolated_normal, rec.face_normal) >= 0.5) ? rec.interpolated_normal : rec.face_normal;
     }
     else if (smoothGroup == 0) {
         rec.normal = rec.interpolated_normal;
@@ -139,6 +180,13 @@ bool Triangle::hit(const Ray& r, double t_min, double t_max, HitRecord& rec) con
 
 
 bool Triangle::bounding_box(double time0, double time1, AABB& output_box) const {
-    output_box = AABB(min_point - (EPSILON), max_point + (EPSILON));
+    // Flat boxes are fine: the slab tests accept t_min == t_max
+    output_box = AABB(
+        Vec3SIMD(std::min({ vertices[0][0], vertices[1][0], vertices[2][0] }),
+            std::min({ vertices[0][1], vertices[1][1], vertices[2][1] }),
+            std::min({ vertices[0][2], vertices[1][2], vertices[2][2] })),
+        Vec3SIMD(std::max({ vertices[0][0], vertices[1][0], vertices[2][0] }),
+            std::max({ vertices[0][1], vertices[1][1], vertices[2][1] }),
+            std::max({ vertices[0][2], vertices[1][2], vertices[2][2] })));
     return true;
-}
\ No newline at end of file
+}
@@ -15,17 +15,9 @@
 
 class Triangle : public Hittable {
 public:
-    Vec3 v0, v1, v2;  // Vertices
-    Vec3 n0, n1, n2;  // Normals
     Vec2 t0, t1, t2;  // Texture coordinates
-   
+
     std::shared_ptr<Material> material;
-    Matrix4x4 transform;
-    Vec3 albedo0, albedo1, albedo2;
-    float metallic0, metallic1, metallic2;
-    float roughness0, roughness1, roughness2;
-    std::shared_ptr<Texture> texture;
-    std::string materialName;
     int smoothGroup;
 
     // Default constructor
@@ -40,7 +32,8 @@ public:
         std::shared_ptr<Material> m, int sg);
         
 
-    // Set transformation matrix
+    // Moves the vertices and normals by t. Geometry is kept in world space only, so a
+    // second call applies on top of the first
     void set_transform(const Matrix4x4& t);
     void render(SDL_Renderer* renderer, SDL_Texture* texture);
     // Set normals
@@ -52,10 +45,17 @@ public:
     // Override bounding box function for bounding volume hierarchy (BVH)
     virtual bool bounding_box(double time0, double time1, AABB& output_box) const override;
 
+    // Watertight single precision test on three vertices (x, y, z each); MappedMesh uses it on its
+    // mapped positions. t is the distance to the triangle's plane taken in double, so its error
+    // follows the ray origin rather than the size of the triangle and offset_ray_origin clears it
+    static bool intersect(const float* p0, const float* p1, const float* p2, const Ray& r,
+        double t_min, double t_max, double& t, double& u, double& v);
+
 private:
-    Vec3 min_point;
-    Vec3 max_point;
-    void update_bounding_box();
+    // World-space vertices and unit vertex normals in single precision. Zero normals
+    // (no normals given) shade with the face normal
+    float vertices[3][3];
+    float normals[3][3];
 };
 
 #endif // TRIANGLE_H
@@ -78,14 +78,19 @@ Vec3 Vec3::normalize() const {
     return *this / len;
 }
 // Mersenne Twister rastgele say reteci
-std::mt19937 rng;
-std::uniform_real_distribution<double> dist(0.0, 1.0);
+// Her i paracnn kendi reteci var: paylalan rete hem veri yaryd hem de nbellek satr ekimesi
+thread_local std::mt19937 rng;
+thread_local std::uniform_real_distribution<double> dist(0.0, 1.0);
 
 // Rastgele say reteciyi tohumla
 void seed_random() {
     std::random_device rd;
     rng.seed(rd());
 }
+void seed_random(uint32_t seed) {
+    rng.seed(seed);
+    dist.reset();
+}
 // [0, 1) aralnda rastgele bir say ret
 double random_double() {
     return dist(rng);
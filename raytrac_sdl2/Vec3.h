@@ -4,6 +4,7 @@
 #include <iostream>
 #include <cmath>
 #include <stdexcept>
+#include <cstdint>
 #include <algorithm> // std::clamp iin
 
 #define M_PI 3.14159265358979323846
@@ -104,5 +105,7 @@ Vec3 operator*(double t, const Vec3& v);
 // Function declarations
 double random_double(double min, double max);
 double random_double();
+void seed_random();
+void seed_random(uint32_t seed); // sadece aran i paracnn retecini tohumlar
 Vec3 operator*(double t, const Vec3& v);
 #endif // VEC3_H
@@ -0,0 +1,379 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+#include "Vec3.h"
+
+// Eight-lane single precision vectors in structure-of-arrays layout.
+//
+// Vec3SIMD keeps one xyz vector in an SSE register, so dot() and length()
+// need horizontal adds and a quarter of every register is unused. A Floatx8
+// holds one quantity for eight rays, pixels or samples, and a Vec3x8 is three
+// of them, so a dot product is one multiply and two multiply-adds with every
+// lane doing useful work. Comparisons return a Maskx8; divergent code runs on
+// all lanes and select() keeps, per lane, the result that lane wanted.
+//
+// With AVX2 (the x64 configurations) the types are __m256 / __m256i
+// registers. Other builds get the same interface over plain arrays (with
+// exact division instead of the rsqrt estimate), so code written against it
+// compiles everywhere.
+
+#if defined(__AVX2__)
+#define VEC3X8_AVX2 1
+#else
+#define VEC3X8_AVX2 0
+#endif
+
+#if VEC3X8_AVX2 && (defined(__FMA__) || defined(_MSC_VER))
+#define VEC3X8_FMA 1
+#else
+#define VEC3X8_FMA 0
+#endif
+
+// ---------------------------------------------------------------------------
+// Maskx8: one boolean per lane
+
+struct Maskx8 {
+#if VEC3X8_AVX2
+    __m256 m;   // all bits set in true lanes
+    Maskx8() = default;
+    explicit Maskx8(__m256 mask) : m(mask) {}
+    int bits() const { return _mm256_movemask_ps(m); }
+    static Maskx8 fromBits(int bits) {
+        const __m256i lane_bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i set = _mm256_and_si256(_mm256_set1_epi32(bits), lane_bit);
+        return Maskx8(_mm256_castsi256_ps(_mm256_cmpeq_epi32(set, lane_bit)));
+    }
+#else
+    int m;      // bit i for lane i
+    Maskx8() = default;
+    explicit Maskx8(int mask) : m(mask & 0xFF) {}
+    int bits() const { return m; }
+    static Maskx8 fromBits(int bits) { return Maskx8(bits); }
+#endif
+    bool any() const { return bits() != 0; }
+    bool all() const { return bits() == 0xFF; }
+    bool none() const { return bits() == 0; }
+    bool operator[](int lane) const { return (bits() >> lane) & 1; }
+};
+
+#if VEC3X8_AVX2
+inline Maskx8 operator&(const Maskx8& a, const Maskx8& b) { return Maskx8(_mm256_and_ps(a.m, b.m)); }
+inline Maskx8 operator|(const Maskx8& a, const Maskx8& b) { return Maskx8(_mm256_or_ps(a.m, b.m)); }
+inline Maskx8 operator^(const Maskx8& a, const Maskx8& b) { return Maskx8(_mm256_xor_ps(a.m, b.m)); }
+inline Maskx8 operator!(const Maskx8& a) { return Maskx8(_mm256_xor_ps(a.m, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))); }
+#else
+inline Maskx8 operator&(const Maskx8& a, const Maskx8& b) { return Maskx8(a.m & b.m); }
+inline Maskx8 operator|(const Maskx8& a, const Maskx8& b) { return Maskx8(a.m | b.m); }
+inline Maskx8 operator^(const Maskx8& a, const Maskx8& b) { return Maskx8(a.m ^ b.m); }
+inline Maskx8 operator!(const Maskx8& a) { return Maskx8(~a.m); }
+#endif
+
+// ---------------------------------------------------------------------------
+// Floatx8: eight floats
+
+struct Floatx8 {
+#if VEC3X8_AVX2
+    __m256 v;
+    Floatx8() = default;
+    Floatx8(float s) : v(_mm256_set1_ps(s)) {}
+    explicit Floatx8(__m256 x) : v(x) {}
+    static Floatx8 load(const float* p) { return Floatx8(_mm256_loadu_ps(p)); }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+    float operator[](int lane) const {
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, v);
+        return lanes[lane];
+    }
+#else
+    float v[8];
+    Floatx8() = default;
+    Floatx8(float s) { for (int i = 0; i < 8; ++i) v[i] = s; }
+    static Floatx8 load(const float* p) { Floatx8 r; for (int i = 0; i < 8; ++i) r.v[i] = p[i]; return r; }
+    void store(float* p) const { for (int i = 0; i < 8; ++i) p[i] = v[i]; }
+    float operator[](int lane) const { return v[lane]; }
+#endif
+};
+
+#if VEC3X8_AVX2
+inline Floatx8 operator+(const Floatx8& a, const Floatx8& b) { return Floatx8(_mm256_add_ps(a.v, b.v)); }
+inline Floatx8 operator-(const Floatx8& a, const Floatx8& b) { return Floatx8(_mm256_sub_ps(a.v, b.v)); }
+inline Floatx8 operator*(const Floatx8& a, const Floatx8& b) { return Floatx8(_mm256_mul_ps(a.v, b.v)); }
+inline Floatx8 operator/(const Floatx8& a, const Floatx8& b) { return Floatx8(_mm256_div_ps(a.v, b.v)); }
+inline Floatx8 operator-(const Floatx8& a) { return Floatx8(_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))); }
+
+// Ordered comparisons: false in lanes holding a NaN
+inline Maskx8 operator<(const Floatx8& a, const Floatx8& b) { return Maskx8(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+inline Maskx8 operator<=(const Floatx8& a, const Floatx8& b) { return Maskx8(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)); }
+inline Maskx8 operator>(const Floatx8& a, const Floatx8& b) { return Maskx8(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+inline Maskx8 operator>=(const Floatx8& a, const Floatx8& b) { return Maskx8(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+inline Maskx8 operator==(const Floatx8& a, const Floatx8& b) { return Maskx8(_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)); }
+
+// mask ? a : b per lane
+inline Floatx8 select(const Maskx8& mask, const Floatx8& a, const Floatx8& b) { return Floatx8(_mm256_blendv_ps(b.v, a.v, mask.m)); }
+// Like _mm256_min_ps / _mm256_max_ps: b when either lane is NaN
+inline Floatx8 min(const Floatx8& a, const Floatx8& b) { return Floatx8(_mm256_min_ps(a.v, b.v)); }
+inline Floatx8 max(const Floatx8& a, const Floatx8& b) { return Floatx8(_mm256_max_ps(a.v, b.v)); }
+inline Floatx8 abs(const Floatx8& a) { return Floatx8(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+inline Floatx8 sqrt(const Floatx8& a) { return Floatx8(_mm256_sqrt_ps(a.v)); }
+inline Floatx8 floor(const Floatx8& a) { return Floatx8(_mm256_floor_ps(a.v)); }
+// 1/sqrt(a), hardware estimate plus one Newton step (about 23 bits)
+inline Floatx8 rsqrt(const Floatx8& a) {
+    const __m256 estimate = _mm256_rsqrt_ps(a.v);
+    const __m256 half_a_e2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), a.v), _mm256_mul_ps(estimate, estimate));
+    return Floatx8(_mm256_mul_ps(estimate, _mm256_sub_ps(_mm256_set1_ps(1.5f), half_a_e2)));
+}
+// a * b + c
+inline Floatx8 fmadd(const Floatx8& a, const Floatx8& b, const Floatx8& c) {
+#if VEC3X8_FMA
+    return Floatx8(_mm256_fmadd_ps(a.v, b.v, c.v));
+#else
+    return Floatx8(_mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v));
+#endif
+}
+#else
+namespace vec3x8_detail {
+    template <typename Fn>
+    inline Floatx8 map(Fn fn) { Floatx8 r; for (int i = 0; i < 8; ++i) r.v[i] = fn(i); return r; }
+    template <typename Fn>
+    inline Maskx8 test(Fn fn) { int bits = 0; for (int i = 0; i < 8; ++i) bits |= fn(i) ? 1 << i : 0; return Maskx8(bits); }
+}
+inline Floatx8 operator+(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::map([&](int i) { return a.v[i] + b.v[i]; }); }
+inline Floatx8 operator-(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::map([&](int i) { return a.v[i] - b.v[i]; }); }
+inline Floatx8 operator*(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::map([&](int i) { return a.v[i] * b.v[i]; }); }
+inline Floatx8 operator/(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::map([&](int i) { return a.v[i] / b.v[i]; }); }
+inline Floatx8 operator-(const Floatx8& a) { return vec3x8_detail::map([&](int i) { return -a.v[i]; }); }
+
+inline Maskx8 operator<(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::test([&](int i) { return a.v[i] < b.v[i]; }); }
+inline Maskx8 operator<=(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::test([&](int i) { return a.v[i] <= b.v[i]; }); }
+inline Maskx8 operator>(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::test([&](int i) { return a.v[i] > b.v[i]; }); }
+inline Maskx8 operator>=(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::test([&](int i) { return a.v[i] >= b.v[i]; }); }
+inline Maskx8 operator==(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::test([&](int i) { return a.v[i] == b.v[i]; }); }
+
+inline Floatx8 select(const Maskx8& mask, const Floatx8& a, const Floatx8& b) { return vec3x8_detail::map([&](int i) { return mask[i] ? a.v[i] : b.v[i]; }); }
+inline Floatx8 min(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::map([&](int i) { return a.v[i] < b.v[i] ? a.v[i] : b.v[i]; }); }
+inline Floatx8 max(const Floatx8& a, const Floatx8& b) { return vec3x8_detail::map([&](int i) { return a.v[i] > b.v[i] ? a.v[i] : b.v[i]; }); }
+inline Floatx8 abs(const Floatx8& a) { return vec3x8_detail::map([&](int i) { return std::fabs(a.v[i]); }); }
+inline Floatx8 sqrt(const Floatx8& a) { return vec3x8_detail::map([&](int i) { return std::sqrt(a.v[i]); }); }
+inline Floatx8 floor(const Floatx8& a) { return vec3x8_detail::map([&](int i) { return std::floor(a.v[i]); }); }
+inline Floatx8 rsqrt(const Floatx8& a) { return vec3x8_detail::map([&](int i) { return 1.0f / std::sqrt(a.v[i]); }); }
+inline Floatx8 fmadd(const Floatx8& a, const Floatx8& b, const Floatx8& c) { return vec3x8_detail::map([&](int i) { return a.v[i] * b.v[i] + c.v[i]; }); }
+#endif
+
+inline Floatx8& operator+=(Floatx8& a, const Floatx8& b) { return a = a + b; }
+inline Floatx8& operator-=(Floatx8& a, const Floatx8& b) { return a = a - b; }
+inline Floatx8& operator*=(Floatx8& a, const Floatx8& b) { return a = a * b; }
+inline Floatx8 clamp(const Floatx8& a, const Floatx8& lo, const Floatx8& hi) { return min(max(a, lo), hi); }
+
+// ---------------------------------------------------------------------------
+// Intx8: eight 32-bit integers, for indices and bit tricks
+
+struct Intx8 {
+#if VEC3X8_AVX2
+    __m256i v;
+    Intx8() = default;
+    Intx8(int32_t s) : v(_mm256_set1_epi32(s)) {}
+    explicit Intx8(__m256i x) : v(x) {}
+    int32_t operator[](int lane) const {
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+        return lanes[lane];
+    }
+#else
+    int32_t v[8];
+    Intx8() = default;
+    Intx8(int32_t s) { for (int i = 0; i < 8; ++i) v[i] = s; }
+    int32_t operator[](int lane) const { return v[lane]; }
+#endif
+};
+
+#if VEC3X8_AVX2
+inline Intx8 operator+(const Intx8& a, const Intx8& b) { return Intx8(_mm256_add_epi32(a.v, b.v)); }
+inline Intx8 operator-(const Intx8& a, const Intx8& b) { return Intx8(_mm256_sub_epi32(a.v, b.v)); }
+inline Intx8 operator*(const Intx8& a, const Intx8& b) { return Intx8(_mm256_mullo_epi32(a.v, b.v)); }
+inline Intx8 operator&(const Intx8& a, const Intx8& b) { return Intx8(_mm256_and_si256(a.v, b.v)); }
+inline Intx8 operator|(const Intx8& a, const Intx8& b) { return Intx8(_mm256_or_si256(a.v, b.v)); }
+inline Intx8 shiftLeft(const Intx8& a, int bits) { return Intx8(_mm256_sll_epi32(a.v, _mm_cvtsi32_si128(bits))); }
+// Zero fill, like a shift of uint32_t
+inline Intx8 shiftRightLogical(const Intx8& a, int bits) { return Intx8(_mm256_srl_epi32(a.v, _mm_cvtsi32_si128(bits))); }
+inline Maskx8 operator==(const Intx8& a, const Intx8& b) { return Maskx8(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v))); }
+inline Intx8 min(const Intx8& a, const Intx8& b) { return Intx8(_mm256_min_epi32(a.v, b.v)); }
+inline Intx8 max(const Intx8& a, const Intx8& b) { return Intx8(_mm256_max_epi32(a.v, b.v)); }
+// Truncates toward zero, like static_cast<int>
+inline Intx8 toInt(const Floatx8& a) { return Intx8(_mm256_cvttps_epi32(a.v)); }
+inline Floatx8 toFloat(const Intx8& a) { return Floatx8(_mm256_cvtepi32_ps(a.v)); }
+// base[index] per lane
+inline Floatx8 gather(const float* base, const Intx8& index) { return Floatx8(_mm256_i32gather_ps(base, index.v, 4)); }
+// Same bits, other type
+inline Intx8 asInt(const Floatx8& a) { return Intx8(_mm256_castps_si256(a.v)); }
+inline Floatx8 asFloat(const Intx8& a) { return Floatx8(_mm256_castsi256_ps(a.v)); }
+#else
+namespace vec3x8_detail {
+    template <typename Fn>
+    inline Intx8 mapInt(Fn fn) { Intx8 r; for (int i = 0; i < 8; ++i) r.v[i] = fn(i); return r; }
+}
+inline Intx8 operator+(const Intx8& a, const Intx8& b) { return vec3x8_detail::mapInt([&](int i) { return a.v[i] + b.v[i]; }); }
+inline Intx8 operator-(const Intx8& a, const Intx8& b) { return vec3x8_detail::mapInt([&](int i) { return a.v[i] - b.v[i]; }); }
+inline Intx8 operator*(const Intx8& a, const Intx8& b) { return vec3x8_detail::mapInt([&](int i) { return a.v[i] * b.v[i]; }); }
+inline Intx8 operator&(const Intx8& a, const Intx8& b) { return vec3x8_detail::mapInt([&](int i) { return a.v[i] & b.v[i]; }); }
+inline Intx8 operator|(const Intx8& a, const Intx8& b) { return vec3x8_detail::mapInt([&](int i) { return a.v[i] | b.v[i]; }); }
+inline Intx8 shiftLeft(const Intx8& a, int bits) { return vec3x8_detail::mapInt([&](int i) { return static_cast<int32_t>(static_cast<uint32_t>(a.v[i]) << bits); }); }
+inline Intx8 shiftRightLogical(const Intx8& a, int bits) { return vec3x8_detail::mapInt([&](int i) { return static_cast<int32_t>(static_cast<uint32_t>(a.v[i]) >> bits); }); }
+inline Maskx8 operator==(const Intx8& a, const Intx8& b) { return vec3x8_detail::test([&](int i) { return a.v[i] == b.v[i]; }); }
+inline Intx8 min(const Intx8& a, const Intx8& b) { return vec3x8_detail::mapInt([&](int i) { return a.v[i] < b.v[i] ? a.v[i] : b.v[i]; }); }
+inline Intx8 max(const Intx8& a, const Intx8& b) { return vec3x8_detail::mapInt([&](int i) { return a.v[i] > b.v[i] ? a.v[i] : b.v[i]; }); }
+inline Intx8 toInt(const Floatx8& a) { return vec3x8_detail::mapInt([&](int i) { return static_cast<int32_t>(a.v[i]); }); }
+inline Floatx8 toFloat(const Intx8& a) { return vec3x8_detail::map([&](int i) { return static_cast<float>(a.v[i]); }); }
+inline Floatx8 gather(const float* base, const Intx8& index) { return vec3x8_detail::map([&](int i) { return base[index.v[i]]; }); }
+inline Intx8 asInt(const Floatx8& a) { Intx8 r; std::memcpy(r.v, a.v, sizeof(r.v)); return r; }
+inline Floatx8 asFloat(const Intx8& a) { Floatx8 r; std::memcpy(r.v, a.v, sizeof(r.v)); return r; }
+#endif
+
+// ---------------------------------------------------------------------------
+// Vec3x8: eight xyz vectors as three Floatx8
+
+struct Vec3x8 {
+    Floatx8 x, y, z;
+
+    Vec3x8() = default;
+    Vec3x8(const Floatx8& x_, const Floatx8& y_, const Floatx8& z_) : x(x_), y(y_), z(z_) {}
+    // The same vector in every lane
+    explicit Vec3x8(const Vec3& v) : x(static_cast<float>(v.x)), y(static_cast<float>(v.y)), z(static_cast<float>(v.z)) {}
+
+    static Vec3x8 load(const float* xs, const float* ys, const float* zs) { return Vec3x8(Floatx8::load(xs), Floatx8::load(ys), Floatx8::load(zs)); }
+    void store(float* xs, float* ys, float* zs) const { x.store(xs); y.store(ys); z.store(zs); }
+    Vec3 lane(int i) const { return Vec3(x[i], y[i], z[i]); }
+};
+
+inline Vec3x8 operator+(const Vec3x8& a, const Vec3x8& b) { return Vec3x8(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline Vec3x8 operator-(const Vec3x8& a, const Vec3x8& b) { return Vec3x8(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline Vec3x8 operator*(const Vec3x8& a, const Vec3x8& b) { return Vec3x8(a.x * b.x, a.y * b.y, a.z * b.z); }
+inline Vec3x8 operator*(const Vec3x8& a, const Floatx8& t) { return Vec3x8(a.x * t, a.y * t, a.z * t); }
+inline Vec3x8 operator*(const Floatx8& t, const Vec3x8& a) { return Vec3x8(a.x * t, a.y * t, a.z * t); }
+inline Vec3x8 operator/(const Vec3x8& a, const Floatx8& t) { return a * (Floatx8(1.0f) / t); }
+inline Vec3x8 operator-(const Vec3x8& a) { return Vec3x8(-a.x, -a.y, -a.z); }
+inline Vec3x8& operator+=(Vec3x8& a, const Vec3x8& b) { return a = a + b; }
+inline Vec3x8& operator*=(Vec3x8& a, const Floatx8& t) { return a = a * t; }
+
+inline Floatx8 dot(const Vec3x8& a, const Vec3x8& b) { return fmadd(a.x, b.x, fmadd(a.y, b.y, a.z * b.z)); }
+inline Vec3x8 cross(const Vec3x8& a, const Vec3x8& b) {
+    return Vec3x8(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+inline Floatx8 length_squared(const Vec3x8& a) { return dot(a, a); }
+inline Floatx8 length(const Vec3x8& a) { return sqrt(dot(a, a)); }
+inline Vec3x8 normalize(const Vec3x8& a) { return a * rsqrt(dot(a, a)); }
+inline Vec3x8 select(const Maskx8& mask, const Vec3x8& a, const Vec3x8& b) {
+    return Vec3x8(select(mask, a.x, b.x), select(mask, a.y, b.y), select(mask, a.z, b.z));
+}
+
+// ---------------------------------------------------------------------------
+// Rays and hit tests
+
+struct Rayx8 {
+    Vec3x8 origin, direction;
+    Vec3x8 inv_direction;   // 1 / direction per component, inf for axis-parallel rays
+
+    Rayx8() = default;
+    Rayx8(const Vec3x8& o, const Vec3x8& d)
+        : origin(o), direction(d), inv_direction(Floatx8(1.0f) / d.x, Floatx8(1.0f) / d.y, Floatx8(1.0f) / d.z) {}
+    Vec3x8 at(const Floatx8& t) const { return origin + direction * t; }
+};
+
+// Clips [t_near, t_far] to the slabs of the box [lo, hi] along each lane's ray. As in AABB::hit, a NaN
+// slab distance (axis-parallel ray starting on a slab plane) leaves the interval unchanged
+inline void clipToBox(const Vec3x8& origin, const Vec3x8& inv_direction, const Vec3x8& lo, const Vec3x8& hi, Floatx8& t_near, Floatx8& t_far) {
+    const Floatx8* o[3] = { &origin.x, &origin.y, &origin.z };
+    const Floatx8* inv[3] = { &inv_direction.x, &inv_direction.y, &inv_direction.z };
+    const Floatx8* l[3] = { &lo.x, &lo.y, &lo.z };
+    const Floatx8* h[3] = { &hi.x, &hi.y, &hi.z };
+    for (int a = 0; a < 3; ++a) {
+        const Floatx8 t0 = (*l[a] - *o[a]) * *inv[a];
+        const Floatx8 t1 = (*h[a] - *o[a]) * *inv[a];
+        const Maskx8 negative = *inv[a] < Floatx8(0.0f);
+        // max/min return their second operand for NaN, so NaN distances are dropped
+        t_near = max(select(negative, t1, t0), t_near);
+        t_far = min(select(negative, t0, t1), t_far);
+    }
+}
+
+// Lanes whose ray hits its box within [t_min, t_max]
+inline Maskx8 hitBox(const Rayx8& r, const Vec3x8& lo, const Vec3x8& hi, const Floatx8& t_min, const Floatx8& t_max) {
+    Floatx8 t_near = t_min, t_far = t_max;
+    clipToBox(r.origin, r.inv_direction, lo, hi, t_near, t_far);
+    return t_far >= t_near;
+}
+
+struct Hitx8 {
+    Floatx8 t, u, v;   // barycentric u, v as in Triangle::hit
+};
+
+// Moller-Trumbore, one triangle per lane. Unlike Triangle::intersect it is not watertight and
+// t is taken from the float vertices. Lanes that hit get their t, u and v written to hit; the
+// others keep theirs
+inline Maskx8 hitTriangle(const Rayx8& r, const Vec3x8& v0, const Vec3x8& v1, const Vec3x8& v2, const Floatx8& t_min, const Floatx8& t_max,
+    float epsilon, Hitx8& hit) {
+    const Vec3x8 edge1 = v1 - v0;
+    const Vec3x8 edge2 = v2 - v0;
+    const Vec3x8 h = cross(r.direction, edge2);
+    const Floatx8 a = dot(edge1, h);
+    Maskx8 valid = abs(a) >= Floatx8(epsilon);
+    const Floatx8 f = Floatx8(1.0f) / a;
+    const Vec3x8 s = r.origin - v0;
+    const Floatx8 u = f * dot(s, h);
+    valid = valid & (u >= Floatx8(0.0f)) & (u <= Floatx8(1.0f));
+    const Vec3x8 q = cross(s, edge1);
+    const Floatx8 v = f * dot(r.direction, q);
+    valid = valid & (v >= Floatx8(0.0f)) & (u + v <= Floatx8(1.0f));
+    const Floatx8 t = f * dot(edge2, q);
+    valid = valid & (t >= t_min) & (t <= t_max);
+    hit.t = select(valid, t, hit.t);
+    hit.u = select(valid, u, hit.u);
+    hit.v = select(valid, v, hit.v);
+    return valid;
+}
+
+// ---------------------------------------------------------------------------
+// Sampling
+
+// sin and cos with the Cephes single precision polynomials: about 1 ulp for |x| up to a few
+// thousand radians (the pi/4 reduction loses accuracy beyond that)
+inline void sincos(const Floatx8& x, Floatx8& s, Floatx8& c) {
+    const Floatx8 ax = abs(x);
+    // Octant j, rounded up to even, and x reduced to [-pi/4, pi/4] with a three-part pi/4
+    Intx8 j = toInt(ax * Floatx8(1.27323954473516f));
+    j = (j + Intx8(1)) & Intx8(~1);
+    const Floatx8 y = toFloat(j);
+    Floatx8 r = fmadd(y, Floatx8(-0.78515625f), ax);
+    r = fmadd(y, Floatx8(-2.4187564849853515625e-4f), r);
+    r = fmadd(y, Floatx8(-3.77489497744594108e-8f), r);
+    const Floatx8 z = r * r;
+
+    const Floatx8 sin_poly = fmadd(fmadd(fmadd(Floatx8(-1.9515295891e-4f), z, Floatx8(8.3321608736e-3f)), z, Floatx8(-1.6666654611e-1f)), z * r, r);
+    const Floatx8 cos_poly = fmadd(fmadd(fmadd(Floatx8(2.443315711809948e-5f), z, Floatx8(-1.388731625493765e-3f)), z, Floatx8(4.166664568298827e-2f)), z * z,
+        fmadd(Floatx8(-0.5f), z, Floatx8(1.0f)));
+
+    // Octants 2 and 6 (after rounding) swap the polynomials
+    const Maskx8 swap = (j & Intx8(2)) == Intx8(2);
+    const Floatx8 sin_value = select(swap, cos_poly, sin_poly);
+    const Floatx8 cos_value = select(swap, sin_poly, cos_poly);
+    const Maskx8 sin_negative = (x < Floatx8(0.0f)) ^ ((j & Intx8(4)) == Intx8(4));
+    const Maskx8 cos_negative = ((j + Intx8(2)) & Intx8(4)) == Intx8(4);
+    s = select(sin_negative, -sin_value, sin_value);
+    c = select(cos_negative, -cos_value, cos_value);
+}
+
+// Cosine-weighted direction around +z from two uniform numbers in [0, 1); pdf cos(theta) / pi
+inline Vec3x8 sampleCosineHemisphere(const Floatx8& u1, const Floatx8& u2) {
+    Floatx8 s, c;
+    sincos(Floatx8(6.28318530717958648f) * u1, s, c);
+    const Floatx8 radius = sqrt(u2);
+    return Vec3x8(radius * c, radius * s, sqrt(max(Floatx8(1.0f) - u2, Floatx8(0.0f))));
+}
+
+// local.x * t + local.y * b + local.z * n
+inline Vec3x8 fromLocal(const Vec3x8& local, const Vec3x8& t, const Vec3x8& b, const Vec3x8& n) {
+    return Vec3x8(fmadd(local.x, t.x, fmadd(local.y, b.x, local.z * n.x)),
+        fmadd(local.x, t.y, fmadd(local.y, b.y, local.z * n.y)),
+        fmadd(local.x, t.z, fmadd(local.y, b.z, local.z * n.z)));
+}
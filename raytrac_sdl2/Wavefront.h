@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Ray.h"
+#include "Vec3SIMD.h"
+
+// Structure-of-arrays work queues for the wavefront integrator.
+//
+// A wavefront batch keeps every live path of a group of rows in flat arrays
+// and moves them through the stages together: generate camera rays,
+// intersect, sort the hits by material, shade, trace the queued shadow rays.
+// Each stage is one tight loop, so the BVH, one material's scatter code and
+// the light loop stay hot in cache instead of alternating per path. Queues
+// are rebuilt every bounce and only live paths are pushed again, so they
+// stay compact.
+
+// Rays waiting to be intersected; path is the owning entry of PathStates.
+// Stored in single precision, half the footprint of Ray: spawned origins are
+// offset by more than the float rounding (see RayOffset.h).
+struct RayQueue {
+    std::vector<float> ox, oy, oz;
+    std::vector<float> dx, dy, dz;
+    std::vector<uint32_t> path;
+
+    size_t size() const { return path.size(); }
+    bool empty() const { return path.empty(); }
+    void clear() {
+        ox.clear(); oy.clear(); oz.clear();
+        dx.clear(); dy.clear(); dz.clear();
+        path.clear();
+    }
+    void push(const Vec3& origin, const Vec3& direction, uint32_t owner) {
+        ox.push_back(static_cast<float>(origin.x)); oy.push_back(static_cast<float>(origin.y)); oz.push_back(static_cast<float>(origin.z));
+        dx.push_back(static_cast<float>(direction.x)); dy.push_back(static_cast<float>(direction.y)); dz.push_back(static_cast<float>(direction.z));
+        path.push_back(owner);
+    }
+    Ray ray(size_t i) const { return Ray(Vec3(ox[i], oy[i], oz[i]), Vec3(dx[i], dy[i], dz[i])); }
+    void swap(RayQueue& other) {
+        ox.swap(other.ox); oy.swap(other.oy); oz.swap(other.oz);
+        dx.swap(other.dx); dy.swap(other.dy); dz.swap(other.dz);
+        path.swap(other.path);
+    }
+};
+
+// Shadow rays with the unoccluded contribution they add to their path.
+// primary marks shadow rays from the camera hit (they also feed the direct AOV).
+struct ShadowQueue {
+    RayQueue rays;
+    std::vector<float> distance;
+    std::vector<float> r, g, b;
+    std::vector<uint8_t> primary;
+
+    size_t size() const { return rays.size(); }
+    void clear() {
+        rays.clear();
+        distance.clear();
+        r.clear(); g.clear(); b.clear();
+        primary.clear();
+    }
+    void push(const Vec3& origin, const Vec3& direction, float max_distance, const Vec3SIMD& contribution, uint32_t owner, bool from_camera_hit) {
+        rays.push(origin, direction, owner);
+        distance.push_back(max_distance);
+        r.push_back(contribution.x()); g.push_back(contribution.y()); b.push_back(contribution.z());
+        primary.push_back(from_camera_hit ? 1 : 0);
+    }
+    Vec3SIMD contribution(size_t i) const { return Vec3SIMD(r[i], g[i], b[i]); }
+};
+
+// Throughput, gathered color and travelled distance of every path in the batch
+struct PathStates {
+    std::vector<float> throughput_r, throughput_g, throughput_b;
+    std::vector<float> color_r, color_g, color_b;
+    std::vector<float> distance;
+    std::vector<uint32_t> pixel;   // batch-local pixel index
+
+    size_t size() const { return pixel.size(); }
+    void reset(size_t count) {
+        throughput_r.assign(count, 1.0f); throughput_g.assign(count, 1.0f); throughput_b.assign(count, 1.0f);
+        color_r.assign(count, 0.0f); color_g.assign(count, 0.0f); color_b.assign(count, 0.0f);
+        distance.assign(count, 0.0f);
+        pixel.assign(count, 0);
+    }
+    Vec3SIMD throughput(size_t i) const { return Vec3SIMD(throughput_r[i], throughput_g[i], throughput_b[i]); }
+    void setThroughput(size_t i, const Vec3SIMD& t) { throughput_r[i] = t.x(); throughput_g[i] = t.y(); throughput_b[i] = t.z(); }
+    Vec3SIMD color(size_t i) const { return Vec3SIMD(color_r[i], color_g[i], color_b[i]); }
+    void addColor(size_t i, const Vec3SIMD& c) { color_r[i] += c.x(); color_g[i] += c.y(); color_b[i] += c.z(); }
+};